@@ -161,6 +161,21 @@
 */
 //#define WS_DATA_FEATURE
 
+/* Websocket compression
+* ESP32 only, permessage-deflate is negotiated with browsers
+* which support it, for terminal and data websockets
+*/
+//#define ESP_WS_DEFLATE_FEATURE
+
+/* Printer status channel
+* Temperatures, position and print progress are parsed from printer output
+* and changes are sent as binary frames on websocket port HTTP port + 2,
+* sub-protocol "esp3d-status"
+* ESP polls the printer for them and last values are available
+* with [ESP702] and /printerstate, without querying the printer
+*/
+//#define ESP_STATUS_CHANNEL_FEATURE
+
 // Enable notifications
 // Allows to send notifications to the user
 #define NOTIFICATION_FEATURE
@@ -563,6 +578,13 @@
 #define ESP_HOST_TIMEOUT 30000
 #define ESP_HOST_BUSY_TIMEOUT 5000
 #define MAX_TRY_2_SEND 5
+/* Sliding window
+* Number of numbered lines sent to printer without waiting for their ack
+* and max bytes in flight (printer serial RX buffer size - 1)
+* Resends are served from the window, 1 disables it
+*/
+//#define ESP_HOST_WINDOW_SIZE 4
+//#define ESP_HOST_WINDOW_RX_SIZE 127
 
 #define HOST_PAUSE_SCRIPT "SD/Scripts/Pause.gco"
 #define HOST_RESUME_SCRIPT "SD/Scripts/Resume.gco"
@@ -581,6 +603,12 @@
 */
 #define SERIAL_INDEPENDANT_TASK
 
+/* Add gcode host to serial task
+* ESP32 only, gcode host is handled with serial communication
+* so network activity cannot delay the printing stream
+*/
+//#define GCODE_HOST_INDEPENDANT_TASK
+
 
 
 /************************************
@@ -607,6 +635,9 @@
 //Enable benchmark report in dev console
 //#define ESP_BENCHMARK_FEATURE
 
+//Enable loop profiler: time spent in each service handle, see [ESP421]
+#define ESP_PROFILER_FEATURE
+
 //Disable sanity check at compilation
 //#define ESP_NO_SANITY_CHECK
 
@@ -29,6 +29,9 @@
 #if defined(GCODE_HOST_FEATURE)
 #include "../modules/gcode_host/gcode_host.h"
 #endif //GCODE_HOST_FEATURE
+#ifdef ESP_BENCHMARK_FEATURE
+#include "benchmark.h"
+#endif //ESP_BENCHMARK_FEATURE
 
 Commands esp3d_commands;
 
@@ -47,22 +50,37 @@ void Commands::process(uint8_t * sbuf, size_t len, ESP3DOutput * output, level_a
     log_esp3d("Client is %d, has only %d, has ignore %d", output?output->client():0, outputonly?outputonly->client():0, outputignore);
     if(is_esp_command(sbuf,len)) {
         lastIsESP3D = true;
-        size_t slen = len;
-        String tmpbuf = (const char*)sbuf;
-        if (tmpbuf.startsWith("echo:")) {
-            tmpbuf.replace("echo: ", "");
-            tmpbuf.replace("echo:", "");
-            slen = tmpbuf.length();
+#ifdef ESP_BENCHMARK_FEATURE
+        uint64_t bench_start = micros();
+#endif //ESP_BENCHMARK_FEATURE
+        //parse command id in place, no copy of the line is done
+        const char * line = (const char *)sbuf;
+        if (strncmp(line, "echo:", 5) == 0) {
+            line += 5;
+            if (line[0] == ' ') {
+                line++;
+            }
         }
-
-        uint8_t cmd[4]= {0,0,0,0};
-        cmd[0] = tmpbuf[4] == ']'?0:tmpbuf[4];
-        cmd[1] = tmpbuf[5] == ']'?0:tmpbuf[5];
-        cmd[2] = tmpbuf[6] == ']'?0:tmpbuf[6];
-        cmd[3] = 0x0;
-        log_esp3d("It is ESP command %s",cmd);
+        //line is now [ESPXXX]
+        const char * p = line + 4;
+        int cmd = 0;
+        bool isNumber = true;
+        for (uint8_t i = 0; (i < 3) && (p[0] != ']') && (p[0] != 0); i++, p++) {
+            if (isNumber && (p[0] >= '0') && (p[0] <= '9')) {
+                cmd = (cmd * 10) + (p[0] - '0');
+            } else {
+                isNumber = false;
+            }
+        }
+        if (p[0] == ']') {
+            p++;
+        }
+        log_esp3d("It is ESP command %d",cmd);
         log_esp3d("Respond to client  %d",(outputonly == nullptr)?output->client():outputonly->client());
-        execute_internal_command (String((const char*)cmd).toInt(), (slen > (strlen((const char *)cmd)+5))?(const char*)&tmpbuf[strlen((const char *)cmd)+5]:"", auth, (outputonly == nullptr)?output:outputonly);
+        execute_internal_command (cmd, p, auth, (outputonly == nullptr)?output:outputonly);
+#ifdef ESP_BENCHMARK_FEATURE
+        report_esp3d("[ESP%d] handled in %llu us", cmd, micros() - bench_start);
+#endif //ESP_BENCHMARK_FEATURE
     } else {
         //Work around to avoid to dispatch single \n to everyone as it is part of previous ESP3D command
         if (lastIsESP3D && len==1 && sbuf[0]=='\n') {
@@ -90,7 +108,9 @@ void Commands::process(uint8_t * sbuf, size_t len, ESP3DOutput * output, level_a
             log_esp3d("Dispatch from %d to only  %d", output->client(), outputonly->client());
 #if COMMUNICATION_PROTOCOL == MKS_SERIAL
             if (outputonly->client() == ESP_SERIAL_CLIENT) {
-                MKSService::sendGcodeFrame((const char *)sbuf);
+                if (!MKSService::sendGcodeFrame((const char *)sbuf)) {
+                    output->printERROR("Board busy, command not sent");
+                }
             } else {
                 outputonly->write(sbuf, len);
             }
@@ -156,48 +176,91 @@ int Commands::get_space_pos(const char * string, uint from)
     return  -1;
 }
 
+//get next parameter of command line, parameters are separated by space
+//if space is has \ before it is ignored
+//no copy is done: param points inside the command line and is not null terminated
+bool Commands::next_param(const char *& cursor, esp3d_param_t & param)
+{
+    while ((cursor[0] == ' ') || (cursor[0] == '\r') || (cursor[0] == '\n') || (cursor[0] == '\t')) {
+        cursor++;
+    }
+    if (cursor[0] == 0) {
+        return false;
+    }
+    param.str = cursor;
+    while ((cursor[0] != 0) && (cursor[0] != '\r') && (cursor[0] != '\n')) {
+        //first char cannot be a space so previous char always exists here
+        if ((cursor[0] == ' ') && (cursor[-1] != '\\')) {
+            break;
+        }
+        cursor++;
+    }
+    param.len = cursor - param.str;
+    return true;
+}
+
+//find first parameter starting with label and give its value (part after label)
+bool Commands::find_param(const char * cmd_params, const char * label, esp3d_param_t & value)
+{
+    size_t labellen = strlen(label);
+    const char * cursor = cmd_params;
+    esp3d_param_t param;
+    while (next_param(cursor, param)) {
+        if ((param.len >= labellen) && (strncmp(param.str, label, labellen) == 0)) {
+            value.str = param.str + labellen;
+            value.len = param.len - labellen;
+            return true;
+        }
+    }
+    return false;
+}
+
+//append parameter to string and remove space format
+static void append_param(String & res, const esp3d_param_t & param)
+{
+    for (size_t i = 0; i < param.len; i++) {
+        if ((param.str[i] == '\\') && ((i + 1) < param.len) && (param.str[i + 1] == ' ')) {
+            continue;
+        }
+        res += param.str[i];
+    }
+}
+
 //return first label but pwd using labelseparator (usualy =) like mylabel=myvalue will return mylabel
 const char* Commands::get_label (const char * cmd_params, const char * labelseparator, uint8_t startindex)
 {
     static String res;
-    String tmp = "";
     res = "";
-    int start = 1;
-    int end = -1;
-    res = cmd_params;
-    res.replace("\r ", "");
-    res.replace("\n ", "");
-    res.trim();
-    if ((res.length() == 0) || (startindex >=res.length())) {
+    size_t seplen = strlen(labelseparator);
+    if (startindex >= strlen(cmd_params)) {
+        return "";
+    }
+    if (seplen == 0) {
+        res = &cmd_params[startindex];
+        res.trim();
         return res.c_str();
     }
-
-    if (strlen(labelseparator) > 0) {
-        end = res.indexOf(labelseparator, startindex);
-        if (end == -1) {
-            return "";
-        }
-        start = end;
-        for (int8_t p = end; p >= startindex ; p--, start--) {
-            if (res[p]==' ') {
-                p = -1;
-                start+=2;
+    const char * cursor = &cmd_params[startindex];
+    esp3d_param_t param;
+    while (next_param(cursor, param)) {
+        for (size_t i = 0; (i + seplen) <= param.len; i++) {
+            if (strncmp(&param.str[i], labelseparator, seplen) == 0) {
+                if (i == 0) {
+                    return "";
+                }
+                //pwd is never a label
+                if ((i == 3) && (strncmp(param.str, "pwd", 3) == 0)) {
+                    break;
+                }
+                res.reserve(i);
+                for (size_t j = 0; j < i; j++) {
+                    res += param.str[j];
+                }
+                return res.c_str();
             }
         }
-        if(start==-1) {
-            start=0;
-        }
-        if (start > end) {
-            return "";
-        }
-        tmp = res.substring(start,end);
-        if (tmp == "pwd") {
-            res = get_label (cmd_params, labelseparator,end+1);
-        } else {
-            res = tmp;
-        }
     }
-    return res.c_str();
+    return "";
 }
 
 const char *  Commands::format_response(uint cmdID, bool isjson, bool isok, const char * message)
@@ -231,24 +294,36 @@ const char *  Commands::format_response(uint cmdID, bool isjson, bool isok, cons
 const char * Commands::clean_param (const char * cmd_params)
 {
     static String res;
-    res = cmd_params;
-    if (strlen(cmd_params) == 0) {
-        return "";
+    const char * start = cmd_params;
+    while ((start[0] != 0) && isspace(start[0])) {
+        start++;
+    }
+    const char * end = start + strlen(start);
+    while ((end > start) && isspace(end[-1])) {
+        end--;
+    }
+    size_t len = end - start;
+    if (len == 0) {
+        return cmd_params;
     }
-    String tmp = cmd_params;
-    tmp.trim();
-    if (tmp =="json" || tmp.startsWith("json ")) {
+    if (((len == 4) && (strncmp(start, "json", 4) == 0)) || (strncmp(start, "json ", 5) == 0)) {
         return "";
     }
-    if(tmp.indexOf("json=") != -1) {
-        //remove formating flag
-        res = tmp.substring(0,tmp.indexOf("json="));
-    } else {
-        if(tmp.endsWith(" json")) {
-            //remove formating flag
-            res = tmp.substring(0,tmp.length()-5);
+    //remove formating flag
+    const char * flag = strstr(start, "json=");
+    if (flag == nullptr) {
+        if ((len >= 5) && (strncmp(end - 5, " json", 5) == 0)) {
+            flag = end - 5;
+        } else {
+            //nothing to clean
+            return cmd_params;
         }
     }
+    res = "";
+    res.reserve(flag - start);
+    for (const char * p = start; p < flag; p++) {
+        res += p[0];
+    }
     return res.c_str();
 }
 
@@ -258,547 +333,438 @@ const char * Commands::get_param (const char * cmd_params, const char * label)
 {
     static String res;
     res = "";
-    int start = 1;
-    int end = -1;
-    String tmp = "";
-    String slabel = " ";
-    res = cmd_params;
-    res.replace("\r ", "");
-    res.replace("\n ", "");
-    res.trim();
-    if (res.length() == 0) {
-        return res.c_str();
-    }
-
-    tmp = " " + res;
-    slabel += label;
+    esp3d_param_t param;
     if (strlen(label) > 0) {
-        start = tmp.indexOf(slabel);
-        if (start == -1) {
-            return "";
+        if (find_param(cmd_params, label, param)) {
+            res.reserve(param.len);
+            append_param(res, param);
         }
-        start+=slabel.length();
-        end = get_space_pos(tmp.c_str(),start);
-    }
-    if (end == -1) {
-        end = tmp.length();
-    }
-    //extract parameter
-    res = tmp.substring (start, end);
-
+    } else {
+        const char * cursor = cmd_params;
+        const char * last = nullptr;
+        bool skipped = false;
+        res.reserve(strlen(cmd_params));
+        while (next_param(cursor, param)) {
 #ifdef AUTHENTICATION_FEATURE
-    //if no label remove authentication parameters
-    if (strlen(label) == 0) {
-
-        tmp = " " + res;
-        start = tmp.indexOf (" pwd=");
-        if (start != -1) {
-            end = get_space_pos(tmp.c_str(),start+1);
-            res = "";
-            if (start != 0) {
-                res = tmp.substring(0, start);
+            //remove authentication parameters
+            if ((param.len >= 4) && (strncmp(param.str, "pwd=", 4) == 0)) {
+                skipped = true;
+                continue;
             }
-            if (end != -1) {
-                res += " " + tmp.substring(end+1, tmp.length());
+#endif //AUTHENTICATION_FEATURE
+            if (last) {
+                if (skipped) {
+                    res += ' ';
+                } else {
+                    //keep original spacing between parameters
+                    for (const char * p = last; p < param.str; p++) {
+                        if (p[0] == ' ') {
+                            res += ' ';
+                        }
+                    }
+                }
             }
+            append_param(res, param);
+            last = param.str + param.len;
+            skipped = false;
         }
     }
-#endif //AUTHENTICATION_FEATURE
-    //remove space format
-    res.replace("\\ ", " ");
     //be sure no extra space
     res.trim();
     return res.c_str();
-
 }
 
 bool Commands::has_tag (const char * cmd_params, const char *tag)
 {
     log_esp3d("Checking for tag: %s, in %s", tag, cmd_params);
-    String tmp = "";
-    String stag = " ";
-    if ((strlen(cmd_params) == 0) || (strlen(tag) == 0)) {
+    size_t taglen = strlen(tag);
+    if ((strlen(cmd_params) == 0) || (taglen == 0)) {
         log_esp3d("No value provided for tag");
         return false;
     }
-    stag += tag;
-    tmp = cmd_params;
-    tmp.trim();
-    tmp = " " + tmp;
-    if (tmp.indexOf(stag) == -1) {
-        log_esp3d("No tag detected");
-        return false;
-    }
-    log_esp3d("Tag detected");
-    //to support plain , plain=yes , plain=no
-    String param =  String(tag) + "=";
-    log_esp3d("Checking  %s , in %s", param.c_str(), cmd_params);
-    String parameter = get_param (cmd_params, param.c_str());
-    if (parameter.length() != 0) {
-        log_esp3d("Parameter is %s", parameter.c_str());
-        if (parameter == "YES" ||parameter == "true" ||parameter == "TRUE" || parameter == "yes" || parameter == "1") {
-            return true;
+    bool found = false;
+    const char * cursor = cmd_params;
+    esp3d_param_t param;
+    while (next_param(cursor, param)) {
+        if ((param.len < taglen) || (strncmp(param.str, tag, taglen) != 0)) {
+            continue;
         }
-        log_esp3d("No parameter to enable  %s ", param.c_str());
+        found = true;
+        //to support plain , plain=yes , plain=no
+        if ((param.len > taglen) && (param.str[taglen] == '=')) {
+            const char * value = param.str + taglen + 1;
+            size_t len = param.len - taglen - 1;
+            if (len == 0) {
+                log_esp3d("No parameter for %s but tag detected", tag);
+                return true;
+            }
+            if (((len == 3) && ((strncmp(value, "YES", 3) == 0) || (strncmp(value, "yes", 3) == 0))) ||
+                    ((len == 4) && ((strncmp(value, "true", 4) == 0) || (strncmp(value, "TRUE", 4) == 0))) ||
+                    ((len == 1) && (value[0] == '1'))) {
+                return true;
+            }
+            log_esp3d("No parameter to enable  %s ", tag);
+            return false;
+        }
+    }
+    if (!found) {
+        log_esp3d("No tag detected");
         return false;
     }
-    log_esp3d("No parameter for %s but tag detected", param.c_str());
+    log_esp3d("No parameter for %s but tag detected", tag);
     return true;
 }
 
 
-//execute internal command
-bool Commands::execute_internal_command (int cmd, const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output)
-{
-#ifndef SERIAL_COMMAND_FEATURE
-    if (output->client() == ESP_SERIAL_CLIENT) {
-        output->printMSG("Feature disabled");
-        return false;
-    }
-#endif //SERIAL_COMMAND_FEATURE
-    bool response = true;
-    level_authenticate_type auth_type = auth_level;
-    //log_esp3d("Authentication = %d", auth_type);
-//override if parameters
-#ifdef AUTHENTICATION_FEATURE
-
-    //do not overwrite previous authetic <time=YYYY-MM-DD#H24:MM:SS>ation level
-    if (auth_type == LEVEL_GUEST) {
-        String pwd=get_param (cmd_params, "pwd=");
-        auth_type = AuthenticationService::authenticated_level(pwd.c_str(), output);
-    }
-#endif //AUTHENTICATION_FEATURE
-    //log_esp3d("Authentication = %d", auth_type);
-    String parameter;
-    switch (cmd) {
+//ESP commands table: id, minimum authentication level, handler
+//feature flags are applied at compile time
+//Note: table must be kept sorted by id as lookup is a binary search
+static const esp3d_command_t esp3d_commands_table[] = {
     //ESP3D Help
     //[ESP0] or [ESP]
-    case 0:
-        response = ESP0(cmd_params, auth_type, output);
-        break;
+    {0, LEVEL_GUEST, &Commands::ESP0},
 #if defined (WIFI_FEATURE)
     //STA SSID
     //[ESP100]<SSID>[pwd=<admin password>]
-    case 100:
-        response = ESP100(cmd_params, auth_type, output);
-        break;
+    {100, LEVEL_USER, &Commands::ESP100},
     //STA Password
     //[ESP101]<Password>[pwd=<admin password>]
-    case 101:
-        response = ESP101(cmd_params, auth_type, output);
-        break;
+    {101, LEVEL_ADMIN, &Commands::ESP101},
 #endif //WIFI_FEATURE
 #if defined (WIFI_FEATURE) || defined (ETH_FEATURE)
     //Change STA IP mode (DHCP/STATIC)
     //[ESP102]<mode>pwd=<admin password>
-    case 102:
-        response = ESP102(cmd_params, auth_type, output);
-        break;
+    {102, LEVEL_USER, &Commands::ESP102},
     //Change STA IP/Mask/GW
     //[ESP103]IP=<IP> MSK=<IP> GW=<IP> pwd=<admin password>
-    case 103:
-        response = ESP103(cmd_params, auth_type, output);
-        break;
-#endif //WIFI_FEATURE ||ETH_FEATURE
+    {103, LEVEL_USER, &Commands::ESP103},
+#endif //WIFI_FEATURE || ETH_FEATURE
 #if defined( WIFI_FEATURE) ||  defined( BLUETOOTH_FEATURE) || defined (ETH_FEATURE)
     //Set fallback mode which can be BT,  WIFI-AP, OFF
     //[ESP104]<state>pwd=<admin password>
-    case 104:
-        response = ESP104(cmd_params, auth_type, output);
-        break;
-#endif //WIFI_FEATURE || BLUETOOTH_FEATURE || ETH_FEATURE)
+    {104, LEVEL_USER, &Commands::ESP104},
+#endif //WIFI_FEATURE || BLUETOOTH_FEATURE || ETH_FEATURE
 #if defined (WIFI_FEATURE)
     //AP SSID
     //[ESP105]<SSID>[pwd=<admin password>]
-    case 105:
-        response = ESP105(cmd_params, auth_type, output);
-        break;
+    {105, LEVEL_USER, &Commands::ESP105},
     //AP Password
     //[ESP106]<Password>[pwd=<admin password>]
-    case 106:
-        response = ESP106(cmd_params, auth_type, output);
-        break;
+    {106, LEVEL_ADMIN, &Commands::ESP106},
     //Change AP IP
     //[ESP107]<IP> pwd=<admin password>
-    case 107:
-        response = ESP107(cmd_params, auth_type, output);
-        break;
+    {107, LEVEL_USER, &Commands::ESP107},
     //Change AP channel
     //[ESP108]<channel>pwd=<admin password>
-    case 108:
-        response = ESP108(cmd_params, auth_type, output);
-        break;
-#endif //WIFI_FEATURE    
-
+    {108, LEVEL_USER, &Commands::ESP108},
+#endif //WIFI_FEATURE
 #if defined( WIFI_FEATURE) ||  defined( BLUETOOTH_FEATURE) || defined (ETH_FEATURE)
     //Set radio state at boot which can be BT, WIFI-STA, WIFI-AP, ETH-STA, OFF
     //[ESP110]<state>pwd=<admin password>
-    case 110:
-        response = ESP110(cmd_params, auth_type, output);
-        break;
-#endif //WIFI_FEATURE || BLUETOOTH_FEATURE || ETH_FEATURE)
-
-#if defined(WIFI_FEATURE) || defined (ETH_FEATURE)
+    {110, LEVEL_USER, &Commands::ESP110},
+#endif //WIFI_FEATURE || BLUETOOTH_FEATURE || ETH_FEATURE
+#if defined (WIFI_FEATURE) || defined (ETH_FEATURE)
     //Get current IP
     //[ESP111]
-    case 111:
-        response = ESP111(cmd_params, auth_type, output);
-        break;
-#endif  //WIFI_FEATURE || ETH_FEATURE)
-
+    {111, LEVEL_GUEST, &Commands::ESP111},
+#endif //WIFI_FEATURE || ETH_FEATURE
 #if defined(WIFI_FEATURE) || defined(ETH_FEATURE) || defined(BT_FEATURE)
     //Get/Set hostname
     //[ESP112]<Hostname> pwd=<admin password>
-    case 112:
-        response = ESP112(cmd_params, auth_type, output);
-        break;
+    {112, LEVEL_USER, &Commands::ESP112},
     //Get/Set boot Network (WiFi/BT/Ethernet) state which can be ON, OFF
     //[ESP114]<state>pwd=<admin password>
-    case 114:
-        response = ESP114(cmd_params, auth_type, output);
-        break;
+    {114, LEVEL_USER, &Commands::ESP114},
     //Get/Set immediate Network (WiFi/BT/Ethernet) state which can be ON, OFF
     //[ESP115]<state>pwd=<admin password>
-    case 115:
-        response = ESP115(cmd_params, auth_type, output);
-        break;
-#endif //WIFI_FEATURE|| ETH_FEATURE || BT_FEATURE
-
-#ifdef HTTP_FEATURE
+    {115, LEVEL_USER, &Commands::ESP115},
+#endif //WIFI_FEATURE || ETH_FEATURE || BT_FEATURE
+#if defined(HTTP_FEATURE)
     //Set HTTP state which can be ON, OFF
     //[ESP120]<state>pwd=<admin password>
-    case 120:
-        response = ESP120(cmd_params, auth_type, output);
-        break;
+    {120, LEVEL_USER, &Commands::ESP120},
     //Set HTTP port
     //[ESP121]<port>pwd=<admin password>
-    case 121:
-        response = ESP121(cmd_params, auth_type, output);
-        break;
+    {121, LEVEL_USER, &Commands::ESP121},
 #endif //HTTP_FEATURE
-#ifdef TELNET_FEATURE
+#if defined(TELNET_FEATURE)
     //Set TELNET state which can be ON, OFF
     //[ESP130]<state>pwd=<admin password>
-    case 130:
-        response = ESP130(cmd_params, auth_type, output);
-        break;
+    {130, LEVEL_USER, &Commands::ESP130},
     //Set TELNET port
     //[ESP131]<port>pwd=<admin password>
-    case 131:
-        response = ESP131(cmd_params, auth_type, output);
-        break;
+    {131, LEVEL_USER, &Commands::ESP131},
 #endif //TELNET_FEATURE
-#ifdef TIMESTAMP_FEATURE
+#if defined(TIMESTAMP_FEATURE)
     //Sync / Set / Get current time
     //[ESP140]<SYNC>  <srv1=XXXXX> <srv2=XXXXX> <srv3=XXXXX> <zone=xxx> <dst=YES/NO> <time=YYYY-MM-DD#H24:MM:SS> pwd=<admin password>
-    case 140:
-        response = ESP140(cmd_params, auth_type, output);
-        break;
+    {140, LEVEL_USER, &Commands::ESP140},
 #endif //TIMESTAMP_FEATURE
     //Get/Set display/set boot delay in ms / Verbose boot
     //[ESP150]<delay=time in milliseconds><verbose=YES/NO>[pwd=<admin password>]
-    case 150:
-        response = ESP150(cmd_params, auth_type, output);
-        break;
-#ifdef WS_DATA_FEATURE
+    {150, LEVEL_USER, &Commands::ESP150},
+#if defined(WS_DATA_FEATURE)
     //Set WebSocket state which can be ON, OFF
     //[ESP160]<state>pwd=<admin password>
-    case 160:
-        response = ESP160(cmd_params, auth_type, output);
-        break;
+    {160, LEVEL_USER, &Commands::ESP160},
     //Set WebSocket port
     //[ESP161]<port>pwd=<admin password>
-    case 161:
-        response = ESP161(cmd_params, auth_type, output);
-        break;
+    {161, LEVEL_USER, &Commands::ESP161},
 #endif //WS_DATA_FEATURE
-#ifdef CAMERA_DEVICE
+#if defined(CAMERA_DEVICE)
     //Get/Set Camera command value / list all values in JSON/plain
     //[ESP170]label=<value> pwd=<admin/user password>
     //label can be: light/framesize/quality/contrast/brightness/saturation/gainceiling/colorbar/awb/agc/aec/hmirror/vflip/awb_gain/agc_gain/aec_value/aec2/cw/bpc/wpc/raw_gma/lenc/special_effect/wb_mode/ae_level
-    case 170:
-        response = ESP170(cmd_params, auth_type, output);
-        break;
+    {170, LEVEL_USER, &Commands::ESP170},
     //Save frame to target path and filename (default target = today date, default name=timestamp.jpg)
     //[ESP171]path=<target path> filename=<target filename> pwd=<admin/user password>
-    case 171:
-        response = ESP171(cmd_params, auth_type, output);
-        break;
+    {171, LEVEL_USER, &Commands::ESP171},
 #endif //CAMERA_DEVICE
-#ifdef FTP_FEATURE
+#if defined(FTP_FEATURE)
     //Set Ftp state which can be ON, OFF
     //[ESP180]<state>pwd=<admin password>
-    case 180:
-        response = ESP180(cmd_params, auth_type, output);
-        break;
+    {180, LEVEL_USER, &Commands::ESP180},
     //Set/get ftp ports
     //[ESP181]ctrl=<port> active=<port> passive=<port> pwd=<admin password>
-    case 181:
-        response = ESP181(cmd_params, auth_type, output);
-        break;
+    {181, LEVEL_USER, &Commands::ESP181},
 #endif //FTP_FEATURE
-#ifdef WEBDAV_FEATURE
+#if defined(WEBDAV_FEATURE)
     //Set webdav state which can be ON, OFF
     //[ESP190]<state>pwd=<admin password>
-    case 190:
-        response = ESP190(cmd_params, auth_type, output);
-        break;
+    {190, LEVEL_USER, &Commands::ESP190},
     //Set/get webdav port
     //[ESP191]ctrl=<port> active=<port> passive=<port> pwd=<admin password>
-    case 191:
-        response = ESP191(cmd_params, auth_type, output);
-        break;
+    {191, LEVEL_USER, &Commands::ESP191},
 #endif //WEBDAV_FEATURE
 #if defined (SD_DEVICE)
     //Get/Set SD Card Status
     //[ESP200] json=<YES/NO> <RELEASESD> <REFRESH> pwd=<user/admin password>
-    case 200:
-        response = ESP200(cmd_params, auth_type, output);
-        break;
-#if  SD_DEVICE != ESP_SDIO
-    //Get/Set SD card Speed factor 1 2 4 6 8 16 32
-    //[ESP202]SPEED=<value>pwd=<user/admin password>
-    case 202:
-        response = ESP202(cmd_params, auth_type, output);
-        break;
-#endif //SD_DEVICE != ESP_SDIO
-#ifdef SD_UPDATE_FEATURE
-    //Get/Set SD Check at boot state which can be ON, OFF
-    //[ESP402]<state>pwd=<admin password>
-    case 402:
-        response = ESP402(cmd_params, auth_type, output);
-        break;
-#endif //#ifdef SD_UPDATE_FEATURE
+    {200, LEVEL_USER, &Commands::ESP200},
 #endif //SD_DEVICE
-#ifdef DIRECT_PIN_FEATURE
+#if defined(DIRECT_PIN_FEATURE)
     //Get/Set pin value
     //[ESP201]P<pin> V<value> [PULLUP=YES RAW=YES]pwd=<admin password>
-    case 201:
-        response = ESP201(cmd_params, auth_type, output);
-        break;
+    {201, LEVEL_USER, &Commands::ESP201},
 #endif //DIRECT_PIN_FEATURE
-#ifdef SENSOR_DEVICE
+#if defined (SD_DEVICE) && SD_DEVICE != ESP_SDIO
+    //Get/Set SD card Speed factor 1 2 4 6 8 16 32
+    //[ESP202]SPEED=<value>pwd=<user/admin password>
+    {202, LEVEL_USER, &Commands::ESP202},
+#endif //SD_DEVICE && SD_DEVICE != ESP_SDIO
+#if defined(SENSOR_DEVICE)
     //Get SENSOR Value / type/Set SENSOR type
     //[ESP210] <TYPE> <type=NONE/xxx> <interval=XXX in millisec>
-    case 210:
-        response = ESP210(cmd_params, auth_type, output);
-        break;
-#endif //#ifdef SENSOR_DEVICE
+    {210, LEVEL_USER, &Commands::ESP210},
+#endif //SENSOR_DEVICE
 #if defined (DISPLAY_DEVICE)
     //Output to esp screen status
     //[ESP214]<Text>pwd=<user password>
-    case 214:
-        response = ESP214(cmd_params, auth_type, output);
-        break;
-#if defined(DISPLAY_TOUCH_DRIVER)
+    {214, LEVEL_USER, &Commands::ESP214},
+#endif //DISPLAY_DEVICE
+#if defined (DISPLAY_DEVICE) && defined(DISPLAY_TOUCH_DRIVER)
     //Touch Calibration
     //[ESP215]<CALIBRATE>[pwd=<user password>]
-    case 215:
-        response = ESP215(cmd_params, auth_type, output);
-        break;
-#endif //DISPLAY_TOUCH_DRIVER
-#ifdef BUZZER_DEVICE
-    //Play sound
-    //[ESP250]F=<frequency> D=<duration> [pwd=<user password>]
-    case 250:
-        response = ESP250(cmd_params, auth_type, output);
-        break;
-#endif //BUZZER_DEVICE
-#endif //DISPLAY_DEVICE
+    {215, LEVEL_USER, &Commands::ESP215},
+#endif //DISPLAY_DEVICE && DISPLAY_TOUCH_DRIVER
     //Show pins
     //[ESP220][pwd=<user password>]
-    case 220:
-        response = ESP220(cmd_params, auth_type, output);
-        break;
+    {220, LEVEL_USER, &Commands::ESP220},
+#if defined (DISPLAY_DEVICE) && defined(BUZZER_DEVICE)
+    //Play sound
+    //[ESP250]F=<frequency> D=<duration> [pwd=<user password>]
+    {250, LEVEL_USER, &Commands::ESP250},
+#endif //DISPLAY_DEVICE && BUZZER_DEVICE
     //Delay command
     //[ESP290]<delay in ms>[pwd=<user password>]
-    case 290:
-        response = ESP290(cmd_params, auth_type, output);
-        break;
+    {290, LEVEL_USER, &Commands::ESP290},
     //Get full ESP3D settings
     //[ESP400]<pwd=admin>
-    case 400:
-        response = ESP400(cmd_params, auth_type, output);
-        break;
+    {400, LEVEL_ADMIN, &Commands::ESP400},
     //Set EEPROM setting
     //[ESP401]P=<position> T=<type> V=<value> pwd=<user/admin password>
-    case 401:
-        response = ESP401(cmd_params, auth_type, output);
-        break;
+    {401, LEVEL_ADMIN, &Commands::ESP401},
+#if defined (SD_DEVICE) && defined(SD_UPDATE_FEATURE)
+    //Get/Set SD Check at boot state which can be ON, OFF
+    //[ESP402]<state>pwd=<admin password>
+    {402, LEVEL_USER, &Commands::ESP402},
+#endif //SD_DEVICE && SD_UPDATE_FEATURE
 #if defined (WIFI_FEATURE)
     //Get available AP list (limited to 30)
     //output is JSON or plain text according parameter
     //[ESP410]<plain>
-    case 410:
-        response = ESP410(cmd_params, auth_type, output);
-        break;
-#endif //WIFI_FEATURE    
+    {410, LEVEL_USER, &Commands::ESP410},
+#endif //WIFI_FEATURE
     //Get ESP current status
     //output is JSON or plain text according parameter
     //[ESP420]<plain>
-    case 420:
-        response = ESP420(cmd_params, auth_type, output);
-        break;
+    {420, LEVEL_USER, &Commands::ESP420},
+#if defined (ESP_PROFILER_FEATURE)
+    //Get time spent in each service of main loop
+    //cmd can be RESET to clear statistics
+    //[ESP421]<cmd>
+    {421, LEVEL_USER, &Commands::ESP421},
+#endif //ESP_PROFILER_FEATURE
     //Set ESP State
     //cmd are RESTART / RESET
     //[ESP444]<cmd><pwd=admin>
-    case 444:
-        response = ESP444(cmd_params, auth_type, output);
-        break;
-#ifdef MDNS_FEATURE
+    {444, LEVEL_ADMIN, &Commands::ESP444},
+#if defined(MDNS_FEATURE)
     //Get ESP3D list
     //[ESP450] pwd=<admin/user password>
-    case 450:
-        response = ESP450(cmd_params, auth_type, output);
-        break;
+    {450, LEVEL_USER, &Commands::ESP450},
 #endif //MDNS_FEATURE
-#ifdef AUTHENTICATION_FEATURE
+#if defined (AUTHENTICATION_FEATURE)
     //Change admin password
     //[ESP550]<password>pwd=<admin password>
-    case 550:
-        response = ESP550(cmd_params, auth_type, output);
-        break;
+    {550, LEVEL_ADMIN, &Commands::ESP550},
     //Change user password
     //[ESP555]<password>pwd=<admin/user password>
-    case 555:
-        response = ESP555(cmd_params, auth_type, output);
-        break;
-#endif  //AUTHENTICATION_FEATURE
+    {555, LEVEL_USER, &Commands::ESP555},
+#endif //AUTHENTICATION_FEATURE
 #if defined(NOTIFICATION_FEATURE)
     //Send Notification
     //[ESP600]<msg>[pwd=<admin password>]
-    case 600:
-        response = ESP600(cmd_params, auth_type, output);
-        break;
+    {600, LEVEL_USER, &Commands::ESP600},
     //Set/Get Notification settings
     //[ESP610]type=<NONE/PUSHOVER/EMAIL/LINE> T1=<token1> T2=<token2> TS=<Settings> [pwd=<admin password>]
     //Get will give type and settings only not the protected T1/T2
-    case 610:
-        response = ESP610(cmd_params, auth_type, output);
-        break;
+    {610, LEVEL_USER, &Commands::ESP610},
     //Send Notification using URL
     //[ESP620]URL=<encoded url> [pwd=<admin password>]
-    case 620:
-        response = ESP620(cmd_params, auth_type, output);
-        break;
+    {620, LEVEL_USER, &Commands::ESP620},
 #endif //NOTIFICATION_FEATURE
+#if defined(GCODE_HOST_FEATURE)
+    //Open local file
+    //[ESP700]<filename>
+    {700, LEVEL_ADMIN, &Commands::ESP700},
+    //Get Status and Control ESP700 stream
+    //[ESP701]action=<PAUSE/RESUME/ABORT>
+    {701, LEVEL_ADMIN, &Commands::ESP701},
+#endif //GCODE_HOST_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    //Get last printer state known by ESP
+    //[ESP702]<POLL=<ms>>
+    {702, LEVEL_USER, &Commands::ESP702},
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #if defined(FILESYSTEM_FEATURE)
     //Format ESP Filesystem
     //[ESP710]FORMAT pwd=<admin password>
-    case 710:
-        response = ESP710(cmd_params, auth_type, output);
-        break;
+    {710, LEVEL_ADMIN, &Commands::ESP710},
+#endif //FILESYSTEM_FEATURE
+#if defined(SD_DEVICE)
+    //Format ESP Filesystem
+    //[ESP715]FORMATSD pwd=<admin password>
+    {715, LEVEL_ADMIN, &Commands::ESP715},
+#endif //SD_DEVICE
+#if defined(FILESYSTEM_FEATURE)
     //List ESP Filesystem
     //[ESP720]<Root> pwd=<admin password>
-    case 720:
-        response = ESP720(cmd_params, auth_type, output);
-        break;
+    {720, LEVEL_ADMIN, &Commands::ESP720},
     //Action on ESP Filesystem
     //rmdir / remove / mkdir / exists
     //[ESP730]<Action>=<path> pwd=<admin password>
-    case 730:
-        response = ESP730(cmd_params, auth_type, output);
-        break;
-#endif //FILESYSTEM_FEATURE 
-#if defined(SD_DEVICE)
-    //Format ESP Filesystem
-    //[ESP715]FORMATSD pwd=<admin password>
-    case 715:
-        response = ESP715(cmd_params, auth_type, output);
-        break;
-#endif //SD_DEVICE 
-#if defined(GCODE_HOST_FEATURE)
-    //Open local file
-    //[ESP700]<filename>
-    case 700:
-        response = ESP700(cmd_params, auth_type, output);
-        break;
-    //Get Status and Control ESP700 stream
-    //[ESP701]action=<PAUSE/RESUME/ABORT>
-    case 701:
-        response = ESP701(cmd_params, auth_type, output);
-        break;
-#endif //GCODE_HOST_FEATURE
+    {730, LEVEL_ADMIN, &Commands::ESP730},
+#endif //FILESYSTEM_FEATURE
 #if defined (SD_DEVICE)
     //List SD Filesystem
     //[ESP740]<Root> pwd=<admin password>
-    case 740:
-        response = ESP740(cmd_params, auth_type, output);
-        break;
+    {740, LEVEL_ADMIN, &Commands::ESP740},
     //Action on SD Filesystem
     //rmdir / remove / mkdir / exists
     //[ESP750]<Action>=<path> pwd=<admin password>
-    case 750:
-        response = ESP750(cmd_params, auth_type, output);
-        break;
+    {750, LEVEL_ADMIN, &Commands::ESP750},
 #endif //SD_DEVICE
 #if defined (GLOBAL_FILESYSTEM_FEATURE)
     //List Global Filesystem
     //[ESP780]<Root> pwd=<admin password>
-    case 780:
-        response = ESP780(cmd_params, auth_type, output);
-        break;
+    {780, LEVEL_ADMIN, &Commands::ESP780},
     //Action on Global Filesystem
     //rmdir / remove / mkdir / exists
     //[ESP790]<Action>=<path> pwd=<admin password>
-    case 790:
-        response = ESP790(cmd_params, auth_type, output);
-        break;
+    {790, LEVEL_ADMIN, &Commands::ESP790},
 #endif //GLOBAL_FILESYSTEM_FEATURE
     //Get fw version firmare target and fw version
     //eventually set time with pc time
     //output is JSON or plain text according parameter
     //[ESP800]<plain><time=YYYY-MM-DD-HH-MM-SS>
-    case 800:
-        response = ESP800(cmd_params, auth_type, output);
-        break;
-
+    {800, LEVEL_USER, &Commands::ESP800},
 #if COMMUNICATION_PROTOCOL != SOCKET_SERIAL
     //Get state / Set Enable / Disable Serial Communication
     //[ESP900]<ENABLE/DISABLE>
-    case 900:
-        response = ESP900(cmd_params, auth_type, output);
-        break;
+    {900, LEVEL_USER, &Commands::ESP900},
     //Get / Set Serial Baud Rate
     //[ESP901]<BAUD RATE> json=<no> pwd=<admin/user password>
-    case 901:
-        response = ESP901(cmd_params, auth_type, output);
-        break;
+    {901, LEVEL_USER, &Commands::ESP901},
 #endif //COMMUNICATION_PROTOCOL != SOCKET_SERIAL
-#ifdef BUZZER_DEVICE
+#if defined(BUZZER_DEVICE)
     //Get state / Set Enable / Disable buzzer
     //[ESP910]<ENABLE/DISABLE>
-    case 910:
-        response = ESP910(cmd_params, auth_type, output);
-        break;
+    {910, LEVEL_USER, &Commands::ESP910},
 #endif //BUZZER_DEVICE
-    case 920:
-        //Get state / Set state of output message clients
-        //[ESP910]<SERIAL / SCREEN / REMOTE_SCREEN/ WEBSOCKET / TELNET /BT / ALL>=<ON/OFF>[pwd=<admin password>]
-        response = ESP920(cmd_params, auth_type, output);
-        break;
+    //Get state / Set state of output message clients
+    //[ESP920]<SERIAL / SCREEN / REMOTE_SCREEN/ WEBSOCKET / TELNET /BT / ALL>=<ON/OFF>[pwd=<admin password>]
+    {920, LEVEL_USER, &Commands::ESP920},
 #if defined(ESP_SERIAL_BRIDGE_OUTPUT)
     //Get state / Set Enable / Disable Serial Bridge Communication
     //[ESP930]<ENABLE/DISABLE>
-    case 930:
-        response = ESP930(cmd_params, auth_type, output);
-        break;
+    {930, LEVEL_USER, &Commands::ESP930},
     //Get / Set Serial Bridge Baud Rate
     //[ESP931]<BAUD RATE> json=<no> pwd=<admin/user password>
-    case 931:
-        response = ESP931(cmd_params, auth_type, output);
-        break;
-#endif //defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    {931, LEVEL_USER, &Commands::ESP931},
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
 #if defined(ARDUINO_ARCH_ESP32) && (CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32C3)
-    case 999:
-        //Set quiet boot if strapping pin is High
-        //[ESP999]<QUIETBOOT> [pwd=<admin/user password>]
-        response = ESP999(cmd_params, auth_type, output);
-        break;
+    //Set quiet boot if strapping pin is High
+    //[ESP999]<QUIETBOOT> [pwd=<admin/user password>]
+    {999, LEVEL_USER, &Commands::ESP999},
 #endif //ARDUINO_ARCH_ESP32
-    default:
+};
+
+//find command handler in table
+static const esp3d_command_t * find_command(int cmd)
+{
+    size_t low = 0;
+    size_t high = sizeof(esp3d_commands_table) / sizeof(esp3d_command_t);
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (esp3d_commands_table[mid].id == cmd) {
+            return &esp3d_commands_table[mid];
+        }
+        if (esp3d_commands_table[mid].id < cmd) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+//execute internal command
+bool Commands::execute_internal_command (int cmd, const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output)
+{
+#ifndef SERIAL_COMMAND_FEATURE
+    if (output->client() == ESP_SERIAL_CLIENT) {
+        output->printMSG("Feature disabled");
+        return false;
+    }
+#endif //SERIAL_COMMAND_FEATURE
+    const esp3d_command_t * command = find_command(cmd);
+    if (command == nullptr) {
         output->printERROR ("Invalid Command");
-        response = false;
+        return false;
+    }
+    level_authenticate_type auth_type = auth_level;
+//override if parameters
+#ifdef AUTHENTICATION_FEATURE
+
+    //do not overwrite previous authentication level
+    if (auth_type == LEVEL_GUEST) {
+        String pwd=get_param (cmd_params, "pwd=");
+        auth_type = AuthenticationService::authenticated_level(pwd.c_str(), output);
     }
-    return response;
+    if (auth_type < command->level) {
+        output->printERROR(format_response(cmd, has_tag (cmd_params, "json"), false, (command->level == LEVEL_ADMIN)?"Wrong authentication level":"Guest user can't use this command"), 401);
+        return false;
+    }
+#endif //AUTHENTICATION_FEATURE
+    return (this->*(command->handler))(cmd_params, auth_type, output);
 }
@@ -23,6 +23,21 @@
 #include <Arduino.h>
 #include "../modules/authentication/authentication_service.h"
 class ESP3DOutput;
+class Commands;
+
+//command line parameter, points inside the command line (no copy), not null terminated
+typedef struct {
+    const char * str;
+    size_t len;
+} esp3d_param_t;
+
+typedef bool (Commands::*esp3d_command_handler_t)(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
+
+typedef struct {
+    int id;
+    level_authenticate_type level;
+    esp3d_command_handler_t handler;
+} esp3d_command_t;
 
 class Commands
 {
@@ -33,6 +48,8 @@ public:
     bool is_esp_command(uint8_t * sbuf, size_t len);
     bool execute_internal_command(int cmd, const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
     int get_space_pos(const char * string, uint from = 0);
+    bool next_param(const char *& cursor, esp3d_param_t & param);
+    bool find_param(const char * cmd_params, const char * label, esp3d_param_t & value);
     const char* get_param (const char * cmd_params, const char * label);
     const char* get_label (const char * cmd_params, const char * labelseparator, uint8_t startindex = 0);
     const char * clean_param (const char * cmd_params);
@@ -124,6 +141,9 @@ public:
     bool ESP410(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
 #endif //WIFI_FEATURE
     bool ESP420(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
+#if defined (ESP_PROFILER_FEATURE)
+    bool ESP421(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
+#endif //ESP_PROFILER_FEATURE
     bool ESP444(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
 #ifdef MDNS_FEATURE
     bool ESP450(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
@@ -141,6 +161,9 @@ public:
     bool ESP700(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
     bool ESP701(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
 #endif //GCODE_HOST_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    bool ESP702(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #if defined(FILESYSTEM_FEATURE)
     bool ESP710(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
     bool ESP720(const char* cmd_params, level_authenticate_type auth_level, ESP3DOutput * output);
@@ -55,6 +55,7 @@
 #include "../modules/update/update_service.h"
 #endif // SD_UPDATE_FEATURE
 #include "esp3doutput.h"
+#include "profiler.h"
 #include "../modules/boot_delay/boot_delay.h"
 
 
@@ -166,24 +167,33 @@ void Esp3D::handle()
     if (restart) {
         restart_now();
     }
+#if defined(ESP_PROFILER_FEATURE)
+    uint32_t loop_start = micros();
+#endif //ESP_PROFILER_FEATURE
 #if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
-    serial_service.handle();
+    PROFILE_HANDLE(PROFILE_SERIAL, serial_service.handle());
 #endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
 #if defined(ESP_SERIAL_BRIDGE_OUTPUT)
-    serial_bridge_service.handle();
+    PROFILE_HANDLE(PROFILE_SERIAL_BRIDGE, serial_bridge_service.handle());
 #endif //ESP_SERIAL_BRIDGE_OUTPUT
 #if COMMUNICATION_PROTOCOL ==SOCKET_SERIAL
-    Serial2Socket.handle();
+    PROFILE_HANDLE(PROFILE_SOCKET_SERIAL, Serial2Socket.handle());
 #endif //COMMUNICATION_PROTOCOL == SOCKET_SERIAL 
 #if defined(WIFI_FEATURE) || defined(ETH_FEATURE)
-    NetConfig::handle();
+    //include network services time
+    PROFILE_HANDLE(PROFILE_NETWORK, NetConfig::handle());
 #endif //WIFI_FEATURE || ETH_FEATURE
 #if defined(CONNECTED_DEVICES_FEATURE)
-    DevicesServices::handle();
+    PROFILE_HANDLE(PROFILE_DEVICES, DevicesServices::handle());
 #endif //CONNECTED_DEVICES_FEATURE
-#if defined(GCODE_HOST_FEATURE)
-    esp3d_gcode_host.handle();
-#endif //GCODE_HOST_FEATURE
+#if defined(GCODE_HOST_FEATURE) && !defined(ESP_HOST_TASK)
+    PROFILE_HANDLE(PROFILE_GCODE_HOST, esp3d_gcode_host.handle());
+#endif //GCODE_HOST_FEATURE && !ESP_HOST_TASK
+    PROFILE_HANDLE(PROFILE_OUTPUT, ESP3DOutput::handle());
+    PROFILE_HANDLE(PROFILE_SETTINGS, Settings_ESP3D::handle());
+#if defined(ESP_PROFILER_FEATURE)
+    LoopProfiler::record(PROFILE_LOOP, micros() - loop_start);
+#endif //ESP_PROFILER_FEATURE
 }
 
 bool Esp3D::started()
@@ -195,6 +205,7 @@ bool Esp3D::started()
 bool Esp3D::end()
 {
     _started = false;
+    Settings_ESP3D::commit();
 #if defined(CONNECTED_DEVICES_FEATURE)
     DevicesServices::end();
 #endif //CONNECTED_DEVICES_FEATURE
@@ -249,6 +260,8 @@ void Esp3D::restart_now()
     digitalWrite(ESP3D_ETH_PHY_POWER_PIN, LOW);
 #endif //ESP3D_ETH_PHY_POWER_PIN
     log_esp3d("Restarting");
+    //do not lose modified settings
+    Settings_ESP3D::commit();
 #if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
     if (!serial_service.started()) {
         serial_service.begin(ESP_SERIAL_OUTPUT);
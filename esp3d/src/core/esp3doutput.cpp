@@ -42,6 +42,9 @@
 #if defined(GCODE_HOST_FEATURE)
 #include "../modules/gcode_host/gcode_host.h"
 #endif //GCODE_HOST_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+#include "../modules/printer_status/printer_status.h"
+#endif //ESP_STATUS_CHANNEL_FEATURE
 
 #if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL || COMMUNICATION_PROTOCOL == SOCKET_SERIAL
 uint8_t ESP3DOutput::_serialoutputflags = DEFAULT_SERIAL_OUTPUT_FLAG;
@@ -108,6 +111,364 @@ const uint8_t activeClients [] = {
     ESP_NO_CLIENT
 };
 
+//clients served by the shared output ring, each one has its own read cursor
+typedef struct {
+    uint8_t client;
+    uint32_t cursor;
+    uint16_t remaining;
+    uint32_t maxLag;
+    uint32_t dropped;
+} ring_client_t;
+
+static ring_client_t ringClients [] = {
+#if defined (HTTP_FEATURE)
+    {ESP_WEBSOCKET_TERMINAL_CLIENT, 0, 0, 0, 0},
+#endif //HTTP_FEATURE
+#if defined (BLUETOOTH_FEATURE)
+    {ESP_BT_CLIENT, 0, 0, 0, 0},
+#endif //BLUETOOTH_FEATURE
+#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    {ESP_SERIAL_BRIDGE_CLIENT, 0, 0, 0, 0},
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
+#if defined (TELNET_FEATURE)
+    {ESP_TELNET_CLIENT, 0, 0, 0, 0},
+#endif //TELNET_FEATURE
+#if defined (WS_DATA_FEATURE)
+    {ESP_WEBSOCKET_CLIENT, 0, 0, 0, 0},
+#endif //WS_DATA_FEATURE
+    {ESP_NO_CLIENT, 0, 0, 0, 0}
+};
+
+uint8_t ESP3DOutput::_ring[ESP_OUTPUT_RING_SIZE];
+uint32_t ESP3DOutput::_ringHead = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define RING_MUTEX_TIMEOUT 100
+//serial task and main loop both push to the ring
+static SemaphoreHandle_t ringMutex = nullptr;
+//Hold the ring mutex until end of scope, recursive in case a client write dispatches
+class RingLock
+{
+public:
+    RingLock()
+    {
+        _locked = ringMutex && (xSemaphoreTakeRecursive(ringMutex, RING_MUTEX_TIMEOUT / portTICK_PERIOD_MS) == pdTRUE);
+    }
+    ~RingLock()
+    {
+        if (_locked) {
+            xSemaphoreGiveRecursive(ringMutex);
+        }
+    }
+    bool locked()
+    {
+        return _locked || !ringMutex;
+    }
+private:
+    bool _locked;
+};
+#define RING_LOCK(ret) RingLock ringLock; if (!ringLock.locked()) { log_esp3d("Ring mutex timeout"); return ret; }
+#else
+#define RING_LOCK(ret)
+#endif //ARDUINO_ARCH_ESP32
+
+//is client able to receive data
+static bool ringClientReady(uint8_t client)
+{
+    switch (client) {
+#if defined (HTTP_FEATURE)
+    case ESP_WEBSOCKET_TERMINAL_CLIENT:
+        return websocket_terminal_server;
+#endif //HTTP_FEATURE
+#if defined (BLUETOOTH_FEATURE)
+    case ESP_BT_CLIENT:
+        return ESP3DOutput::isOutput(ESP_BT_CLIENT) && bt_service.started();
+#endif //BLUETOOTH_FEATURE
+#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    case ESP_SERIAL_BRIDGE_CLIENT:
+        return ESP3DOutput::isOutput(ESP_SERIAL_BRIDGE_CLIENT) && serial_bridge_service.started();
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
+#if defined (TELNET_FEATURE)
+    case ESP_TELNET_CLIENT:
+        return ESP3DOutput::isOutput(ESP_TELNET_CLIENT) && telnet_server.started() && telnet_server.isConnected();
+#endif //TELNET_FEATURE
+#if defined (WS_DATA_FEATURE)
+    case ESP_WEBSOCKET_CLIENT:
+        return ESP3DOutput::isOutput(ESP_WEBSOCKET_CLIENT) && websocket_data_server.started();
+#endif //WS_DATA_FEATURE
+    default:
+        break;
+    }
+    return false;
+}
+
+//is record not for this client
+static bool ringClientSkip(uint8_t client, uint8_t origin, uint8_t ignoreClient)
+{
+    if ((client == origin) || (client == ignoreClient)) {
+        return true;
+    }
+#if defined (HTTP_FEATURE)
+    //web client answer is already sent to websocket terminal
+    if ((client == ESP_WEBSOCKET_TERMINAL_CLIENT) && ((origin == ESP_HTTP_CLIENT) || (ignoreClient == ESP_HTTP_CLIENT))) {
+        return true;
+    }
+#endif //HTTP_FEATURE
+    return false;
+}
+
+static size_t ringClientAvailable(uint8_t client)
+{
+    switch (client) {
+#if defined (HTTP_FEATURE)
+    case ESP_WEBSOCKET_TERMINAL_CLIENT:
+        return websocket_terminal_server.availableForWrite();
+#endif //HTTP_FEATURE
+#if defined (BLUETOOTH_FEATURE)
+    case ESP_BT_CLIENT:
+        return bt_service.availableForWrite();
+#endif //BLUETOOTH_FEATURE
+#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    case ESP_SERIAL_BRIDGE_CLIENT:
+        return serial_bridge_service.availableForWrite();
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
+#if defined (TELNET_FEATURE)
+    case ESP_TELNET_CLIENT:
+        return telnet_server.availableForWrite();
+#endif //TELNET_FEATURE
+#if defined (WS_DATA_FEATURE)
+    case ESP_WEBSOCKET_CLIENT:
+        return websocket_data_server.availableForWrite();
+#endif //WS_DATA_FEATURE
+    default:
+        break;
+    }
+    return 0;
+}
+
+static void ringClientWrite(uint8_t client, const uint8_t * sbuf, size_t len)
+{
+    switch (client) {
+#if defined (HTTP_FEATURE)
+    case ESP_WEBSOCKET_TERMINAL_CLIENT:
+        log_esp3d("Dispatch websocket terminal");
+        websocket_terminal_server.write(sbuf, len);
+        break;
+#endif //HTTP_FEATURE
+#if defined (BLUETOOTH_FEATURE)
+    case ESP_BT_CLIENT:
+        log_esp3d("Dispatch to bt");
+        bt_service.write(sbuf, len);
+        break;
+#endif //BLUETOOTH_FEATURE
+#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    case ESP_SERIAL_BRIDGE_CLIENT:
+        log_esp3d("Dispatch to serial bridge");
+        serial_bridge_service.write(sbuf, len);
+        break;
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
+#if defined (TELNET_FEATURE)
+    case ESP_TELNET_CLIENT:
+        log_esp3d("Dispatch to telnet");
+        telnet_server.broadcast(sbuf, len);
+        break;
+#endif //TELNET_FEATURE
+#if defined (WS_DATA_FEATURE)
+    case ESP_WEBSOCKET_CLIENT:
+        log_esp3d("Dispatch to websocket data server");
+        websocket_data_server.write(sbuf, len);
+        break;
+#endif //WS_DATA_FEATURE
+    default:
+        (void)sbuf;
+        (void)len;
+        break;
+    }
+}
+
+//append data once to the ring, each client will read it at its own rate
+void ESP3DOutput::_ringPush(const uint8_t * sbuf, size_t len, uint8_t origin, uint8_t ignoreClient)
+{
+    if (ringClients[0].client == ESP_NO_CLIENT) {
+        return;
+    }
+    RING_LOCK();
+    while (len > 0) {
+        size_t size = (len > ESP_OUTPUT_RING_MAX_RECORD)?ESP_OUTPUT_RING_MAX_RECORD:len;
+        uint8_t header[ESP_OUTPUT_RING_HEADER_SIZE] = {(uint8_t)(size & 0xFF), (uint8_t)(size >> 8), origin, ignoreClient};
+        for (uint8_t i = 0; i < ESP_OUTPUT_RING_HEADER_SIZE; i++) {
+            _ring[(_ringHead + i) & (ESP_OUTPUT_RING_SIZE - 1)] = header[i];
+        }
+        uint32_t index = (_ringHead + ESP_OUTPUT_RING_HEADER_SIZE) & (ESP_OUTPUT_RING_SIZE - 1);
+        size_t first = ((ESP_OUTPUT_RING_SIZE - index) < size)?(ESP_OUTPUT_RING_SIZE - index):size;
+        memcpy(&_ring[index], sbuf, first);
+        if (first < size) {
+            memcpy(_ring, &sbuf[first], size - first);
+        }
+        //publish record once it is complete
+        _ringHead += ESP_OUTPUT_RING_HEADER_SIZE + size;
+        sbuf += size;
+        len -= size;
+    }
+}
+
+//send pending data to one client, never wait for it
+void ESP3DOutput::_ringDrain(uint8_t index)
+{
+    ring_client_t & c = ringClients[index];
+    uint32_t head = _ringHead;
+    if (!ringClientReady(c.client)) {
+        //nothing to wait for, just follow the ring
+        c.cursor = head;
+        c.remaining = 0;
+        return;
+    }
+    while (c.cursor != head) {
+        uint32_t lag = head - c.cursor;
+        if (lag > ESP_OUTPUT_RING_SIZE) {
+            //client is too slow: pending data has been overwritten
+            log_esp3d("Client %d dropped %d bytes", c.client, lag);
+            c.dropped += lag;
+            c.cursor = head;
+            c.remaining = 0;
+            return;
+        }
+        if (lag > c.maxLag) {
+            c.maxLag = lag;
+        }
+        if (c.remaining == 0) {
+            uint8_t header[ESP_OUTPUT_RING_HEADER_SIZE];
+            for (uint8_t i = 0; i < ESP_OUTPUT_RING_HEADER_SIZE; i++) {
+                header[i] = _ring[(c.cursor + i) & (ESP_OUTPUT_RING_SIZE - 1)];
+            }
+            c.cursor += ESP_OUTPUT_RING_HEADER_SIZE;
+            uint16_t size = header[0] | (header[1] << 8);
+            if (ringClientSkip(c.client, header[2], header[3])) {
+                c.cursor += size;
+                continue;
+            }
+            c.remaining = size;
+            if (size == 0) {
+                continue;
+            }
+        }
+        size_t available = ringClientAvailable(c.client);
+        if (available == 0) {
+            //client is busy, keep data for next loop
+            return;
+        }
+        uint32_t pos = c.cursor & (ESP_OUTPUT_RING_SIZE - 1);
+        size_t size = c.remaining;
+        if (size > available) {
+            size = available;
+        }
+        if (size > (ESP_OUTPUT_RING_SIZE - pos)) {
+            size = ESP_OUTPUT_RING_SIZE - pos;
+        }
+        ringClientWrite(c.client, &_ring[pos], size);
+        c.cursor += size;
+        c.remaining -= size;
+    }
+}
+
+//drain the shared output ring
+void ESP3DOutput::handle()
+{
+    RING_LOCK();
+    for (uint8_t i = 0; ringClients[i].client != ESP_NO_CLIENT; i++) {
+        _ringDrain(i);
+    }
+}
+
+//lag and drop counters of ring clients
+bool ESP3DOutput::ringClientStats(uint8_t index, uint8_t & client, uint32_t & lag, uint32_t & maxLag, uint32_t & dropped)
+{
+    for (uint8_t i = 0; i <= index; i++) {
+        if (ringClients[i].client == ESP_NO_CLIENT) {
+            return false;
+        }
+    }
+    RING_LOCK(false);
+    client = ringClients[index].client;
+    lag = _ringHead - ringClients[index].cursor;
+    maxLag = ringClients[index].maxLag;
+    dropped = ringClients[index].dropped;
+    return true;
+}
+
+#if defined(HAS_SERIAL_DISPLAY)
+#define SERIAL_DISPLAY_PREFIX HAS_SERIAL_DISPLAY
+#else
+#define SERIAL_DISPLAY_PREFIX ""
+#endif //HAS_SERIAL_DISPLAY
+
+//message prefix, message suffix, echo serial prefix, remote screen prefix, error prefix, skip ok
+static const msg_prefixes_t grblPrefixes = {"[MSG:", "]", "[MSG:", nullptr, "error: ", false};
+static const msg_prefixes_t marlinPrefixes = {";echo:", "", "echo:", SERIAL_DISPLAY_PREFIX "M117 ", "error: ", true};
+static const msg_prefixes_t defaultPrefixes = {";", "", ";", "M117 ", ";error: ", false};
+
+const msg_prefixes_t * ESP3DOutput::_prefixes = &defaultPrefixes;
+uint8_t ESP3DOutput::_prefixesTarget = 0;
+
+//prefixes are only resolved again when firmware target changes
+const msg_prefixes_t * ESP3DOutput::getPrefixes()
+{
+    uint8_t target = Settings_ESP3D::GetFirmwareTarget();
+    if (target != _prefixesTarget) {
+        _prefixesTarget = target;
+        switch(target) {
+        case GRBL:
+            _prefixes = &grblPrefixes;
+            break;
+        case MARLIN_EMBEDDED:
+        case MARLIN:
+            _prefixes = &marlinPrefixes;
+            break;
+        default:
+            _prefixes = &defaultPrefixes;
+            break;
+        }
+    }
+    return _prefixes;
+}
+
+//Messages up to this size are assembled on stack
+#define PRINT_PARTS_STACK_SIZE 128
+
+//write prefix, message, suffix and end of line with a single write, as serial
+//queue takes a write whole or not at all, so printer never gets part of a line
+size_t ESP3DOutput::_printParts(const char * prefix, const char * s, const char * suffix, bool withNL)
+{
+    //same end of line as printLN()
+    const char * eol = withNL?((_client == ESP_TELNET_CLIENT)?"\r\r\n":"\r\n"):"";
+    const char * parts[] = {prefix, s, suffix, eol};
+    size_t sizes[4];
+    size_t total = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        sizes[i] = strlen(parts[i]);
+        total += sizes[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    char stackLine[PRINT_PARTS_STACK_SIZE];
+    char * line = (total <= PRINT_PARTS_STACK_SIZE)?stackLine:(char *)malloc(total);
+    if (!line) {
+        log_esp3d("Cannot allocate %d bytes for message", total);
+        return 0;
+    }
+    size_t pos = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        memcpy(&line[pos], parts[i], sizes[i]);
+        pos += sizes[i];
+    }
+    size_t res = write((const uint8_t *)line, total);
+    if (line != stackLine) {
+        free(line);
+    }
+    return res;
+}
+
 //tool function to avoid string corrupt JSON files
 const char * ESP3DOutput::encodeString(const char * s)
 {
@@ -170,6 +531,8 @@ ESP3DOutput::ESP3DOutput(uint8_t client)
     _headerSent = false;
     _footerSent = false;
     _webserver = nullptr;
+    _httpBuffer = nullptr;
+    _httpBufferSize = 0;
 #endif //HTTP_FEATURE
 }
 
@@ -190,6 +553,64 @@ ESP3DOutput::ESP3DOutput(WEBSERVER   * webserver)
     _headerSent = false;
     _footerSent = false;
     _webserver = webserver;
+    _httpBuffer = nullptr;
+    _httpBufferSize = 0;
+}
+
+//Stage data and send only full chunks, headers are sent with first data
+size_t ESP3DOutput::_httpWrite(const uint8_t * buffer, size_t size)
+{
+    if (!_webserver) {
+        return 0;
+    }
+    if (!_headerSent && !_footerSent) {
+        _webserver->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        _webserver->sendHeader("Content-Type","text/html");
+        _webserver->sendHeader("Cache-Control","no-cache");
+        _webserver->send(_code);
+        _headerSent = true;
+    }
+    //empty chunk would end the answer
+    if (!_headerSent || _footerSent || (size == 0)) {
+        return 0;
+    }
+    if (!_httpBuffer) {
+        _httpBuffer = (uint8_t *)malloc(ESP_HTTP_OUTPUT_BUFFER_SIZE);
+        if (!_httpBuffer) {
+            //no memory: one chunk per write as before
+            _webserver->sendContent_P((const char*)buffer,size);
+            return size;
+        }
+    }
+    size_t written = size;
+    while (size > 0) {
+        if (_httpBufferSize == ESP_HTTP_OUTPUT_BUFFER_SIZE) {
+            _httpFlush();
+        }
+        //no need to copy a full chunk
+        if ((_httpBufferSize == 0) && (size >= ESP_HTTP_OUTPUT_BUFFER_SIZE)) {
+            _webserver->sendContent_P((const char*)buffer,size);
+            break;
+        }
+        size_t count = ESP_HTTP_OUTPUT_BUFFER_SIZE - _httpBufferSize;
+        if (count > size) {
+            count = size;
+        }
+        memcpy(&_httpBuffer[_httpBufferSize], buffer, count);
+        _httpBufferSize += count;
+        buffer += count;
+        size -= count;
+    }
+    return written;
+}
+
+//Send staged data as one chunk
+void ESP3DOutput::_httpFlush()
+{
+    if (_httpBufferSize > 0) {
+        _webserver->sendContent_P((const char*)_httpBuffer,_httpBufferSize);
+        _httpBufferSize = 0;
+    }
 }
 #endif //HTTP_FEATURE
 
@@ -197,11 +618,23 @@ ESP3DOutput::ESP3DOutput(WEBSERVER   * webserver)
 ESP3DOutput::~ESP3DOutput()
 {
     flush();
+#ifdef HTTP_FEATURE
+    if (_httpBuffer) {
+        free(_httpBuffer);
+        _httpBuffer = nullptr;
+    }
+#endif //HTTP_FEATURE
 }
 
 bool ESP3DOutput::isOutput(uint8_t flag, bool fromsettings)
 {
     if(fromsettings) {
+#if defined(ARDUINO_ARCH_ESP32)
+        //first done at boot, before serial task is started
+        if (!ringMutex) {
+            ringMutex = xSemaphoreCreateRecursiveMutex();
+        }
+#endif //ARDUINO_ARCH_ESP32
 #if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL || COMMUNICATION_PROTOCOL == SOCKET_SERIAL
         _serialoutputflags= Settings_ESP3D::read_byte (ESP_SERIAL_FLAG);
 #endif // COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
@@ -269,6 +702,12 @@ bool ESP3DOutput::isOutput(uint8_t flag, bool fromsettings)
 size_t ESP3DOutput::dispatch (const uint8_t * sbuf, size_t len, uint8_t ignoreClient)
 {
     log_esp3d("Dispatch %d chars from client %d and ignore %d", len, _client, ignoreClient);
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    //printer reports are parsed once here, before gcode host and clients get them
+    if ((_client == ESP_SERIAL_CLIENT) || (_client == ESP_SOCKET_SERIAL_CLIENT)) {
+        PrinterStatus::parse(sbuf, len);
+    }
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #if defined(GCODE_HOST_FEATURE)
     if (!(_client == ESP_STREAM_HOST_CLIENT || ESP_STREAM_HOST_CLIENT==ignoreClient)) {
         log_esp3d("Dispatch to gcode host");
@@ -280,10 +719,19 @@ size_t ESP3DOutput::dispatch (const uint8_t * sbuf, size_t len, uint8_t ignoreCl
         if (isOutput(ESP_SERIAL_CLIENT)) {
 #if COMMUNICATION_PROTOCOL == MKS_SERIAL
             log_esp3d("Dispatch to gcode frame");
-            MKSService::sendGcodeFrame((const char *)sbuf);
+            if (!MKSService::sendGcodeFrame((const char *)sbuf) && (_client != ESP_ALL_CLIENTS)) {
+                printERROR("Board busy, command not sent");
+            }
 #else
             log_esp3d("Dispatch to serial service");
-            serial_service.write(sbuf, len);
+            //queue refuses a whole line when full, main loop never waits for it:
+            //sender is told, refused bytes are counted in serial TX dropped (ESP420)
+            if (serial_service.write(sbuf, len) == 0) {
+                log_esp3d("Serial busy, %d bytes from client %d refused", len, _client);
+                if (_client != ESP_ALL_CLIENTS) {
+                    printERROR("Serial busy, command not sent");
+                }
+            }
 #endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
         }
     }
@@ -298,46 +746,8 @@ size_t ESP3DOutput::dispatch (const uint8_t * sbuf, size_t len, uint8_t ignoreCl
         MYSERIAL1.write(sbuf, len);
     }
 #endif //COMMUNICATION_PROTOCOL == SOCKET_SERIAL 
-#if defined (HTTP_FEATURE) //no need to block it never
-    if (!((_client == ESP_WEBSOCKET_TERMINAL_CLIENT) || (_client == ESP_HTTP_CLIENT)|| (ESP_WEBSOCKET_TERMINAL_CLIENT==ignoreClient) || (ESP_HTTP_CLIENT==ignoreClient))) {
-        if (websocket_terminal_server) {
-            log_esp3d("Dispatch websocket terminal");
-            websocket_terminal_server.write(sbuf, len);
-        }
-    }
-#endif //HTTP_FEATURE    
-#if defined (BLUETOOTH_FEATURE)
-    if (!(_client == ESP_BT_CLIENT  || ESP_BT_CLIENT==ignoreClient)) {
-        if (isOutput(ESP_BT_CLIENT) && bt_service.started()) {
-            log_esp3d("Dispatch to bt");
-            bt_service.write(sbuf, len);
-        }
-    }
-#endif //BLUETOOTH_FEATURE
-#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
-    if (!(_client == ESP_SERIAL_BRIDGE_CLIENT || ESP_SERIAL_BRIDGE_CLIENT==ignoreClient)) {
-        if (isOutput(ESP_SERIAL_BRIDGE_CLIENT) && serial_bridge_service.started()) {
-            log_esp3d("Dispatch to serial bridge");
-            serial_bridge_service.write(sbuf, len);
-        }
-    }
-#endif //ESP_SERIAL_BRIDGE_OUTPUT 
-#if defined (TELNET_FEATURE)
-    if (!(_client == ESP_TELNET_CLIENT || ESP_TELNET_CLIENT==ignoreClient)) {
-        if (isOutput(ESP_TELNET_CLIENT) && telnet_server.started()) {
-            log_esp3d("Dispatch to telnet");
-            telnet_server.write(sbuf, len);
-        }
-    }
-#endif //TELNET_FEATURE 
-#if defined (WS_DATA_FEATURE)
-    if (!(_client == ESP_WEBSOCKET_CLIENT || ESP_WEBSOCKET_CLIENT==ignoreClient)) {
-        if (isOutput(ESP_WEBSOCKET_CLIENT) && websocket_data_server.started()) {
-            log_esp3d("Dispatch to websocket data server");
-            websocket_data_server.write(sbuf, len);
-        }
-    }
-#endif //WS_DATA_FEATURE 
+    //network clients are served from the shared ring so a slow one cannot stall the others
+    _ringPush(sbuf, len, _client, ignoreClient);
     return len;
 }
 
@@ -357,6 +767,7 @@ void ESP3DOutput::flush()
     case ESP_HTTP_CLIENT:
         if (_webserver) {
             if (_headerSent && !_footerSent) {
+                _httpFlush();
                 _webserver->sendContent("");
                 _footerSent = true;
             }
@@ -365,16 +776,22 @@ void ESP3DOutput::flush()
 #endif //HTTP_FEATURE
 #if defined (BLUETOOTH_FEATURE)
     case ESP_BT_CLIENT:
+        //send what is still pending in ring first
+        handle();
         bt_service.flush();
         break;
 #endif //BLUETOOTH_FEATURE 
 #if defined(ESP_SERIAL_BRIDGE_OUTPUT)
     case ESP_SERIAL_BRIDGE_CLIENT:
+        //send what is still pending in ring first
+        handle();
         serial_bridge_service.flush();
         break;
 #endif //ESP_SERIAL_BRIDGE_OUTPUT
 #if defined (TELNET_FEATURE)
     case ESP_TELNET_CLIENT:
+        //send what is still pending in ring first
+        handle();
         telnet_server.flush();
         break;
 #endif //TELNET_FEATURE 
@@ -430,23 +847,13 @@ size_t ESP3DOutput::printMSGLine(const char * s)
     if (!isOutput(_client)) {
         return 0;
     }
-    String display;
     log_esp3d("PrintMSG to client %d", _client);
     if (_client == ESP_HTTP_CLIENT) {
 #ifdef HTTP_FEATURE
-        if (_webserver) {
-            if (!_headerSent && !_footerSent) {
-                _webserver->setContentLength(CONTENT_LENGTH_UNKNOWN);
-                _webserver->sendHeader("Content-Type","text/html");
-                _webserver->sendHeader("Cache-Control","no-cache");
-                _webserver->send(_code);
-                _headerSent = true;
-            }
-            if (_headerSent && !_footerSent) {
-                _webserver->sendContent_P((const char*)s,strlen(s));
-                _webserver->sendContent_P((const char*)"\n",1);
-                return strlen(s+1);
-            }
+        if (_webserver && !_footerSent) {
+            _httpWrite((const uint8_t*)s,strlen(s));
+            _httpWrite((const uint8_t*)"\n",1);
+            return strlen(s) + 1;
         }
 
 #endif //HTTP_FEATURE
@@ -456,37 +863,11 @@ size_t ESP3DOutput::printMSGLine(const char * s)
     if (_client == ESP_SCREEN_CLIENT || _client == ESP_REMOTE_SCREEN_CLIENT ||_client == ESP_SCREEN_CLIENT ) {
         return print(s);
     }
-    switch(Settings_ESP3D::GetFirmwareTarget()) {
-    case GRBL:
-        display = "[MSG:";
-        display += s;
-        display += "]";
-        break;
-    case MARLIN_EMBEDDED:
-    case MARLIN:
-        if (((_client == ESP_ECHO_SERIAL_CLIENT) ||(_client == ESP_STREAM_HOST_CLIENT)) && (strcmp(s, "ok") == 0)) {
-            return 0;
-        }
-
-        if (_client == ESP_ECHO_SERIAL_CLIENT) {
-            display = "echo:";
-        } else {
-            display = ";echo:";
-        }
-
-        display += s;
-        break;
-    case SMOOTHIEWARE:
-    case REPETIER:
-    default:
-
-        display = ";";
-
-        display += s;
+    const msg_prefixes_t * prefixes = getPrefixes();
+    if (prefixes->skipOk && ((_client == ESP_ECHO_SERIAL_CLIENT) ||(_client == ESP_STREAM_HOST_CLIENT)) && (strcmp(s, "ok") == 0)) {
+        return 0;
     }
-
-    return printLN(display.c_str());
-
+    return _printParts((_client == ESP_ECHO_SERIAL_CLIENT)?prefixes->echoMsg:prefixes->msg, s, prefixes->msgEnd, true);
 }
 
 size_t ESP3DOutput::printMSG(const char * s, bool withNL)
@@ -508,7 +889,6 @@ size_t ESP3DOutput::printMSG(const char * s, bool withNL)
     if (!isOutput(_client)) {
         return 0;
     }
-    String display;
     log_esp3d("PrintMSG to client %d", _client);
     if (_client == ESP_HTTP_CLIENT) {
 #ifdef HTTP_FEATURE
@@ -531,54 +911,18 @@ size_t ESP3DOutput::printMSG(const char * s, bool withNL)
     if (_client == ESP_SCREEN_CLIENT) {
         return print(s);
     }
-    switch(Settings_ESP3D::GetFirmwareTarget()) {
-    case GRBL:
-        display = "[MSG:";
-        display += s;
-        display += "]";
-        break;
-    case MARLIN_EMBEDDED:
-    case MARLIN:
-        if (((_client == ESP_ECHO_SERIAL_CLIENT) ||(_client == ESP_STREAM_HOST_CLIENT)) && (strcmp(s, "ok") == 0)) {
-            return 0;
-        }
-        if (_client == ESP_REMOTE_SCREEN_CLIENT) {
-#if defined(HAS_SERIAL_DISPLAY)
-            display = HAS_SERIAL_DISPLAY;
-#endif //HAS_REMOTE_SCREEN
-            display += "M117 ";
-            withNL = true;
-            log_esp3d("Screen should display %s%s", display.c_str(),s);
-        } else {
-            if (_client == ESP_ECHO_SERIAL_CLIENT) {
-                display = "echo:";
-            } else {
-                display = ";echo:";
-            }
-        }
-        display += s;
-        break;
-    case SMOOTHIEWARE:
-    case REPETIER:
-    default:
-        if (_client == ESP_REMOTE_SCREEN_CLIENT) {
-            display = "M117 ";
-            withNL = true;
-        } else {
-            display = ";";
-        }
-        display += s;
+    const msg_prefixes_t * prefixes = getPrefixes();
+    if (prefixes->skipOk && ((_client == ESP_ECHO_SERIAL_CLIENT) ||(_client == ESP_STREAM_HOST_CLIENT)) && (strcmp(s, "ok") == 0)) {
+        return 0;
     }
-    if(withNL) {
-        return printLN(display.c_str());
-    } else {
-        return print(display.c_str());
+    if ((_client == ESP_REMOTE_SCREEN_CLIENT) && prefixes->screenMsg) {
+        return _printParts(prefixes->screenMsg, s, "", true);
     }
+    return _printParts((_client == ESP_ECHO_SERIAL_CLIENT)?prefixes->echoMsg:prefixes->msg, s, prefixes->msgEnd, withNL);
 }
 
 size_t ESP3DOutput::printERROR(const char * s, int code_error)
 {
-    String display = "";
     if (!isOutput(_client)) {
         return 0;
     }
@@ -590,6 +934,7 @@ size_t ESP3DOutput::printERROR(const char * s, int code_error)
         (void)code_error;
         if (_webserver) {
             if (!_headerSent && !_footerSent) {
+                String display;
                 _webserver->sendHeader("Cache-Control","no-cache");
                 if (s[0]!='{') {
                     display = "error: ";
@@ -606,29 +951,7 @@ size_t ESP3DOutput::printERROR(const char * s, int code_error)
 #endif //HTTP_FEATURE
         return 0;
     }
-    switch(Settings_ESP3D::GetFirmwareTarget()) {
-    case GRBL:
-        if (s[0]!='{') {
-            display = "error: ";
-        }
-        display += s;
-        break;
-    case MARLIN_EMBEDDED:
-    case MARLIN:
-        if (s[0]!='{') {
-            display = "error: ";
-        }
-        display += s;
-        break;
-    case SMOOTHIEWARE:
-    case REPETIER:
-    default:
-        if (s[0]!='{') {
-            display = ";error: ";
-        }
-        display += s;
-    }
-    return printLN(display.c_str());
+    return _printParts((s[0]!='{')?getPrefixes()->error:"", s, "", true);
 }
 
 int ESP3DOutput::availableforwrite()
@@ -729,18 +1052,7 @@ size_t ESP3DOutput::write(const uint8_t *buffer, size_t size)
     switch (_client) {
 #ifdef HTTP_FEATURE
     case ESP_HTTP_CLIENT:
-        if (_webserver) {
-            if (!_headerSent && !_footerSent) {
-                _webserver->setContentLength(CONTENT_LENGTH_UNKNOWN);
-                _webserver->sendHeader("Content-Type","text/html");
-                _webserver->sendHeader("Cache-Control","no-cache");
-                _webserver->send(_code);
-                _headerSent = true;
-            }
-            if (_headerSent && !_footerSent) {
-                _webserver->sendContent_P((const char*)buffer,size);
-            }
-        }
+        _httpWrite(buffer, size);
         break;
 #endif //HTTP_FEATURE
 #if defined (DISPLAY_DEVICE)
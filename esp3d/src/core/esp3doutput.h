@@ -58,6 +58,29 @@ class WebServer;
 #endif //ARDUINO_ARCH_ESP8266
 #endif //HTTP_FEATURE
 
+//Shared output ring for network clients, must be a power of 2
+#ifndef ESP_OUTPUT_RING_SIZE
+#define ESP_OUTPUT_RING_SIZE 2048
+#endif //ESP_OUTPUT_RING_SIZE
+//record header: size (2 bytes), origin client, ignored client
+#define ESP_OUTPUT_RING_HEADER_SIZE 4
+#define ESP_OUTPUT_RING_MAX_RECORD (ESP_OUTPUT_RING_SIZE/4)
+
+//HTTP answer is staged and sent by chunks of this size instead of one chunk per print,
+//chunk header and data fit in one TCP segment
+#ifndef ESP_HTTP_OUTPUT_BUFFER_SIZE
+#define ESP_HTTP_OUTPUT_BUFFER_SIZE 1400
+#endif //ESP_HTTP_OUTPUT_BUFFER_SIZE
+
+//message prefixes according firmware target
+typedef struct {
+    const char * msg;
+    const char * msgEnd;
+    const char * echoMsg;
+    const char * screenMsg;
+    const char * error;
+    bool skipOk;
+} msg_prefixes_t;
 
 class ESP3DOutput : public Print
 {
@@ -101,6 +124,9 @@ public:
     static bool isOutput(uint8_t flag, bool fromsettings = false);
     static void toScreen(uint8_t output_type, const char * s);
     static const char * encodeString(const char * s);
+    static void handle();
+    static const msg_prefixes_t * getPrefixes();
+    static bool ringClientStats(uint8_t index, uint8_t & client, uint32_t & lag, uint32_t & maxLag, uint32_t & dropped);
 #ifdef HTTP_FEATURE
     bool footerSent()
     {
@@ -109,11 +135,22 @@ public:
 #endif //HTTP_FEATURE
 private:
     uint8_t _client;
+    static const msg_prefixes_t * _prefixes;
+    static uint8_t _prefixesTarget;
+    size_t _printParts(const char * prefix, const char * s, const char * suffix, bool withNL);
+    static uint8_t _ring[ESP_OUTPUT_RING_SIZE];
+    static uint32_t _ringHead;
+    static void _ringPush(const uint8_t * sbuf, size_t len, uint8_t origin, uint8_t ignoreClient);
+    static void _ringDrain(uint8_t index);
 #ifdef HTTP_FEATURE
     int _code;
     bool _headerSent;
     bool _footerSent;
     WEBSERVER * _webserver;
+    uint8_t * _httpBuffer;
+    size_t _httpBufferSize;
+    size_t _httpWrite(const uint8_t * buffer, size_t size);
+    void _httpFlush();
 #endif //HTTP_FEATURE
 #if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL || COMMUNICATION_PROTOCOL == SOCKET_SERIAL
     static uint8_t _serialoutputflags;
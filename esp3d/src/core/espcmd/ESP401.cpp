@@ -42,6 +42,79 @@
 #ifdef SD_DEVICE
 #include "../../modules/filesystem/esp_sd.h"
 #endif  // SD_DEVICE
+// Only digits with optional sign
+static bool isNumber(const String& value) {
+  uint start = (value.length() > 0 && value[0] == '-') ? 1 : 0;
+  if (value.length() <= start) {
+    return false;
+  }
+  for (uint i = start; i < value.length(); i++) {
+    if (!isdigit(value[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Check value against setting description
+static bool isValidValue(const esp3d_setting_desc_t* setting,
+                         const String& value) {
+  switch (setting->type) {
+    case 'B':
+    case 'I': {
+      if (!isNumber(value)) {
+        return false;
+      }
+      int64_t v = value.toInt();
+      switch (setting->options) {
+        case SETTING_OPTIONS_LIST: {
+          // list is {"label":"value"},...
+          String tag = "\":\"" + value + "\"}";
+          return strstr(setting->text, tag.c_str()) != nullptr;
+        }
+#if COMMUNICATION_PROTOCOL != SOCKET_SERIAL || defined(ESP_SERIAL_BRIDGE_OUTPUT)
+        case SETTING_OPTIONS_BAUD: {
+          uint8_t count = 0;
+          const long* bl = serial_service.get_baudratelist(&count);
+          for (uint8_t i = 0; i < count; i++) {
+            if (bl[i] == v) {
+              return true;
+            }
+          }
+          return false;
+        }
+#endif  // COMMUNICATION_PROTOCOL != SOCKET_SERIAL
+#ifdef SENSOR_DEVICE
+        case SETTING_OPTIONS_SENSOR:
+          if (v == 0) {
+            return true;
+          }
+          for (uint8_t p = 0; p < esp3d_sensor.nbType(); p++) {
+            if (esp3d_sensor.GetModel(p) == v) {
+              return true;
+            }
+          }
+          return false;
+#endif  // SENSOR_DEVICE
+        default:
+          return (v >= setting->min) && (v <= (int64_t)setting->max);
+      }
+    }
+    case 'S':
+      if ((value.length() == 0) && (setting->flags & SETTING_FLAG_NULLABLE)) {
+        return true;
+      }
+      return (value.length() >= (uint)setting->min) &&
+             (value.length() <= setting->max);
+    case 'A': {
+      IPAddress ip;
+      return ip.fromString(value.c_str());
+    }
+    default:
+      return false;
+  }
+}
+
 // Set EEPROM setting
 //[ESP401]P=<position> T=<type> V=<value> json=<no> pwd=<user/admin password>
 bool Commands::ESP401(const char* cmd_params, level_authenticate_type auth_type,
@@ -77,9 +150,17 @@ bool Commands::ESP401(const char* cmd_params, level_authenticate_type auth_type,
       response = "Invalid parameter V";
       noError = false;
     } else {
-      if (!(styp == "B" || styp == "S" || styp == "A" || styp == "I")) {
+      const esp3d_setting_desc_t* setting =
+          Settings_ESP3D::get_setting_by_pos(spos.toInt());
+      if (!setting || !isNumber(spos)) {
+        response = "Invalid parameter P";
+        noError = false;
+      } else if (styp.length() != 1 || styp[0] != setting->type) {
         response = "Invalid value for T";
         noError = false;
+      } else if (!isValidValue(setting, sval)) {
+        response = "Invalid value for V";
+        noError = false;
       }
     }
     if (noError) {
@@ -209,7 +290,7 @@ bool Commands::ESP401(const char* cmd_params, level_authenticate_type auth_type,
             }
           }
         }
-#if defined(WIFI_FEATURE)
+#if defined(WIFI_FEATURE) || defined(ETH_FEATURE)
         // IP address
         if (styp == "A") {
           if (!Settings_ESP3D::write_IP_String(spos.toInt(), sval.c_str())) {
@@ -220,7 +301,7 @@ bool Commands::ESP401(const char* cmd_params, level_authenticate_type auth_type,
             // TBD
           }
         }
-#endif  // WIFI_FEATURE
+#endif  // WIFI_FEATURE || ETH_FEATURE
       }
     }
   }
@@ -25,6 +25,9 @@
 #if COMMUNICATION_PROTOCOL != SOCKET_SERIAL || defined(ESP_SERIAL_BRIDGE_OUTPUT)
 #include "../../modules/serial/serial_service.h"
 #endif // COMMUNICATION_PROTOCOL != SOCKET_SERIAL
+#if COMMUNICATION_PROTOCOL == MKS_SERIAL
+#include "../../modules/mks/mks_service.h"
+#endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
 #ifdef FILESYSTEM_FEATURE
 #include "../../modules/filesystem/esp_filesystem.h"
 #endif //FILESYSTEM_FEATURE
@@ -49,9 +52,12 @@
 #ifdef FTP_FEATURE
 #include "../../modules/ftp/FtpServer.h"
 #endif //FTP_FEATURE
-#ifdef WS_DATA_FEATURE
+#if defined(HTTP_FEATURE) || defined(WS_DATA_FEATURE)
 #include "../../modules/websocket/websocket_server.h"
-#endif //WS_DATA_FEATURE
+#endif //HTTP_FEATURE || WS_DATA_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+#include "../../modules/printer_status/printer_status.h"
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #ifdef WEBDAV_FEATURE
 #include "../../modules/webdav/webdav_server.h"
 #endif //WEBDAV_FEATURE
@@ -76,6 +82,9 @@
 #if defined (DISPLAY_DEVICE)
 #include "../../modules/display/display.h"
 #endif //DISPLAY_DEVICE
+#if defined (ESP_PROFILER_FEATURE)
+#include "../profiler.h"
+#endif //ESP_PROFILER_FEATURE
 #define COMMANDID   420
 
 //Get ESP current status
@@ -232,6 +241,139 @@ bool Commands::ESP420(const char* cmd_params, level_authenticate_type auth_type,
                 output->printMSGLine(line.c_str());
             }
             line="";
+            //Settings cache
+            if (json) {
+                line +=",{\"id\":\"";
+            }
+            line +="settings cache";
+            if (json) {
+                line +="\",\"value\":\"";
+            } else {
+                line +=": ";
+            }
+            line +=String(Settings_ESP3D::cacheHits());
+            line +=" hits / ";
+            line +=String(Settings_ESP3D::flashCommits());
+            line +=" commits";
+            if (json) {
+                line +="\"}";
+                output->print (line.c_str());
+            } else {
+                output->printMSGLine(line.c_str());
+            }
+            line="";
+            //Output ring clients
+            uint8_t ringClient;
+            uint32_t ringLag;
+            uint32_t ringMaxLag;
+            uint32_t ringDropped;
+            for (uint8_t i = 0; ESP3DOutput::ringClientStats(i, ringClient, ringLag, ringMaxLag, ringDropped); i++) {
+                if (json) {
+                    line +=",{\"id\":\"";
+                }
+                switch (ringClient) {
+                case ESP_WEBSOCKET_TERMINAL_CLIENT:
+                    line +="websocket terminal";
+                    break;
+                case ESP_BT_CLIENT:
+                    line +="bt";
+                    break;
+                case ESP_SERIAL_BRIDGE_CLIENT:
+                    line +="serial bridge";
+                    break;
+                case ESP_TELNET_CLIENT:
+                    line +="telnet";
+                    break;
+                case ESP_WEBSOCKET_CLIENT:
+                    line +="websocket";
+                    break;
+                default:
+                    line +=String(ringClient);
+                    break;
+                }
+                line +=" output";
+                if (json) {
+                    line +="\",\"value\":\"";
+                } else {
+                    line +=": ";
+                }
+                line +="lag ";
+                line +=String(ringLag);
+                line +=" B (max ";
+                line +=String(ringMaxLag);
+                line +=" B), dropped ";
+                line +=String(ringDropped);
+                line +=" B";
+                if (json) {
+                    line +="\"}";
+                    output->print (line.c_str());
+                } else {
+                    output->printMSGLine(line.c_str());
+                }
+                line="";
+            }
+#if defined (ESP_PROFILER_FEATURE)
+            //Main loop time and slowest service
+            if (LoopProfiler::calls(PROFILE_LOOP) > 0) {
+                uint8_t slowest = PROFILE_COUNT;
+                for (uint8_t i = PROFILE_LOOP + 1; i < PROFILE_COUNT; i++) {
+                    //network includes its services
+                    if ((i == PROFILE_NETWORK) || (LoopProfiler::calls(i) == 0)) {
+                        continue;
+                    }
+                    if ((slowest == PROFILE_COUNT) || (LoopProfiler::percentile(i, 99) > LoopProfiler::percentile(slowest, 99))) {
+                        slowest = i;
+                    }
+                }
+                if (json) {
+                    line +=",{\"id\":\"";
+                }
+                line +="loop time";
+                if (json) {
+                    line +="\",\"value\":\"";
+                } else {
+                    line +=": ";
+                }
+                line +="avg ";
+                line +=String(LoopProfiler::average(PROFILE_LOOP));
+                line +=" us, max ";
+                line +=String(LoopProfiler::maxDuration(PROFILE_LOOP));
+                line +=" us, p99 ";
+                line +=String(LoopProfiler::percentile(PROFILE_LOOP, 99));
+                line +=" us";
+                if (json) {
+                    line +="\"}";
+                    output->print (line.c_str());
+                } else {
+                    output->printMSGLine(line.c_str());
+                }
+                line="";
+                if (slowest != PROFILE_COUNT) {
+                    if (json) {
+                        line +=",{\"id\":\"";
+                    }
+                    line +="slowest service";
+                    if (json) {
+                        line +="\",\"value\":\"";
+                    } else {
+                        line +=": ";
+                    }
+                    line +=LoopProfiler::name(slowest);
+                    line +=" p99 ";
+                    line +=String(LoopProfiler::percentile(slowest, 99));
+                    line +=" us, max ";
+                    line +=String(LoopProfiler::maxDuration(slowest));
+                    line +=" us";
+                    if (json) {
+                        line +="\"}";
+                        output->print (line.c_str());
+                    } else {
+                        output->printMSGLine(line.c_str());
+                    }
+                    line="";
+                }
+            }
+#endif //ESP_PROFILER_FEATURE
 
 #if (defined (WIFI_FEATURE) || defined (ETH_FEATURE)) && (defined(OTA_FEATURE) || defined(WEB_UPDATE_FEATURE))
             //update space
@@ -312,6 +454,28 @@ bool Commands::ESP420(const char* cmd_params, level_authenticate_type auth_type,
                 output->printMSGLine(line.c_str());
             }
             line="";
+            //serial TX queue usage
+            if (json) {
+                line +=",{\"id\":\"";
+            }
+            line +="Serial TX queue";
+            if (json) {
+                line +="\",\"value\":\"";
+            } else {
+                line +=": ";
+            }
+            line+=String(serial_service.txHighWater());
+            line+="/";
+            line+=String(ESP3D_SERIAL_TX_QUEUE_SIZE);
+            line+=" bytes, dropped ";
+            line+=String(serial_service.txDropped());
+            if (json) {
+                line +="\"}";
+                output->print (line.c_str());
+            } else {
+                output->printMSGLine(line.c_str());
+            }
+            line="";
 #endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
 #if defined (WIFI_FEATURE)
             if (WiFi.getMode() != WIFI_OFF) {
@@ -437,7 +601,65 @@ bool Commands::ESP420(const char* cmd_params, level_authenticate_type auth_type,
                 }
                 line="";
             }
+            if (websocket_terminal_server.started()) {
+                //websocket terminal latency
+                if (json) {
+                    line +=",{\"id\":\"";
+                }
+                line +="Websocket terminal latency";
+                if (json) {
+                    line +="\",\"value\":\"";
+                } else {
+                    line +=": ";
+                }
+                line+="avg ";
+                line+=String(websocket_terminal_server.averageLatency());
+                line+=" ms, max ";
+                line+=String(websocket_terminal_server.maxLatency());
+                line+=" ms, ";
+                line+=String(websocket_terminal_server.framesSent());
+                line+=" frames";
+#if defined (ESP_WS_DEFLATE_FEATURE)
+                line+=", compressed ";
+                line+=String(websocket_terminal_server.compressionRatio());
+                line+="%, ";
+                line+=String(websocket_terminal_server.compressionCost());
+                line+=" us/KB";
+#endif //ESP_WS_DEFLATE_FEATURE
+                if (json) {
+                    line +="\"}";
+                    output->print (line.c_str());
+                } else {
+                    output->printMSGLine(line.c_str());
+                }
+                line="";
+            }
 #endif //HTTP_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+            if (PrinterStatus::started()) {
+                //status channel port
+                if (json) {
+                    line +=",{\"id\":\"";
+                }
+                line +="Status port";
+                if (json) {
+                    line +="\",\"value\":\"";
+                } else {
+                    line +=": ";
+                }
+                line+=PrinterStatus::port();
+                line+=", ";
+                line+=String(PrinterStatus::framesSent());
+                line+=" frames";
+                if (json) {
+                    line +="\"}";
+                    output->print (line.c_str());
+                } else {
+                    output->printMSGLine(line.c_str());
+                }
+                line="";
+            }
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #if defined (TELNET_FEATURE)
             if (telnet_server.started()) {
                 //telnet port
@@ -469,6 +691,11 @@ bool Commands::ESP420(const char* cmd_params, level_authenticate_type auth_type,
                         line +=": ";
                     }
                     line+=telnet_server.clientIPAddress();
+                    if (telnet_server.droppedBytes() > 0) {
+                        line+=", dropped ";
+                        line+=String(telnet_server.droppedBytes());
+                        line+=" bytes";
+                    }
                     if (json) {
                         line +="\"}";
                         output->print (line.c_str());
@@ -582,6 +809,37 @@ bool Commands::ESP420(const char* cmd_params, level_authenticate_type auth_type,
                     output->printMSGLine(line.c_str());
                 }
                 line="";
+                //websocket latency
+                if (json) {
+                    line +=",{\"id\":\"";
+                }
+                line +="Websocket latency";
+                if (json) {
+                    line +="\",\"value\":\"";
+                } else {
+                    line +=": ";
+                }
+                line+="avg ";
+                line+=String(websocket_data_server.averageLatency());
+                line+=" ms, max ";
+                line+=String(websocket_data_server.maxLatency());
+                line+=" ms, ";
+                line+=String(websocket_data_server.framesSent());
+                line+=" frames";
+#if defined (ESP_WS_DEFLATE_FEATURE)
+                line+=", compressed ";
+                line+=String(websocket_data_server.compressionRatio());
+                line+="%, ";
+                line+=String(websocket_data_server.compressionCost());
+                line+=" us/KB";
+#endif //ESP_WS_DEFLATE_FEATURE
+                if (json) {
+                    line +="\"}";
+                    output->print (line.c_str());
+                } else {
+                    output->printMSGLine(line.c_str());
+                }
+                line="";
             }
 #endif //WS_DATA_FEATURE
 #if defined (CAMERA_DEVICE)
@@ -1570,7 +1828,8 @@ bool Commands::ESP420(const char* cmd_params, level_authenticate_type auth_type,
             } else {
                 line +=": ";
             }
-            line +="MKS";
+            line +="MKS, commands lost ";
+            line += String(MKSService::commandsLost());
             if (json) {
                 line +="\"}";
                 output->print (line.c_str());
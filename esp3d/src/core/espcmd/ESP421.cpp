@@ -0,0 +1,118 @@
+/*
+ ESP421.cpp - ESP3D command class
+
+ Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+ This code is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with This code; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "../../include/esp3d_config.h"
+#if defined (ESP_PROFILER_FEATURE)
+#include "../commands.h"
+#include "../esp3doutput.h"
+#include "../profiler.h"
+#include "../../modules/authentication/authentication_service.h"
+//Get time spent in each service of main loop, in microseconds
+//output is JSON or plain text according parameter
+//cmd can be RESET to clear statistics
+//[ESP421]<cmd> json=<no> <pwd=admin/user>
+#define COMMANDID   421
+bool Commands::ESP421(const char* cmd_params, level_authenticate_type auth_type, ESP3DOutput * output)
+{
+    bool noError = true;
+    bool json = has_tag (cmd_params, "json");
+    String response;
+    String parameter;
+    int errorCode = 200; //unless it is a server error use 200 as default and set error in json instead
+#ifdef AUTHENTICATION_FEATURE
+    if (auth_type == LEVEL_GUEST) {
+        response = format_response(COMMANDID, json, false, "Guest user can't use this command");
+        noError = false;
+        errorCode = 401;
+    }
+#else
+    (void)auth_type;
+#endif //AUTHENTICATION_FEATURE
+    if (noError) {
+        if (has_tag(cmd_params,"RESET")) {
+            LoopProfiler::reset();
+            response = format_response(COMMANDID, json, true, "ok");
+        } else {
+            parameter = clean_param(get_param (cmd_params, ""));
+            if (parameter.length() == 0) {
+                String line = "";
+                bool first = true;
+                if (json) {
+                    output->print ("{\"cmd\":\"421\",\"status\":\"ok\",\"data\":[");
+                }
+                for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+                    //only services really called
+                    if (LoopProfiler::calls(i) == 0) {
+                        continue;
+                    }
+                    line = "";
+                    if (json) {
+                        if (!first) {
+                            line += ",";
+                        }
+                        line += "{\"id\":\"";
+                        line += LoopProfiler::name(i);
+                        line += "\",\"calls\":\"";
+                        line += String(LoopProfiler::calls(i));
+                        line += "\",\"avg\":\"";
+                        line += String(LoopProfiler::average(i));
+                        line += "\",\"max\":\"";
+                        line += String(LoopProfiler::maxDuration(i));
+                        line += "\",\"p99\":\"";
+                        line += String(LoopProfiler::percentile(i, 99));
+                        line += "\"}";
+                        output->print (line.c_str());
+                    } else {
+                        line += LoopProfiler::name(i);
+                        line += ": ";
+                        line += String(LoopProfiler::calls(i));
+                        line += " calls, avg ";
+                        line += String(LoopProfiler::average(i));
+                        line += " us, max ";
+                        line += String(LoopProfiler::maxDuration(i));
+                        line += " us, p99 ";
+                        line += String(LoopProfiler::percentile(i, 99));
+                        line += " us";
+                        output->printMSGLine (line.c_str());
+                    }
+                    first = false;
+                }
+                if (json) {
+                    output->printLN ("]}");
+                }
+                return true;
+            } else {
+                response = format_response(COMMANDID, json, false, "Invalid parameter");
+                noError = false;
+            }
+        }
+    }
+    if (noError) {
+        if (json) {
+            output->printLN (response.c_str() );
+        } else {
+            output->printMSG (response.c_str() );
+        }
+    } else {
+        output->printERROR(response.c_str(), errorCode);
+    }
+    return noError;
+}
+
+#endif //ESP_PROFILER_FEATURE
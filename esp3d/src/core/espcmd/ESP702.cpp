@@ -0,0 +1,199 @@
+/*
+ ESP702.cpp - ESP3D command class
+
+ Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+ This code is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with This code; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "../../include/esp3d_config.h"
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+#include "../commands.h"
+#include "../esp3doutput.h"
+#include "../../modules/authentication/authentication_service.h"
+#include "../../modules/printer_status/printer_status.h"
+#if defined(GCODE_HOST_FEATURE)
+#include "../../modules/gcode_host/gcode_host.h"
+#endif //GCODE_HOST_FEATURE
+#define COMMANDID   702
+
+static const char * const heaterNames[STATUS_HEATERS] = {"T0", "T1", "B", "C"};
+static const char * const axisNames[STATUS_AXIS] = {"X", "Y", "Z", "E"};
+
+//time since last report in ms, -1 if never reported
+static String reportAge(uint8_t report)
+{
+    uint32_t last = PrinterStatus::lastReport(report);
+    if (last == 0) {
+        return "-1";
+    }
+    return String(millis() - last);
+}
+
+//Get last printer state known by ESP, printer is not queried
+//POLL set time in ms between 2 polls of printer by ESP, 0 to disable
+//output is JSON or plain text according parameter
+//[ESP702]<POLL=<ms>> json=<no> <pwd=admin/user>
+bool Commands::ESP702(const char* cmd_params, level_authenticate_type auth_type, ESP3DOutput * output)
+{
+    bool noError = true;
+    bool json = has_tag (cmd_params, "json");
+    String response;
+    String parameter;
+    int errorCode = 200; //unless it is a server error use 200 as default and set error in json instead
+#ifdef AUTHENTICATION_FEATURE
+    if (auth_type == LEVEL_GUEST) {
+        response = format_response(COMMANDID, json, false, "Guest user can't use this command");
+        noError = false;
+        errorCode = 401;
+    }
+#else
+    (void)auth_type;
+#endif //AUTHENTICATION_FEATURE
+    if (noError) {
+        parameter = get_param (cmd_params, "POLL=");
+        if (parameter.length() != 0) {
+#ifdef AUTHENTICATION_FEATURE
+            if (auth_type != LEVEL_ADMIN) {
+                response = format_response(COMMANDID, json, false, "Wrong authentication level");
+                noError = false;
+                errorCode = 401;
+            }
+#endif //AUTHENTICATION_FEATURE
+            if (noError) {
+                PrinterStatus::setPollInterval(parameter.toInt());
+                response = format_response(COMMANDID, json, true, "ok");
+            }
+        } else {
+            const esp3d_printer_status_t & state = PrinterStatus::state();
+            uint8_t printing = state.printing;
+            uint32_t printed = state.printed;
+            uint32_t size = state.size;
+#if defined(GCODE_HOST_FEATURE)
+            //stream from ESP is more accurate than printer SD report
+            if (esp3d_gcode_host.getStatus() != HOST_NO_STREAM) {
+                printing = 1;
+                printed = esp3d_gcode_host.processedSize();
+                size = esp3d_gcode_host.totalSize();
+            }
+#endif //GCODE_HOST_FEATURE
+            String line = "";
+            if (json) {
+                line = "{\"cmd\":\"702\",\"status\":\"ok\",\"data\":{\"heaters\":[";
+                bool first = true;
+                for (uint8_t i = 0; i < STATUS_HEATERS; i++) {
+                    if (!(PrinterStatus::heaters() & (1 << i))) {
+                        continue;
+                    }
+                    if (!first) {
+                        line += ",";
+                    }
+                    first = false;
+                    line += "{\"id\":\"";
+                    line += heaterNames[i];
+                    line += "\",\"value\":\"";
+                    line += String(state.temperature[i] / 10.0, 1);
+                    line += "\",\"target\":\"";
+                    line += String(state.target[i] / 10.0, 1);
+                    line += "\"}";
+                }
+                line += "],\"position\":{";
+                for (uint8_t i = 0; i < STATUS_AXIS; i++) {
+                    if (i > 0) {
+                        line += ",";
+                    }
+                    line += "\"";
+                    line += axisNames[i];
+                    line += "\":\"";
+                    line += String(state.position[i] / 100.0, 2);
+                    line += "\"";
+                }
+                line += "},\"printing\":\"";
+                line += printing?"yes":"no";
+                line += "\",\"printed\":\"";
+                line += String(printed);
+                line += "\",\"size\":\"";
+                line += String(size);
+                line += "\",\"age\":{\"heaters\":\"";
+                line += reportAge(STATUS_REPORT_TEMPERATURE);
+                line += "\",\"position\":\"";
+                line += reportAge(STATUS_REPORT_POSITION);
+                line += "\",\"progress\":\"";
+                line += reportAge(STATUS_REPORT_PROGRESS);
+                line += "\"},\"poll\":\"";
+                line += String(PrinterStatus::pollInterval());
+                line += "\"}}";
+                output->printLN (line.c_str());
+                return true;
+            }
+            for (uint8_t i = 0; i < STATUS_HEATERS; i++) {
+                if (!(PrinterStatus::heaters() & (1 << i))) {
+                    continue;
+                }
+                line = heaterNames[i];
+                line += ": ";
+                line += String(state.temperature[i] / 10.0, 1);
+                line += " / ";
+                line += String(state.target[i] / 10.0, 1);
+                output->printMSGLine (line.c_str());
+            }
+            line = "Position:";
+            for (uint8_t i = 0; i < STATUS_AXIS; i++) {
+                line += " ";
+                line += axisNames[i];
+                line += ":";
+                line += String(state.position[i] / 100.0, 2);
+            }
+            output->printMSGLine (line.c_str());
+            line = "Printing: ";
+            if (printing) {
+                line += String(printed);
+                line += "/";
+                line += String(size);
+                if (size > 0) {
+                    line += " (";
+                    line += String((uint32_t)(((uint64_t)printed * 100) / size));
+                    line += "%)";
+                }
+            } else {
+                line += "no";
+            }
+            output->printMSGLine (line.c_str());
+            line = "Last reports (ms): heaters ";
+            line += reportAge(STATUS_REPORT_TEMPERATURE);
+            line += ", position ";
+            line += reportAge(STATUS_REPORT_POSITION);
+            line += ", progress ";
+            line += reportAge(STATUS_REPORT_PROGRESS);
+            output->printMSGLine (line.c_str());
+            line = "Poll: ";
+            line += String(PrinterStatus::pollInterval());
+            line += " ms";
+            output->printMSGLine (line.c_str());
+            return true;
+        }
+    }
+    if (noError) {
+        if (json) {
+            output->printLN (response.c_str() );
+        } else {
+            output->printMSG (response.c_str() );
+        }
+    } else {
+        output->printERROR(response.c_str(), errorCode);
+    }
+    return noError;
+}
+
+#endif //ESP_STATUS_CHANNEL_FEATURE
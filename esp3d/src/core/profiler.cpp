@@ -0,0 +1,161 @@
+/*
+  profiler.cpp -  loop profiler functions class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "../include/esp3d_config.h"
+#if defined(ESP_PROFILER_FEATURE)
+#include "profiler.h"
+
+typedef struct {
+    uint32_t calls;
+    uint64_t total;
+    uint32_t max;
+    uint16_t histogram[PROFILE_BUCKETS];
+} esp3d_profile_t;
+
+static esp3d_profile_t profiles[PROFILE_COUNT];
+
+static const char * const profileNames[PROFILE_COUNT] = {
+    "loop",
+    "serial",
+    "serial bridge",
+    "socket serial",
+    "network",
+    "devices",
+    "gcode host",
+    "output",
+    "settings",
+    "mks",
+    "mdns",
+    "ota",
+    "captive portal",
+    "http",
+    "webdav",
+    "websocket data",
+    "websocket terminal",
+    "telnet",
+    "ftp",
+    "notifications",
+    "status channel"
+};
+
+//bucket 2n is [2^n, 1.5*2^n[ and bucket 2n+1 is [1.5*2^n, 2^(n+1)[
+uint8_t LoopProfiler::_bucket(uint32_t duration)
+{
+    if (duration < 2) {
+        return duration;
+    }
+    uint8_t msb = 31 - __builtin_clz(duration);
+    uint8_t bucket = (2 * msb) + ((duration >> (msb - 1)) & 1);
+    return (bucket < PROFILE_BUCKETS)?bucket:(PROFILE_BUCKETS - 1);
+}
+
+//first duration above bucket
+uint32_t LoopProfiler::_bucketLimit(uint8_t bucket)
+{
+    if (bucket < 2) {
+        return bucket + 1;
+    }
+    uint8_t msb = bucket / 2;
+    if (bucket & 1) {
+        return 1UL << (msb + 1);
+    }
+    return (1UL << msb) + (1UL << (msb - 1));
+}
+
+void LoopProfiler::record(uint8_t id, uint32_t duration)
+{
+    if (id >= PROFILE_COUNT) {
+        return;
+    }
+    esp3d_profile_t & profile = profiles[id];
+    profile.calls++;
+    profile.total += duration;
+    if (duration > profile.max) {
+        profile.max = duration;
+    }
+    uint16_t & count = profile.histogram[_bucket(duration)];
+    if (count == 0xFFFF) {
+        //keep the shape of the histogram, older calls weight less
+        for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+            profile.histogram[i] /= 2;
+        }
+    }
+    count++;
+}
+
+void LoopProfiler::reset()
+{
+    memset(profiles, 0, sizeof(profiles));
+}
+
+const char * LoopProfiler::name(uint8_t id)
+{
+    return (id < PROFILE_COUNT)?profileNames[id]:"";
+}
+
+uint32_t LoopProfiler::calls(uint8_t id)
+{
+    return (id < PROFILE_COUNT)?profiles[id].calls:0;
+}
+
+uint32_t LoopProfiler::average(uint8_t id)
+{
+    if ((id >= PROFILE_COUNT) || (profiles[id].calls == 0)) {
+        return 0;
+    }
+    return profiles[id].total / profiles[id].calls;
+}
+
+uint32_t LoopProfiler::maxDuration(uint8_t id)
+{
+    return (id < PROFILE_COUNT)?profiles[id].max:0;
+}
+
+uint32_t LoopProfiler::percentile(uint8_t id, uint8_t pct)
+{
+    if (id >= PROFILE_COUNT) {
+        return 0;
+    }
+    esp3d_profile_t & profile = profiles[id];
+    uint32_t count = 0;
+    for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+        count += profile.histogram[i];
+    }
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t target = ((count * pct) + 99) / 100;
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+        sum += profile.histogram[i];
+        if (sum >= target) {
+            //last bucket has no limit
+            if (i == (PROFILE_BUCKETS - 1)) {
+                return profile.max;
+            }
+            //bucket limit is an upper bound, max is exact
+            uint32_t limit = _bucketLimit(i) - 1;
+            return (limit < profile.max)?limit:profile.max;
+        }
+    }
+    return profile.max;
+}
+
+#endif //ESP_PROFILER_FEATURE
@@ -0,0 +1,76 @@
+/*
+  profiler.h -  loop profiler functions class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _PROFILER_ESP3D_H
+#define _PROFILER_ESP3D_H
+#include "../include/esp3d_config.h"
+
+//Timed services
+#define PROFILE_LOOP            0
+#define PROFILE_SERIAL          1
+#define PROFILE_SERIAL_BRIDGE   2
+#define PROFILE_SOCKET_SERIAL   3
+#define PROFILE_NETWORK         4
+#define PROFILE_DEVICES         5
+#define PROFILE_GCODE_HOST      6
+#define PROFILE_OUTPUT          7
+#define PROFILE_SETTINGS        8
+#define PROFILE_MKS             9
+#define PROFILE_MDNS            10
+#define PROFILE_OTA             11
+#define PROFILE_CAPTIVE_PORTAL  12
+#define PROFILE_HTTP            13
+#define PROFILE_WEBDAV          14
+#define PROFILE_WS_DATA         15
+#define PROFILE_WS_TERMINAL     16
+#define PROFILE_TELNET          17
+#define PROFILE_FTP             18
+#define PROFILE_NOTIFICATIONS   19
+#define PROFILE_STATUS          20
+#define PROFILE_COUNT           21
+
+//Histogram of durations: 2 buckets per power of 2 of microseconds,
+//last one gets everything above ~0.8s
+#define PROFILE_BUCKETS 40
+
+#if defined(ESP_PROFILER_FEATURE)
+class LoopProfiler
+{
+public:
+    static void record(uint8_t id, uint32_t duration);
+    static void reset();
+    static const char * name(uint8_t id);
+    static uint32_t calls(uint8_t id);
+    static uint32_t average(uint8_t id);
+    static uint32_t maxDuration(uint8_t id);
+    //upper bound of duration of pct % of the calls
+    static uint32_t percentile(uint8_t id, uint8_t pct);
+private:
+    static uint8_t _bucket(uint32_t duration);
+    static uint32_t _bucketLimit(uint8_t bucket);
+};
+
+//Time a service handle call in microseconds
+#define PROFILE_HANDLE(id, call) { uint32_t profile_start = micros(); call; LoopProfiler::record(id, micros() - profile_start); }
+#else
+#define PROFILE_HANDLE(id, call) { call; }
+#endif //ESP_PROFILER_FEATURE
+
+#endif //_PROFILER_ESP3D_H
@@ -27,6 +27,7 @@
 #include <EEPROM.h>
 //EEPROM SIZE (Up to 4096)
 #define EEPROM_SIZE     2048 //max is 2048
+#define SETTINGS_CACHE_SIZE EEPROM_SIZE
 #endif //SETTINGS_IN_EEPROM
 
 #if defined (WIFI_FEATURE) || defined(ETH_FEATURE)
@@ -40,8 +41,20 @@
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
 #include <Preferences.h>
 #define NAMESPACE "ESP3D"
+//RAM copy use same layout as EEPROM, so size is end of last setting
+#define SETTINGS_CACHE_SIZE (ESP_SERIAL_BRIDGE_BAUD + 4)
 #endif // SETTINGS_IN_PREFERENCES
 
+//Delay without write before modified settings are saved to flash
+#define SETTINGS_COMMIT_DELAY 1000
+//Delay before saving again if last save failed
+#define SETTINGS_COMMIT_RETRY_DELAY 10000
+
+//Settings types
+#define SETTINGS_TYPE_BYTE      0
+#define SETTINGS_TYPE_INT32     1
+#define SETTINGS_TYPE_STRING    2
+
 //Current Settings Version
 #define CURRENT_SETTINGS_VERSION "ESP3D04"
 
@@ -172,18 +185,30 @@ const char DEFAULT_SETTINGS_VERSION []  =   "ESP3D";
 
 #if defined (WIFI_FEATURE) ||defined (ETH_FEATURE)
 //default IP values
-const uint8_t DEFAULT_IP_VALUE[]   =       {192, 168, 0, 1};
-const uint8_t DEFAULT_MASK_VALUE[]  =      {255, 255, 255, 0};
+#define DEFAULT_IP_VALUE            SETTING_IP(192, 168, 0, 1)
+#define DEFAULT_MASK_VALUE          SETTING_IP(255, 255, 255, 0)
 #define DEFAULT_GATEWAY_VALUE           DEFAULT_IP_VALUE
 #define DEFAULT_DNS_VALUE           DEFAULT_GATEWAY_VALUE
-const uint8_t DEFAULT_ADDRESS_VALUE[]   =  {0, 0, 0, 0};
 #endif //WIFI_FEATURE || ETH_FEATURE
 
 uint8_t Settings_ESP3D::_FirmwareTarget = DEFAULT_FW;
 bool Settings_ESP3D::_isverboseboot = DEFAULT_VERBOSE_BOOT;
+bool Settings_ESP3D::_cacheStarted = false;
+bool Settings_ESP3D::_dirty = false;
+uint32_t Settings_ESP3D::_lastWrite = 0;
+bool Settings_ESP3D::_commitFailed = false;
+uint32_t Settings_ESP3D::_cacheHits = 0;
+uint32_t Settings_ESP3D::_flashCommits = 0;
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+uint8_t Settings_ESP3D::_cache[SETTINGS_CACHE_SIZE];
+uint8_t Settings_ESP3D::_cacheLoaded[(SETTINGS_CACHE_SIZE / 8) + 1];
+#endif //SETTINGS_IN_PREFERENCES
 
 bool Settings_ESP3D::begin()
 {
+    if (!_cacheBegin()) {
+        return false;
+    }
     if(GetSettingsVersion() == -1) {
         return false;
     }
@@ -248,366 +273,322 @@ const char* Settings_ESP3D::GetFirmwareTargetShortName()
     return response.c_str();
 }
 
-//Default value for a byte setting
-uint8_t Settings_ESP3D::get_default_byte_value(int pos)
-{
-    uint8_t res;
-    switch(pos) {
-    case ESP_BOOT_RADIO_STATE:
-        res = DEFAULT_BOOT_RADIO_STATE;
-        break;
-    case ESP_STA_FALLBACK_MODE:
-        res = DEFAULT_STA_FALLBACK_MODE;
-        break;
-#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
-    case ESP_SECURE_SERIAL:
-        res = DEFAULT_SECURE_SERIAL;
-        break;
-#endif //#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
-    case ESP_RADIO_MODE:
-        res = DEFAULT_ESP_RADIO_MODE;
-        break;
-    case ESP_VERBOSE_BOOT:
-        res = DEFAULT_VERBOSE_BOOT;
-        break;
-    case ESP_SETUP:
-        res = DEFAULT_SETUP;
-        break;
-#ifdef AUTHENTICATION_FEATURE
-    case ESP_SESSION_TIMEOUT:
-        res = DEFAULT_SESSION_TIMEOUT;
-        break;
-#endif //AUTHENTICATION_FEATURE
-#ifdef TIMESTAMP_FEATURE
-    case ESP_INTERNET_TIME:
-        res = DEFAULT_INTERNET_TIME;
-        break;
-#endif //TIMESTAMP_FEATURE
-#ifdef BUZZER_DEVICE
-    case ESP_BUZZER:
-        res = DEFAULT_BUZZER_STATE;
-        break;
-#endif //BUZZER_DEVICE
-#ifdef NOTIFICATION_FEATURE
-    case ESP_NOTIFICATION_TYPE:
-        res = DEFAULT_NOTIFICATION_TYPE;
-        break;
-    case ESP_AUTO_NOTIFICATION:
-        res = DEFAULT_AUTO_NOTIFICATION_STATE;
-        break;
-#endif //NOTIFICATION_FEATURE
+//Options lists
+#define SETTING_STR(x) #x
+#define SETTING_XSTR(x) SETTING_STR(x)
+#define SETTING_NO_YES "{\"no\":\"0\"},{\"yes\":\"1\"}"
+#ifdef WIFI_FEATURE
+#define SETTING_RADIO_WIFI ",{\"sta\":\"1\"},{\"ap\":\"2\"},{\"setup\":\"5\"}"
+#define SETTING_FALLBACK_WIFI ",{\"setup\":\"5\"}"
+#else
+#define SETTING_RADIO_WIFI ""
+#define SETTING_FALLBACK_WIFI ""
+#endif //WIFI_FEATURE
+#ifdef BLUETOOTH_FEATURE
+#define SETTING_RADIO_BT ",{\"bt\":\"3\"}"
+#else
+#define SETTING_RADIO_BT ""
+#endif //BLUETOOTH_FEATURE
+#ifdef ETH_FEATURE
+#define SETTING_RADIO_ETH ",{\"eth-sta\":\"4\"}"
+#else
+#define SETTING_RADIO_ETH ""
+#endif //ETH_FEATURE
+
+//IP address as stored, first byte is the lowest
+#define SETTING_IP(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+//Entries helpers
+#define SETTING_LIST(pos, flags, section, label, list, def) {pos, 'B', flags, SETTING_OPTIONS_LIST, 0, 255, def, section, label, list}
+#define SETTING_BYTE(pos, flags, section, label, min, max, def) {pos, 'B', flags, SETTING_OPTIONS_NONE, min, max, def, section, label, nullptr}
+#define SETTING_RANGE(pos, flags, section, label, min, max, def) {pos, 'B', flags, SETTING_OPTIONS_RANGE, min, max, def, section, label, nullptr}
+#define SETTING_INT(pos, flags, section, label, min, max, def) {pos, 'I', flags, SETTING_OPTIONS_NONE, min, max, def, section, label, nullptr}
+#define SETTING_BAUD(pos, flags, section, label, def) {pos, 'I', flags, SETTING_OPTIONS_BAUD, 0, 0, def, section, label, nullptr}
+#define SETTING_ADDRESS(pos, flags, section, label, def) {pos, 'A', flags, SETTING_OPTIONS_NONE, 0, 0, def, section, label, nullptr}
+#define SETTING_STRING(pos, flags, section, label, min, max, def) {pos, 'S', flags, SETTING_OPTIONS_NONE, min, max, 0, section, label, def}
+
+//Settings of disabled features keep their default but are not listed
+#if defined (WIFI_FEATURE) || defined (ETH_FEATURE) || defined (BLUETOOTH_FEATURE)
+#define SETTING_RADIO_VISIBILITY 0
+#else
+#define SETTING_RADIO_VISIBILITY SETTING_FLAG_INTERNAL
+#endif //WIFI_FEATURE || ETH_FEATURE || BLUETOOTH_FEATURE
+
+static const esp3d_setting_desc_t settingsTable[] = {
+#if defined (WIFI_FEATURE) || defined (ETH_FEATURE) || defined (BLUETOOTH_FEATURE)
+    SETTING_STRING(ESP_HOSTNAME, SETTING_FLAG_REBOOT, "network/network", "hostname", MIN_HOSTNAME_LENGTH, MAX_HOSTNAME_LENGTH, DEFAULT_HOSTNAME),
+#endif //WIFI_FEATURE || ETH_FEATURE || BLUETOOTH_FEATURE
+    SETTING_LIST(ESP_RADIO_MODE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/network", "radio mode", "{\"none\":\"0\"}" SETTING_RADIO_WIFI SETTING_RADIO_BT SETTING_RADIO_ETH, DEFAULT_ESP_RADIO_MODE),
+    SETTING_LIST(ESP_BOOT_RADIO_STATE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK | SETTING_RADIO_VISIBILITY, "network/network", "radio_boot", SETTING_NO_YES, DEFAULT_BOOT_RADIO_STATE),
+#ifdef WIFI_FEATURE
+    SETTING_STRING(ESP_STA_SSID, SETTING_FLAG_NETWORK, "network/sta", "SSID", MIN_SSID_LENGTH, MAX_SSID_LENGTH, DEFAULT_STA_SSID),
+    SETTING_STRING(ESP_STA_PASSWORD, SETTING_FLAG_REBOOT | SETTING_FLAG_SECRET | SETTING_FLAG_NULLABLE | SETTING_FLAG_NETWORK, "network/sta", "pwd", MIN_PASSWORD_LENGTH, MAX_PASSWORD_LENGTH, DEFAULT_STA_PASSWORD),
+#endif //WIFI_FEATURE
 #if defined (WIFI_FEATURE) || defined (ETH_FEATURE)
-    case ESP_STA_IP_MODE:
-        res = DEFAULT_STA_IP_MODE;
-        break;
+    SETTING_LIST(ESP_STA_IP_MODE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/sta", "ip mode", "{\"dhcp\":\"1\"},{\"static\":\"0\"}", DEFAULT_STA_IP_MODE),
+    SETTING_ADDRESS(ESP_STA_IP_VALUE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/sta", "ip", DEFAULT_IP_VALUE),
+    SETTING_ADDRESS(ESP_STA_GATEWAY_VALUE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/sta", "gw", DEFAULT_GATEWAY_VALUE),
+    SETTING_ADDRESS(ESP_STA_MASK_VALUE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/sta", "msk", DEFAULT_MASK_VALUE),
+    SETTING_ADDRESS(ESP_STA_DNS_VALUE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/sta", "DNS", DEFAULT_DNS_VALUE),
 #endif //WIFI_FEATURE || ETH_FEATURE
-#if defined (WIFI_FEATURE)
-    case ESP_AP_CHANNEL:
-        res = DEFAULT_AP_CHANNEL;
-        break;
+    SETTING_LIST(ESP_STA_FALLBACK_MODE, SETTING_FLAG_NETWORK | SETTING_RADIO_VISIBILITY, "network/sta", "sta fallback mode", "{\"none\":\"0\"}" SETTING_FALLBACK_WIFI SETTING_RADIO_BT, DEFAULT_STA_FALLBACK_MODE),
+#ifdef WIFI_FEATURE
+    SETTING_STRING(ESP_AP_SSID, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/ap", "SSID", MIN_SSID_LENGTH, MAX_SSID_LENGTH, DEFAULT_AP_SSID),
+    SETTING_STRING(ESP_AP_PASSWORD, SETTING_FLAG_REBOOT | SETTING_FLAG_SECRET | SETTING_FLAG_NULLABLE | SETTING_FLAG_NETWORK, "network/ap", "pwd", MIN_PASSWORD_LENGTH, MAX_PASSWORD_LENGTH, DEFAULT_AP_PASSWORD),
+    SETTING_ADDRESS(ESP_AP_IP_VALUE, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/ap", "ip", DEFAULT_IP_VALUE),
+    SETTING_RANGE(ESP_AP_CHANNEL, SETTING_FLAG_REBOOT | SETTING_FLAG_NETWORK, "network/ap", "channel", MIN_CHANNEL, MAX_CHANNEL, DEFAULT_AP_CHANNEL),
 #endif //WIFI_FEATURE
-    case ESP_SERIAL_FLAG:
-        res = DEFAULT_SERIAL_OUTPUT_FLAG;
-        break;
-    case ESP_REMOTE_SCREEN_FLAG:
-        res = DEFAULT_REMOTE_SCREEN_FLAG;
-        break;
-    case ESP_WEBSOCKET_FLAG:
-        res = DEFAULT_WEBSOCKET_FLAG;
-        break;
-    case ESP_TELNET_FLAG:
-        res = DEFAULT_TELNET_FLAG;
-        break;
-    case ESP_BT_FLAG:
-        res = DEFAULT_BT_FLAG;
-        break;
-#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
-    case ESP_SERIAL_BRIDGE_FLAG:
-        res = DEFAULT_SERIAL_BRIDGE_FLAG;
-        break;
-    case ESP_SERIAL_BRIDGE_ON:
-        res = DEFAULT_SERIAL_BRIDGE_ON;
-        break;
-#endif //defined()
-    case ESP_SCREEN_FLAG:
-        res = DEFAULT_SCREEN_FLAG;
-        break;
-#ifdef FTP_FEATURE
-    case ESP_FTP_ON:
-        res = DEFAULT_FTP_ON;
-        break;
-#endif //FTP_FEATURE
+#ifdef AUTHENTICATION_FEATURE
+    SETTING_STRING(ESP_ADMIN_PWD, SETTING_FLAG_SECRET, "security/security", "adm pwd", MIN_LOCAL_PASSWORD_LENGTH, MAX_LOCAL_PASSWORD_LENGTH, DEFAULT_ADMIN_PWD),
+    SETTING_STRING(ESP_USER_PWD, SETTING_FLAG_SECRET, "security/security", "user pwd", MIN_LOCAL_PASSWORD_LENGTH, MAX_LOCAL_PASSWORD_LENGTH, DEFAULT_USER_PWD),
+    SETTING_BYTE(ESP_SESSION_TIMEOUT, SETTING_FLAG_REBOOT, "security/security", "session timeout", 0, 255, DEFAULT_SESSION_TIMEOUT),
+#endif //AUTHENTICATION_FEATURE
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+#ifdef AUTHENTICATION_FEATURE
+    SETTING_LIST(ESP_SECURE_SERIAL, 0, "security/security", "serial", SETTING_NO_YES, DEFAULT_SECURE_SERIAL),
+#else
+    SETTING_LIST(ESP_SECURE_SERIAL, SETTING_FLAG_INTERNAL, "security/security", "serial", SETTING_NO_YES, DEFAULT_SECURE_SERIAL),
+#endif //AUTHENTICATION_FEATURE
+#endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
 #ifdef HTTP_FEATURE
-    case ESP_HTTP_ON:
-        res = DEFAULT_HTTP_ON;
-        break;
+    SETTING_LIST(ESP_HTTP_ON, SETTING_FLAG_REBOOT, "service/http", "enable", SETTING_NO_YES, DEFAULT_HTTP_ON),
+    SETTING_INT(ESP_HTTP_PORT, SETTING_FLAG_REBOOT, "service/http", "port", MIN_HTTP_PORT, MAX_HTTP_PORT, DEFAULT_HTTP_PORT),
 #endif //HTTP_FEATURE
 #ifdef TELNET_FEATURE
-    case ESP_TELNET_ON:
-        res = DEFAULT_TELNET_ON;
-        break;
+    SETTING_LIST(ESP_TELNET_ON, SETTING_FLAG_REBOOT, "service/telnetp", "enable", SETTING_NO_YES, DEFAULT_TELNET_ON),
+    SETTING_INT(ESP_TELNET_PORT, SETTING_FLAG_REBOOT, "service/telnetp", "port", MIN_TELNET_PORT, MAX_TELNET_PORT, DEFAULT_TELNET_PORT),
 #endif //TELNET_FEATURE
 #ifdef WS_DATA_FEATURE
-    case ESP_WEBSOCKET_ON:
-        res = DEFAULT_WEBSOCKET_ON;
-        break;
+    SETTING_LIST(ESP_WEBSOCKET_ON, SETTING_FLAG_REBOOT, "service/websocketp", "enable", SETTING_NO_YES, DEFAULT_WEBSOCKET_ON),
+    SETTING_INT(ESP_WEBSOCKET_PORT, SETTING_FLAG_REBOOT, "service/websocketp", "port", MIN_WEBSOCKET_PORT, MAX_WEBSOCKET_PORT, DEFAULT_WEBSOCKET_PORT),
 #endif //WS_DATA_FEATURE
 #ifdef WEBDAV_FEATURE
-    case ESP_WEBDAV_ON:
-        res = DEFAULT_WEBDAV_ON;
-        break;
+    SETTING_LIST(ESP_WEBDAV_ON, SETTING_FLAG_REBOOT, "service/webdavp", "enable", SETTING_NO_YES, DEFAULT_WEBDAV_ON),
+    SETTING_INT(ESP_WEBDAV_PORT, SETTING_FLAG_REBOOT, "service/webdavp", "port", MIN_WEBDAV_PORT, MAX_WEBDAV_PORT, DEFAULT_WEBDAV_PORT),
 #endif //WEBDAV_FEATURE
-#ifdef SD_DEVICE
-    case ESP_SD_SPEED_DIV:
-        res = DEFAULT_SDREADER_SPEED;
-        break;
-    case ESP_SD_MOUNT:
-        res = DEFAULT_SD_MOUNT;
-        break;
-    case ESP_SD_CHECK_UPDATE_AT_BOOT:
-        res = DEFAULT_SD_CHECK_UPDATE_AT_BOOT;
-        break;
-#endif //SD_DEVICE
-    case ESP_TARGET_FW:
-        res = DEFAULT_FW;
-        break;
+#ifdef FTP_FEATURE
+    SETTING_LIST(ESP_FTP_ON, SETTING_FLAG_REBOOT, "service/ftp", "enable", SETTING_NO_YES, DEFAULT_FTP_ON),
+    SETTING_INT(ESP_FTP_CTRL_PORT, SETTING_FLAG_REBOOT, "service/ftp", "control port", MIN_FTP_PORT, MAX_FTP_PORT, DEFAULT_FTP_CTRL_PORT),
+    SETTING_INT(ESP_FTP_DATA_ACTIVE_PORT, SETTING_FLAG_REBOOT, "service/ftp", "active port", MIN_FTP_PORT, MAX_FTP_PORT, DEFAULT_FTP_ACTIVE_PORT),
+    SETTING_INT(ESP_FTP_DATA_PASSIVE_PORT, SETTING_FLAG_REBOOT, "service/ftp", "passive port", MIN_FTP_PORT, MAX_FTP_PORT, DEFAULT_FTP_PASSIVE_PORT),
+#endif //FTP_FEATURE
+#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    SETTING_LIST(ESP_SERIAL_BRIDGE_ON, 0, "service/serial_bridge", "enable", SETTING_NO_YES, DEFAULT_SERIAL_BRIDGE_ON),
+    SETTING_BAUD(ESP_SERIAL_BRIDGE_BAUD, 0, "service/serial_bridge", "baud", DEFAULT_SERIAL_BRIDGE_BAUD_RATE),
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
 #ifdef TIMESTAMP_FEATURE
-    case ESP_TIMEZONE:
-        res = DEFAULT_TIME_ZONE;
-        break;
-    case ESP_TIME_IS_DST:
-        res = DEFAULT_TIME_DST;
-        break;
+    SETTING_LIST(ESP_INTERNET_TIME, 0, "service/time", "i-time", SETTING_NO_YES, DEFAULT_INTERNET_TIME),
+    SETTING_RANGE(ESP_TIMEZONE, SETTING_FLAG_REBOOT | SETTING_FLAG_SIGNED, "service/time", "tzone", -12, 12, DEFAULT_TIME_ZONE),
+    SETTING_LIST(ESP_TIME_IS_DST, SETTING_FLAG_REBOOT, "service/time", "dst", SETTING_NO_YES, DEFAULT_TIME_DST),
+    SETTING_STRING(ESP_TIME_SERVER1, SETTING_FLAG_REBOOT, "service/time", "t-server", MIN_SERVER_ADDRESS_LENGTH, MAX_SERVER_ADDRESS_LENGTH, DEFAULT_TIME_SERVER1),
+    SETTING_STRING(ESP_TIME_SERVER2, SETTING_FLAG_REBOOT, "service/time", "t-server", MIN_SERVER_ADDRESS_LENGTH, MAX_SERVER_ADDRESS_LENGTH, DEFAULT_TIME_SERVER2),
+    SETTING_STRING(ESP_TIME_SERVER3, SETTING_FLAG_REBOOT, "service/time", "t-server", MIN_SERVER_ADDRESS_LENGTH, MAX_SERVER_ADDRESS_LENGTH, DEFAULT_TIME_SERVER3),
 #endif //TIMESTAMP_FEATURE
-
-#if defined(SENSOR_DEVICE)
-    case ESP_SENSOR_TYPE:
-        res = DEFAULT_SENSOR_TYPE;
-        break;
+#ifdef NOTIFICATION_FEATURE
+    SETTING_LIST(ESP_AUTO_NOTIFICATION, SETTING_FLAG_REBOOT, "service/notification", "auto notif", SETTING_NO_YES, DEFAULT_AUTO_NOTIFICATION_STATE),
+    SETTING_LIST(ESP_NOTIFICATION_TYPE, SETTING_FLAG_REBOOT, "service/notification", "notification", "{\"none\":\"0\"},{\"pushover\":\"" SETTING_XSTR(ESP_PUSHOVER_NOTIFICATION) "\"},{\"email\":\"" SETTING_XSTR(ESP_EMAIL_NOTIFICATION) "\"},{\"line\":\"" SETTING_XSTR(ESP_LINE_NOTIFICATION) "\"},{\"telegram\":\"" SETTING_XSTR(ESP_TELEGRAM_NOTIFICATION) "\"},{\"IFTTT\":\"" SETTING_XSTR(ESP_IFTTT_NOTIFICATION) "\"}", DEFAULT_NOTIFICATION_TYPE),
+    SETTING_STRING(ESP_NOTIFICATION_TOKEN1, SETTING_FLAG_REBOOT | SETTING_FLAG_SECRET, "service/notification", "t1", MIN_NOTIFICATION_TOKEN_LENGTH, MAX_NOTIFICATION_TOKEN_LENGTH, DEFAULT_NOTIFICATION_TOKEN1),
+    SETTING_STRING(ESP_NOTIFICATION_TOKEN2, SETTING_FLAG_REBOOT | SETTING_FLAG_SECRET, "service/notification", "t2", MIN_NOTIFICATION_TOKEN_LENGTH, MAX_NOTIFICATION_TOKEN_LENGTH, DEFAULT_NOTIFICATION_TOKEN2),
+    SETTING_STRING(ESP_NOTIFICATION_SETTINGS, SETTING_FLAG_REBOOT, "service/notification", "ts", MIN_NOTIFICATION_SETTINGS_LENGTH, MAX_NOTIFICATION_SETTINGS_LENGTH, DEFAULT_NOTIFICATION_SETTINGS),
+#endif //NOTIFICATION_FEATURE
+#ifdef BUZZER_DEVICE
+    SETTING_LIST(ESP_BUZZER, 0, "device/device", "buzzer", SETTING_NO_YES, DEFAULT_BUZZER_STATE),
+#endif //BUZZER_DEVICE
+#ifdef SENSOR_DEVICE
+    {ESP_SENSOR_TYPE, 'B', 0, SETTING_OPTIONS_SENSOR, 0, 255, DEFAULT_SENSOR_TYPE, "device/sensor", "type", nullptr},
+    SETTING_INT(ESP_SENSOR_INTERVAL, 0, "device/sensor", "intervalms", MIN_SENSOR_INTERVAL, MAX_SENSOR_INTERVAL, DEFAULT_SENSOR_INTERVAL),
 #endif //SENSOR_DEVICE
+#ifdef SD_DEVICE
+#if SD_DEVICE != ESP_SDIO
+    SETTING_LIST(ESP_SD_SPEED_DIV, 0, "device/sd", "speedx", "{\"1\":\"1\"},{\"2\":\"2\"},{\"3\":\"3\"},{\"4\":\"4\"},{\"6\":\"6\"},{\"8\":\"8\"},{\"16\":\"16\"},{\"32\":\"32\"}", DEFAULT_SDREADER_SPEED),
+#else
+    SETTING_BYTE(ESP_SD_SPEED_DIV, SETTING_FLAG_INTERNAL, "device/sd", "speedx", 0, 255, DEFAULT_SDREADER_SPEED),
+#endif //SD_DEVICE != ESP_SDIO
+#ifdef SD_UPDATE_FEATURE
+    SETTING_LIST(ESP_SD_CHECK_UPDATE_AT_BOOT, 0, "device/sd", "SD updater", SETTING_NO_YES, DEFAULT_SD_CHECK_UPDATE_AT_BOOT),
+#else
+    SETTING_LIST(ESP_SD_CHECK_UPDATE_AT_BOOT, SETTING_FLAG_INTERNAL, "device/sd", "SD updater", SETTING_NO_YES, DEFAULT_SD_CHECK_UPDATE_AT_BOOT),
+#endif //SD_UPDATE_FEATURE
+    SETTING_BYTE(ESP_SD_MOUNT, SETTING_FLAG_INTERNAL, "device/sd", "mount", 0, 255, DEFAULT_SD_MOUNT),
+#endif //SD_DEVICE
+#if !defined(FIXED_FW_TARGET)
+    SETTING_LIST(ESP_TARGET_FW, 0, "system/system", "targetfw", "{\"repetier\":\"" SETTING_XSTR(REPETIER) "\"},{\"marlin\":\"" SETTING_XSTR(MARLIN) "\"},{\"smoothieware\":\"" SETTING_XSTR(SMOOTHIEWARE) "\"},{\"grbl\":\"" SETTING_XSTR(GRBL) "\"},{\"unknown\":\"" SETTING_XSTR(UNKNOWN_FW) "\"}", DEFAULT_FW),
+#else
+    SETTING_BYTE(ESP_TARGET_FW, SETTING_FLAG_INTERNAL, "system/system", "targetfw", 0, 255, DEFAULT_FW),
+#endif //FIXED_FW_TARGET
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+    SETTING_BAUD(ESP_BAUD_RATE, 0, "system/system", "baud", DEFAULT_BAUD_RATE),
+#else
+    SETTING_BAUD(ESP_BAUD_RATE, SETTING_FLAG_INTERNAL, "system/system", "baud", DEFAULT_BAUD_RATE),
+#endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+    SETTING_INT(ESP_BOOT_DELAY, 0, "system/boot", "bootdelay", MIN_BOOT_DELAY, MAX_BOOT_DELAY, DEFAULT_BOOT_DELAY),
+    SETTING_LIST(ESP_VERBOSE_BOOT, 0, "system/boot", "verbose", SETTING_NO_YES, DEFAULT_VERBOSE_BOOT),
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL || COMMUNICATION_PROTOCOL == SOCKET_SERIAL
+    SETTING_LIST(ESP_SERIAL_FLAG, 0, "system/outputmsg", "serial", SETTING_NO_YES, DEFAULT_SERIAL_OUTPUT_FLAG),
+#else
+    SETTING_LIST(ESP_SERIAL_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "serial", SETTING_NO_YES, DEFAULT_SERIAL_OUTPUT_FLAG),
+#endif //COMMUNICATION_PROTOCOL
+#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
+    SETTING_LIST(ESP_SERIAL_BRIDGE_FLAG, 0, "system/outputmsg", "serial_bridge", SETTING_NO_YES, DEFAULT_SERIAL_BRIDGE_FLAG),
+#else
+    SETTING_LIST(ESP_SERIAL_BRIDGE_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "serial_bridge", SETTING_NO_YES, DEFAULT_SERIAL_BRIDGE_FLAG),
+#endif //ESP_SERIAL_BRIDGE_OUTPUT
+#if (defined(ESP3DLIB_ENV) && defined(HAS_DISPLAY)) || defined(HAS_SERIAL_DISPLAY)
+    SETTING_LIST(ESP_REMOTE_SCREEN_FLAG, 0, "system/outputmsg", "M117", SETTING_NO_YES, DEFAULT_REMOTE_SCREEN_FLAG),
+#else
+    SETTING_LIST(ESP_REMOTE_SCREEN_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "M117", SETTING_NO_YES, DEFAULT_REMOTE_SCREEN_FLAG),
+#endif //ESP3DLIB_ENV && HAS_DISPLAY || HAS_SERIAL_DISPLAY
+#ifdef DISPLAY_DEVICE
+    SETTING_LIST(ESP_SCREEN_FLAG, 0, "system/outputmsg", "M117", SETTING_NO_YES, DEFAULT_SCREEN_FLAG),
+#else
+    SETTING_LIST(ESP_SCREEN_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "M117", SETTING_NO_YES, DEFAULT_SCREEN_FLAG),
+#endif //DISPLAY_DEVICE
+#ifdef WS_DATA_FEATURE
+    SETTING_LIST(ESP_WEBSOCKET_FLAG, 0, "system/outputmsg", "ws", SETTING_NO_YES, DEFAULT_WEBSOCKET_FLAG),
+#else
+    SETTING_LIST(ESP_WEBSOCKET_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "ws", SETTING_NO_YES, DEFAULT_WEBSOCKET_FLAG),
+#endif //WS_DATA_FEATURE
+#ifdef BLUETOOTH_FEATURE
+    SETTING_LIST(ESP_BT_FLAG, 0, "system/outputmsg", "BT", SETTING_NO_YES, DEFAULT_BT_FLAG),
+#else
+    SETTING_LIST(ESP_BT_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "BT", SETTING_NO_YES, DEFAULT_BT_FLAG),
+#endif //BLUETOOTH_FEATURE
+#ifdef TELNET_FEATURE
+    SETTING_LIST(ESP_TELNET_FLAG, 0, "system/outputmsg", "telnet", SETTING_NO_YES, DEFAULT_TELNET_FLAG),
+#else
+    SETTING_LIST(ESP_TELNET_FLAG, SETTING_FLAG_INTERNAL, "system/outputmsg", "telnet", SETTING_NO_YES, DEFAULT_TELNET_FLAG),
+#endif //TELNET_FEATURE
+    //internal only
+    SETTING_BYTE(ESP_SETUP, SETTING_FLAG_INTERNAL, "system/system", "setup", 0, 255, DEFAULT_SETUP),
 #if defined(DISPLAY_DEVICE) && defined(DISPLAY_TOUCH_DRIVER)
-    case ESP_CALIBRATION:
-        res = DEFAULT_CALIBRATION_DONE;
-        break;
+    SETTING_BYTE(ESP_CALIBRATION, SETTING_FLAG_INTERNAL, "device/screen", "calibration", 0, 255, DEFAULT_CALIBRATION_DONE),
+    SETTING_INT(ESP_CALIBRATION_1, SETTING_FLAG_INTERNAL, "device/screen", "calibration", 0, 0xFFFFFFFF, DEFAULT_CALIBRATION_VALUE),
+    SETTING_INT(ESP_CALIBRATION_2, SETTING_FLAG_INTERNAL, "device/screen", "calibration", 0, 0xFFFFFFFF, DEFAULT_CALIBRATION_VALUE),
+    SETTING_INT(ESP_CALIBRATION_3, SETTING_FLAG_INTERNAL, "device/screen", "calibration", 0, 0xFFFFFFFF, DEFAULT_CALIBRATION_VALUE),
+    SETTING_INT(ESP_CALIBRATION_4, SETTING_FLAG_INTERNAL, "device/screen", "calibration", 0, 0xFFFFFFFF, DEFAULT_CALIBRATION_VALUE),
+    SETTING_INT(ESP_CALIBRATION_5, SETTING_FLAG_INTERNAL, "device/screen", "calibration", 0, 0xFFFFFFFF, DEFAULT_CALIBRATION_VALUE),
 #endif // DISPLAY_DEVICE && DISPLAY_TOUCH_DRIVER
-    default:
-        res = DEFAULT_ESP_BYTE;
+    SETTING_STRING(ESP_SETTINGS_VERSION, SETTING_FLAG_INTERNAL, "system/system", "version", 0, MAX_VERSION_LENGTH, DEFAULT_SETTINGS_VERSION),
+};
+
+#define SETTINGS_COUNT (sizeof(settingsTable) / sizeof(esp3d_setting_desc_t))
+
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+//One slot per setting, so a whole import is saved by a single commit
+int Settings_ESP3D::_dirtyPos[SETTINGS_COUNT];
+uint8_t Settings_ESP3D::_dirtyType[SETTINGS_COUNT];
+uint16_t Settings_ESP3D::_dirtyCount = 0;
+#endif //SETTINGS_IN_PREFERENCES
+
+uint16_t Settings_ESP3D::get_settings_count()
+{
+    return SETTINGS_COUNT;
+}
+
+const esp3d_setting_desc_t * Settings_ESP3D::get_setting(uint16_t index)
+{
+    return (index < SETTINGS_COUNT)?&settingsTable[index]:nullptr;
+}
+
+//Table is in ESP400 order, so lookup by position goes through table indexes
+//sorted by position, built on first lookup so it never depends on static init order
+static_assert(SETTINGS_COUNT <= 256, "settings index is one byte");
+static uint8_t settingsByPos[SETTINGS_COUNT];
+
+static bool sortSettingsByPos()
+{
+    //insertion sort, table is small and nearly sorted
+    for (uint16_t i = 0; i < SETTINGS_COUNT; i++) {
+        uint16_t j = i;
+        while ((j > 0) && (settingsTable[settingsByPos[j - 1]].pos > settingsTable[i].pos)) {
+            settingsByPos[j] = settingsByPos[j - 1];
+            j--;
+        }
+        settingsByPos[j] = i;
     }
-    return res;
+    return true;
+}
+
+const esp3d_setting_desc_t * Settings_ESP3D::get_setting_by_pos(int pos)
+{
+    //function static is initialized once, on first call
+    static const bool sorted = sortSettingsByPos();
+    if (!sorted) {
+        return nullptr;
+    }
+    size_t low = 0;
+    size_t high = SETTINGS_COUNT;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        const esp3d_setting_desc_t * setting = &settingsTable[settingsByPos[mid]];
+        if (setting->pos == pos) {
+            return setting;
+        }
+        if (setting->pos < pos) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+//Default value for a byte setting
+uint8_t Settings_ESP3D::get_default_byte_value(int pos)
+{
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'B')) {
+        return setting->value;
+    }
+    return DEFAULT_ESP_BYTE;
 }
 
 //Default value for a int32 setting
 uint32_t Settings_ESP3D::get_default_int32_value(int pos)
 {
-    uint32_t res;
-    switch(pos) {
-    case ESP_BAUD_RATE:
-        res = DEFAULT_BAUD_RATE;
-        break;
-    case ESP_SERIAL_BRIDGE_BAUD:
-#if defined(ESP_SERIAL_BRIDGE_OUTPUT)
-        res = DEFAULT_SERIAL_BRIDGE_BAUD_RATE;
-        break;
-#endif //ESP_SERIAL_BRIDGE_OUT;UT
-    case ESP_BOOT_DELAY:
-        res = DEFAULT_BOOT_DELAY;
-        break;
-#if defined(DISPLAY_DEVICE) && defined(DISPLAY_TOUCH_DRIVER)
-    case ESP_CALIBRATION_1:
-    case ESP_CALIBRATION_2:
-    case ESP_CALIBRATION_3:
-    case ESP_CALIBRATION_4:
-    case ESP_CALIBRATION_5:
-        res = DEFAULT_CALIBRATION_VALUE;
-        break;
-#endif // DISPLAY_DEVICE && DISPLAY_TOUCH_DRIVER
-#if defined (WIFI_FEATURE) || defined (ETH_FEATURE)
-    case ESP_AP_IP_VALUE:
-    case ESP_STA_IP_VALUE:
-        res = IPAddress(DEFAULT_IP_VALUE);
-        break;
-    case ESP_STA_MASK_VALUE:
-        res = IPAddress(DEFAULT_MASK_VALUE);
-        break;
-    case ESP_STA_GATEWAY_VALUE:
-        res = IPAddress(DEFAULT_GATEWAY_VALUE);
-        break;
-    case ESP_STA_DNS_VALUE:
-        res = IPAddress(DEFAULT_DNS_VALUE);
-        break;
-#endif //WIFI_FEATURE || ETH_FEATURE
-#ifdef FTP_FEATURE
-    case ESP_FTP_CTRL_PORT:
-        res = DEFAULT_FTP_CTRL_PORT;
-        break;
-    case ESP_FTP_DATA_ACTIVE_PORT:
-        res = DEFAULT_FTP_ACTIVE_PORT;
-        break;
-    case ESP_FTP_DATA_PASSIVE_PORT:
-        res = DEFAULT_FTP_PASSIVE_PORT;
-        break;
-#endif //FTP_FEATURE
-#ifdef HTTP_FEATURE
-    case ESP_HTTP_PORT:
-        res = DEFAULT_HTTP_PORT;
-        break;
-#endif //HTTP_FEATURE
-#ifdef TELNET_FEATURE
-    case ESP_TELNET_PORT:
-        res = DEFAULT_TELNET_PORT;
-        break;
-#endif //TELNET_FEATURE
-#ifdef WS_DATA_FEATURE
-    case ESP_WEBSOCKET_PORT:
-        res = DEFAULT_WEBSOCKET_PORT;
-        break;
-#endif //WS_DATA_FEATURE
-#ifdef WEBDAV_FEATURE
-    case ESP_WEBDAV_PORT:
-        res = DEFAULT_WEBDAV_PORT;
-        break;
-#endif //WEBDAV_FEATURE
-#if defined(SENSOR_DEVICE)
-    case ESP_SENSOR_INTERVAL:
-        res = DEFAULT_SENSOR_INTERVAL;
-        break;
-#endif //SENSOR_DEVICE
-    default:
-        res = DEFAULT_ESP_INT;
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && ((setting->type == 'I') || (setting->type == 'A'))) {
+        return setting->value;
     }
-    return res;
+    return DEFAULT_ESP_INT;
 }
 
 //Max value for a int32 setting
 uint32_t Settings_ESP3D::get_max_int32_value(int pos)
 {
-    uint32_t res;
-    switch(pos) {
-    case ESP_BOOT_DELAY:
-        res = MAX_BOOT_DELAY;
-        break;
-#ifdef FTP_FEATURE
-    case ESP_FTP_CTRL_PORT:
-    case ESP_FTP_DATA_ACTIVE_PORT:
-    case ESP_FTP_DATA_PASSIVE_PORT:
-        res = MAX_FTP_PORT;
-        break;
-#endif //FTP_FEATURE
-#ifdef HTTP_FEATURE
-    case ESP_HTTP_PORT:
-        res = MAX_HTTP_PORT;
-        break;
-#endif //HTTP_FEATURE
-#ifdef TELNET_FEATURE
-    case ESP_TELNET_PORT:
-        res = MAX_TELNET_PORT;
-        break;
-#endif //TELNET_FEATURE
-#ifdef WEBDAV_FEATURE
-    case ESP_WEBDAV_PORT:
-        res = MAX_WEBDAV_PORT;
-        break;
-#endif //WEBDAV_FEATURE
-#ifdef WS_DATA_FEATURE
-    case ESP_WEBSOCKET_PORT:
-        res = MAX_WEBSOCKET_PORT;
-        break;
-#endif //WS_DATA_FEATURE
-#if defined(SENSOR_DEVICE)
-    case ESP_SENSOR_INTERVAL:
-        res = MAX_SENSOR_INTERVAL;
-        break;
-#endif //SENSOR_DEVICE
-    default:
-        res = DEFAULT_ESP_INT;
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'I')) {
+        return setting->max;
     }
-    return res;
+    return DEFAULT_ESP_INT;
 }
 
 //Min value for a int32 setting
 uint32_t Settings_ESP3D::get_min_int32_value(int pos)
 {
-    uint32_t res;
-    switch(pos) {
-    case ESP_BOOT_DELAY:
-        res = MIN_BOOT_DELAY;
-        break;
-#ifdef FTP_FEATURE
-    case ESP_FTP_CTRL_PORT:
-    case ESP_FTP_DATA_ACTIVE_PORT:
-    case ESP_FTP_DATA_PASSIVE_PORT:
-        res =MIN_FTP_PORT;
-        break;
-#endif //FTP_FEATURE
-#ifdef HTTP_FEATURE
-    case ESP_HTTP_PORT:
-        res = MIN_HTTP_PORT;
-        break;
-#endif //HTTP_FEATURE
-#ifdef TELNET_FEATURE
-    case ESP_TELNET_PORT:
-        res = MIN_TELNET_PORT;
-        break;
-#endif //TELNET_FEATURE
-#ifdef WS_DATA_FEATURE
-    case ESP_WEBSOCKET_PORT:
-        res = MIN_WEBSOCKET_PORT;
-        break;
-#endif //WS_DATA_FEATURE
-#ifdef WEBDAV_FEATURE
-    case ESP_WEBDAV_PORT:
-        res = MIN_WEBDAV_PORT;
-        break;
-#endif //WEBDAV_FEATURE
-#if defined(SENSOR_DEVICE)
-    case ESP_SENSOR_INTERVAL:
-        res = MIN_SENSOR_INTERVAL;
-        break;
-#endif //SENSOR_DEVICE
-    default:
-        res = DEFAULT_ESP_INT;
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'I')) {
+        return setting->min;
     }
-    return res;
+    return DEFAULT_ESP_INT;
 }
 
 uint8_t Settings_ESP3D::get_max_byte(int pos)
 {
-    uint8_t res;
-    switch(pos) {
-#if defined (WIFI_FEATURE)
-    case ESP_AP_CHANNEL:
-        res = MAX_CHANNEL;
-        break;
-#endif //WIFI_FEATURE
-#ifdef TIMESTAMP_FEATURE
-    case ESP_TIMEZONE:
-        res= 12;
-        break;
-#endif //TIMESTAMP_FEATURE
-    default:
-        res = 255;
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'B')) {
+        return setting->max;
     }
-    return res;
+    return 255;
 }
 
 int8_t Settings_ESP3D::get_min_byte(int pos)
 {
-    uint8_t res;
-    switch(pos) {
-#if defined (WIFI_FEATURE)
-    case ESP_AP_CHANNEL:
-        res = MIN_CHANNEL;
-        break;
-#endif //WIFI_FEATURE
-#ifdef TIMESTAMP_FEATURE
-    case ESP_TIMEZONE:
-        res= -12;
-        break;
-#endif //TIMESTAMP_FEATURE
-    default:
-        res = 0;
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'B')) {
+        return setting->min;
     }
-    return res;
+    return 0;
 }
 
 //Default value for a ip setting
@@ -616,64 +597,14 @@ uint32_t Settings_ESP3D::get_default_IP_value(int pos)
     return get_default_int32_value(pos);
 }
 
-//Default value for a byte setting
+//Default value for a string setting
 const String & Settings_ESP3D::get_default_string_value(int pos)
 {
     static String res;
-    switch(pos) {
-#if defined (WIFI_FEATURE) || defined (ETH_FEATURE) || defined (BLUETOOTH_FEATURE)
-    case ESP_HOSTNAME:
-        res = DEFAULT_HOSTNAME;
-        break;
-#endif //WIFI_FEATURE || ETH_FEATURE || defined (ETH_FEATURE)
-#ifdef TIMESTAMP_FEATURE
-    case ESP_TIME_SERVER1:
-        res = DEFAULT_TIME_SERVER1;
-        break;
-    case ESP_TIME_SERVER2:
-        res = DEFAULT_TIME_SERVER2;
-        break;
-    case ESP_TIME_SERVER3:
-        res = DEFAULT_TIME_SERVER3;
-        break;
-#endif //TIMESTAMP_FEATURE
-#ifdef NOTIFICATION_FEATURE
-    case ESP_NOTIFICATION_TOKEN1:
-        res = DEFAULT_NOTIFICATION_TOKEN1;
-        break;
-    case ESP_NOTIFICATION_TOKEN2:
-        res = DEFAULT_NOTIFICATION_TOKEN2;
-        break;
-    case ESP_NOTIFICATION_SETTINGS:
-        res = DEFAULT_NOTIFICATION_SETTINGS;
-        break;
-#endif //NOTIFICATION_FEATURE
-#if defined (WIFI_FEATURE)
-    case ESP_STA_SSID:
-        res = DEFAULT_STA_SSID;
-        break;
-    case ESP_AP_SSID:
-        res = DEFAULT_AP_SSID;
-        break;
-    case ESP_STA_PASSWORD:
-        res = DEFAULT_STA_PASSWORD;
-        break;
-    case ESP_AP_PASSWORD:
-        res = DEFAULT_AP_PASSWORD;
-        break;
-#endif //WIFI_FEATURE
-#ifdef AUTHENTICATION_FEATURE
-    case ESP_ADMIN_PWD:
-        res = DEFAULT_ADMIN_PWD;
-        break;
-    case ESP_USER_PWD:
-        res = DEFAULT_USER_PWD;
-        break;
-#endif //AUTHENTICATION_FEATURE
-    case ESP_SETTINGS_VERSION:
-        res = DEFAULT_SETTINGS_VERSION;
-        break;
-    default:
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'S')) {
+        res = setting->text;
+    } else {
         res = DEFAULT_ESP_STRING;
     }
     return res;
@@ -682,132 +613,227 @@ const String & Settings_ESP3D::get_default_string_value(int pos)
 //Max size of for a string setting
 uint8_t Settings_ESP3D::get_max_string_size(int pos)
 {
-    uint8_t res;
-    switch(pos) {
-#if defined (WIFI_FEATURE) || defined (ETH_FEATURE) || defined (BLUETOOTH_FEATURE)
-    case ESP_HOSTNAME:
-        res = MAX_HOSTNAME_LENGTH;
-        break;
-#endif //WIFI_FEATURE || ETH_FEATURE || BLUETOOTH_FEATURE
-#ifdef TIMESTAMP_FEATURE
-    case ESP_TIME_SERVER1:
-    case ESP_TIME_SERVER2:
-    case ESP_TIME_SERVER3:
-        res =  MAX_SERVER_ADDRESS_LENGTH;
-        break;
-#endif //TIMESTAMP_FEATURE
-#ifdef NOTIFICATION_FEATURE
-    case ESP_NOTIFICATION_TOKEN1:
-    case ESP_NOTIFICATION_TOKEN2:
-        res = MAX_NOTIFICATION_TOKEN_LENGTH;
-        break;
-    case ESP_NOTIFICATION_SETTINGS:
-        res = MAX_NOTIFICATION_SETTINGS_LENGTH;
-        break;
-#endif //NOTIFICATION_FEATURE
-#if defined (WIFI_FEATURE)
-    case ESP_STA_SSID:
-    case ESP_AP_SSID:
-        res = MAX_SSID_LENGTH;
-        break;
-    case ESP_STA_PASSWORD:
-    case ESP_AP_PASSWORD:
-        res = MAX_PASSWORD_LENGTH;
-        break;
-#endif //WIFI_FEATURE
-#ifdef AUTHENTICATION_FEATURE
-    case ESP_ADMIN_PWD:
-    case ESP_USER_PWD:
-        res = MAX_LOCAL_PASSWORD_LENGTH;
-        break;
-#endif //AUTHENTICATION_FEATURE
-    case ESP_SETTINGS_VERSION:
-        res = MAX_VERSION_LENGTH;
-        break;
-    default:
-        res = DEFAULT_ESP_STRING_SIZE;
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'S')) {
+        return setting->max;
     }
-    return res;
+    return DEFAULT_ESP_STRING_SIZE;
 }
 
 //Min size of for a string setting
 uint8_t Settings_ESP3D::get_min_string_size(int pos)
 {
-    uint8_t res;
-    switch(pos) {
-#if defined (WIFI_FEATURE) || defined (ETH_FEATURE) || defined (BLUETOOTH_FEATURE)
-    case ESP_HOSTNAME:
-        res = MIN_HOSTNAME_LENGTH;
-        break;
-#endif //WIFI_FEATURE || ETH_FEATURE || BLUETOOTH_FEATURE
-#ifdef NOTIFICATION_FEATURE
-    case ESP_NOTIFICATION_TOKEN1:
-    case ESP_NOTIFICATION_TOKEN2:
-        res = MIN_NOTIFICATION_TOKEN_LENGTH;
-        break;
-    case ESP_NOTIFICATION_SETTINGS:
-        res = MIN_NOTIFICATION_SETTINGS_LENGTH;
-        break;
-#endif //NOTIFICATION_FEATURE
-#ifdef TIMESTAMP_FEATURE
-    case ESP_TIME_SERVER1:
-    case ESP_TIME_SERVER2:
-    case ESP_TIME_SERVER3:
-        res =  MIN_SERVER_ADDRESS_LENGTH;
-        break;
-#endif //TIMESTAMP_FEATURE
-#if defined (WIFI_FEATURE)
-    case ESP_STA_SSID:
-    case ESP_AP_SSID:
-        res = MIN_SSID_LENGTH;
-        break;
-    case ESP_STA_PASSWORD:
-    case ESP_AP_PASSWORD:
-        res = MIN_PASSWORD_LENGTH;
-        break;
-#endif //WIFI_FEATURE
-#ifdef AUTHENTICATION_FEATURE
-    case ESP_ADMIN_PWD:
-    case ESP_USER_PWD:
-        res = MIN_LOCAL_PASSWORD_LENGTH;
-        break;
-#endif //AUTHENTICATION_FEATURE
+    const esp3d_setting_desc_t * setting = get_setting_by_pos(pos);
+    if (setting && (setting->type == 'S')) {
+        return setting->min;
+    }
+    return DEFAULT_ESP_STRING_SIZE;
+}
+
+//Open settings storage once, reads and writes are then done in RAM
+bool Settings_ESP3D::_cacheBegin()
+{
+    if (_cacheStarted) {
+        return true;
+    }
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
+    //EEPROM library keeps a RAM copy of the settings until end() is called
+    EEPROM.begin (EEPROM_SIZE);
+#endif //SETTINGS_IN_EEPROM
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+    memset(_cacheLoaded, 0, sizeof(_cacheLoaded));
+    _dirtyCount = 0;
+#endif //SETTINGS_IN_PREFERENCES
+    _cacheStarted = true;
+    return true;
+}
+
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+//Check if a setting is already in RAM, and load it from preferences if not
+bool Settings_ESP3D::_cacheLoad(int pos, uint8_t type)
+{
+    if (_cacheLoaded[pos/8] & (1 << (pos%8))) {
+        _cacheHits++;
+        return true;
+    }
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, true)) {
+        log_esp3d("Error opening %s", NAMESPACE);
+        return false;
+    }
+    String p = "P_" + String(pos);
+    bool iskey = prefs.isKey(p.c_str());
+    switch (type) {
+    case SETTINGS_TYPE_BYTE:
+        _cache[pos] = iskey?prefs.getChar(p.c_str(), get_default_byte_value(pos)):get_default_byte_value(pos);
+        break;
+    case SETTINGS_TYPE_INT32: {
+        uint32_t v = iskey?prefs.getUInt(p.c_str(), get_default_int32_value(pos)):get_default_int32_value(pos);
+        memcpy(&_cache[pos], &v, sizeof(uint32_t));
+    }
+    break;
+    case SETTINGS_TYPE_STRING: {
+        uint8_t size_max = get_max_string_size(pos);
+        String v = iskey?prefs.getString(p.c_str(), get_default_string_value(pos)):get_default_string_value(pos);
+        if (v.length() > size_max) {
+            log_esp3d("String too long %d vs %d", v.length(), size_max);
+            v = v.substring(0,size_max-1);
+        }
+        strncpy((char *)&_cache[pos], v.c_str(), size_max + 1);
+        _cache[pos + size_max] = 0;
+    }
+    break;
     default:
-        res = DEFAULT_ESP_STRING_SIZE;
+        prefs.end();
+        return false;
+    }
+    prefs.end();
+    _cacheLoaded[pos/8] |= (1 << (pos%8));
+    return true;
+}
+#endif //SETTINGS_IN_PREFERENCES
+
+//Flag setting as modified, it will be saved by commit()
+//return false if setting cannot be saved
+bool Settings_ESP3D::_setDirty(int pos, uint8_t type)
+{
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+    bool found = false;
+    for (uint16_t i = 0; i < _dirtyCount && !found; i++) {
+        found = (_dirtyPos[i] == pos);
+    }
+    if (!found) {
+        //only reached by a position outside settings table
+        if (_dirtyCount == SETTINGS_COUNT) {
+            log_esp3d("Error too many unsaved settings");
+            return false;
+        }
+        _dirtyPos[_dirtyCount] = pos;
+        _dirtyType[_dirtyCount] = type;
+        _dirtyCount++;
+    }
+#else
+    (void)pos;
+    (void)type;
+#endif //SETTINGS_IN_PREFERENCES
+    _dirty = true;
+    _lastWrite = millis();
+    return true;
+}
+
+//Save modified settings to flash
+bool Settings_ESP3D::commit()
+{
+    if (!_dirty) {
+        return true;
+    }
+    bool res = true;
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
+    if (!EEPROM.commit()) {
+        log_esp3d("Error commit");
+        res = false;
+    }
+#endif //SETTINGS_IN_EEPROM
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, false)) {
+        log_esp3d("Error opening %s", NAMESPACE);
+        return false;
     }
+    uint16_t failed = 0;
+    for (uint16_t i = 0; i < _dirtyCount; i++) {
+        int pos = _dirtyPos[i];
+        String p = "P_" + String(pos);
+        size_t r = 0;
+        switch (_dirtyType[i]) {
+        case SETTINGS_TYPE_BYTE:
+            r = prefs.putChar(p.c_str(), _cache[pos]);
+            break;
+        case SETTINGS_TYPE_INT32: {
+            uint32_t v;
+            memcpy(&v, &_cache[pos], sizeof(uint32_t));
+            r = prefs.putUInt(p.c_str(), v);
+        }
+        break;
+        case SETTINGS_TYPE_STRING:
+            r = prefs.putString(p.c_str(), (const char *)&_cache[pos]);
+            if (r == strlen((const char *)&_cache[pos])) {
+                r = 1;
+            } else {
+                r = 0;
+            }
+            break;
+        default:
+            break;
+        }
+        if (r == 0) {
+            log_esp3d("Error commit %s", p.c_str());
+            res = false;
+            //keep it for next commit
+            _dirtyPos[failed] = pos;
+            _dirtyType[failed] = _dirtyType[i];
+            failed++;
+        }
+    }
+    prefs.end();
+    _dirtyCount = failed;
+#endif //SETTINGS_IN_PREFERENCES
+    _flashCommits++;
+    _dirty = !res;
     return res;
 }
 
+//Drop modified settings not yet saved, next reads come from flash again
+void Settings_ESP3D::discard()
+{
+    if (!_dirty) {
+        return;
+    }
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
+    //begin() reloads RAM copy from flash, end() would save it
+    EEPROM.begin (EEPROM_SIZE);
+#endif //SETTINGS_IN_EEPROM
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+    memset(_cacheLoaded, 0, sizeof(_cacheLoaded));
+    _dirtyCount = 0;
+#endif //SETTINGS_IN_PREFERENCES
+    _dirty = false;
+    _commitFailed = false;
+}
+
+//Save modified settings once no write happened for a while
+void Settings_ESP3D::handle()
+{
+    if (_dirty && ((millis() - _lastWrite) > (_commitFailed?SETTINGS_COMMIT_RETRY_DELAY:SETTINGS_COMMIT_DELAY))) {
+        _commitFailed = !commit();
+        if (_commitFailed) {
+            _lastWrite = millis();
+        }
+    }
+}
+
 uint8_t Settings_ESP3D::read_byte (int pos, bool * haserror)
 {
     if(haserror) {
         *haserror = true;
     }
     uint8_t value = get_default_byte_value(pos);
-#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
-//check if parameters are acceptable
-    if ((pos + 1 > EEPROM_SIZE) )  {
+    //check if parameters are acceptable
+    if ((pos + 1 > SETTINGS_CACHE_SIZE) )  {
         log_esp3d("Error read byte %d", pos);
         return value;
     }
+    _cacheBegin();
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
 //read byte
-    EEPROM.begin (EEPROM_SIZE);
     value = EEPROM.read (pos);
-    EEPROM.end();
+    _cacheHits++;
 #endif //SETTINGS_IN_EEPROM
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
-    Preferences prefs;
-    if (!prefs.begin(NAMESPACE, true)) {
-        log_esp3d("Error opening %s", NAMESPACE);
+    if (!_cacheLoad(pos, SETTINGS_TYPE_BYTE)) {
         return value;
     }
-    String p = "P_" + String(pos);
-    if (prefs.isKey(p.c_str())) {
-        value  = prefs.getChar(p.c_str(), get_default_byte_value(pos));
-    } else {
-        value  = get_default_byte_value(pos);
-    }
-    prefs.end();
+    value = _cache[pos];
 #endif //SETTINGS_IN_PREFERENCES
     if(haserror) {
         *haserror = false;
@@ -818,33 +844,23 @@ uint8_t Settings_ESP3D::read_byte (int pos, bool * haserror)
 //write a flag / byte
 bool Settings_ESP3D::write_byte (int pos, const uint8_t value)
 {
-#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     //check if parameters are acceptable
-    if (pos + 1 > EEPROM_SIZE) {
+    if (pos + 1 > SETTINGS_CACHE_SIZE) {
         log_esp3d("Error read byte %d", pos);
         return false;
     }
-    EEPROM.begin (EEPROM_SIZE);
-    EEPROM.write (pos, value);
-    if (!EEPROM.commit()) {
-        log_esp3d("Error commit %d", pos);
+    //no need to write same value
+    if (read_byte(pos) == value) {
+        return true;
+    }
+    if (!_setDirty(pos, SETTINGS_TYPE_BYTE)) {
         return false;
     }
-    EEPROM.end();
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
+    EEPROM.write (pos, value);
 #endif //SETTINGS_IN_EEPROM
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
-    Preferences prefs;
-    if (!prefs.begin(NAMESPACE, false)) {
-        log_esp3d("Error opening %s", NAMESPACE);
-        return false;
-    }
-    String p = "P_" + String(pos);
-    uint8_t r = prefs.putChar(p.c_str(), value);
-    prefs.end();
-    if (r == 0) {
-        log_esp3d("Error commit %s", p.c_str());
-        return false;
-    }
+    _cache[pos] = value;
 #endif //SETTINGS_IN_PREFERENCES
     return true;
 }
@@ -871,6 +887,12 @@ const char * Settings_ESP3D::read_string (int pos, bool *haserror)
         log_esp3d("Error size string %d", pos);
         return DEFAULT_ESP_STRING;
     }
+    //check if parameters are acceptable
+    if (pos + size_max + 1 > SETTINGS_CACHE_SIZE) {
+        log_esp3d("Error read string %d", pos);
+        return DEFAULT_ESP_STRING;
+    }
+    _cacheBegin();
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     static char * byte_buffer = NULL;
     size_max++;//do not forget the 0x0 for the end
@@ -878,17 +900,11 @@ const char * Settings_ESP3D::read_string (int pos, bool *haserror)
         free (byte_buffer);
         byte_buffer = NULL;
     }
-    //check if parameters are acceptable
-    if (pos + size_max + 1 > EEPROM_SIZE) {
-        log_esp3d("Error read string %d", pos);
-        return DEFAULT_ESP_STRING;
-    }
     byte_buffer = (char *)malloc(size_max+1);
     if (!byte_buffer) {
         log_esp3d("Error mem read string %d", pos);
         return DEFAULT_ESP_STRING;
     }
-    EEPROM.begin (EEPROM_SIZE);
     byte b = 1; // non zero for the while loop below
     int i = 0;
 
@@ -903,7 +919,7 @@ const char * Settings_ESP3D::read_string (int pos, bool *haserror)
     if (b != 0) {
         byte_buffer[i - 1] = 0x00;
     }
-    EEPROM.end();
+    _cacheHits++;
 
     if (haserror) {
         *haserror = false;
@@ -912,30 +928,14 @@ const char * Settings_ESP3D::read_string (int pos, bool *haserror)
 
 #endif //SETTINGS_IN_EEPROM
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
-    Preferences prefs;
-    static String res;
-
-    if (!prefs.begin(NAMESPACE, true)) {
-        log_esp3d("Error opening %s", NAMESPACE);
+    if (!_cacheLoad(pos, SETTINGS_TYPE_STRING)) {
         return "";
     }
-    String p = "P_" + String(pos);
-    if (prefs.isKey(p.c_str())) {
-        res = prefs.getString(p.c_str(), get_default_string_value(pos));
-    } else {
-        res = get_default_string_value(pos);
-    }
-    prefs.end();
-
-    if (res.length() > size_max) {
-        log_esp3d("String too long %d vs %d", res.length(), size_max);
-        res = res.substring(0,size_max-1);
-    }
 
     if (haserror) {
         *haserror = false;
     }
-    return res.c_str();
+    return (const char *)&_cache[pos];
 
 #endif //SETTINGS_IN_PREFERENCES
 }
@@ -943,6 +943,10 @@ const char * Settings_ESP3D::read_string (int pos, bool *haserror)
 //write a string (array of byte with a 0x00  at the end)
 bool Settings_ESP3D::write_string (int pos, const char * byte_buffer)
 {
+    if (byte_buffer == NULL) {
+        log_esp3d("Error write string %d", pos);
+        return false;
+    }
     int size_buffer = strlen (byte_buffer);
     uint8_t size_max = get_max_string_size(pos);
     //check if parameters are acceptable
@@ -954,37 +958,27 @@ bool Settings_ESP3D::write_string (int pos, const char * byte_buffer)
         log_esp3d("Error string too long %d, %d", pos, size_buffer);
         return false;
     }
-#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
-    if (  pos + size_buffer + 1 > EEPROM_SIZE  || byte_buffer == NULL) {
+    if (  pos + size_buffer + 1 > SETTINGS_CACHE_SIZE) {
         log_esp3d("Error write string %d", pos);
         return false;
     }
+    //no need to write same value
+    if (strcmp(read_string(pos), byte_buffer) == 0) {
+        return true;
+    }
+    if (!_setDirty(pos, SETTINGS_TYPE_STRING)) {
+        return false;
+    }
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     //copy the value(s)
-    EEPROM.begin (EEPROM_SIZE);
     for (int i = 0; i < size_buffer; i++) {
         EEPROM.write (pos + i, byte_buffer[i]);
     }
     //0 terminal
     EEPROM.write (pos + size_buffer, 0x00);
-    if (!EEPROM.commit()) {
-        log_esp3d("Error commit %d", pos);
-        return false;
-    }
-    EEPROM.end();
 #endif //SETTINGS_IN_EEPROM
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
-    Preferences prefs;
-    if (!prefs.begin(NAMESPACE, false)) {
-        log_esp3d("Error opening %s", NAMESPACE);
-        return false;
-    }
-    String p = "P_" + String(pos);
-    uint8_t r = prefs.putString(p.c_str(), byte_buffer);
-    prefs.end();
-    if (r != size_buffer) {
-        log_esp3d("Error commit %s", p.c_str());
-        return false;
-    }
+    memcpy(&_cache[pos], byte_buffer, size_buffer + 1);
 #endif //SETTINGS_IN_PREFERENCES
     return true;
 }
@@ -996,35 +990,27 @@ uint32_t Settings_ESP3D::read_uint32(int pos, bool * haserror)
         *haserror = true;
     }
     uint32_t res = get_default_int32_value(pos);
-#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     //check if parameters are acceptable
     uint8_t size_buffer = sizeof(uint32_t);
-    if ( pos + size_buffer > EEPROM_SIZE ) {
+    if ( pos + size_buffer > SETTINGS_CACHE_SIZE ) {
         log_esp3d("Error read int %d", pos);
         return res;
     }
+    _cacheBegin();
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     uint8_t i = 0;
-    EEPROM.begin (EEPROM_SIZE);
     //read until max size is reached
     while (i < size_buffer ) {
         ((uint8_t *)(&res))[i] = EEPROM.read (pos + i);
         i++;
     }
-    EEPROM.end();
+    _cacheHits++;
 #endif //SETTINGS_IN_EEPROM
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
-    Preferences prefs;
-    if (!prefs.begin(NAMESPACE, true)) {
-        log_esp3d("Error opening %s", NAMESPACE);
+    if (!_cacheLoad(pos, SETTINGS_TYPE_INT32)) {
         return res;
     }
-    String p = "P_" + String(pos);
-    if (prefs.isKey(p.c_str())) {
-        res = prefs.getUInt(p.c_str(), res);
-    } else {
-        res = get_default_int32_value(pos);
-    }
-    prefs.end();
+    memcpy(&res, &_cache[pos], size_buffer);
 #endif //SETTINGS_IN_PREFERENCES
     if (haserror) {
         *haserror = false;
@@ -1047,37 +1033,27 @@ String Settings_ESP3D::read_IP_String(int pos, bool * haserror)
 //write a uint32
 bool Settings_ESP3D::write_uint32(int pos, const uint32_t value)
 {
-#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     uint8_t size_buffer = sizeof(uint32_t);
     //check if parameters are acceptable
-    if (pos + size_buffer > EEPROM_SIZE) {
+    if (pos + size_buffer > SETTINGS_CACHE_SIZE) {
         log_esp3d("Error invalid entry %d", pos);
         return false;
     }
-    EEPROM.begin (EEPROM_SIZE);
+    //no need to write same value
+    if (read_uint32(pos) == value) {
+        return true;
+    }
+    if (!_setDirty(pos, SETTINGS_TYPE_INT32)) {
+        return false;
+    }
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     //copy the value(s)
     for (int i = 0; i < size_buffer; i++) {
         EEPROM.write (pos + i, ((uint8_t *)(&value))[i]);
     }
-    if (!EEPROM.commit()) {
-        log_esp3d("Error commit %d", pos);
-        return false;
-    }
-    EEPROM.end();
 #endif //SETTINGS_IN_EEPROM
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
-    Preferences prefs;
-    if (!prefs.begin(NAMESPACE, false)) {
-        log_esp3d("Error opening %s", NAMESPACE);
-        return false;
-    }
-    String p = "P_" + String(pos);
-    uint8_t r = prefs.putUInt(p.c_str(), value);
-    prefs.end();
-    if (r == 0) {
-        log_esp3d("Error commit %s", p.c_str());
-        return false;
-    }
+    memcpy(&_cache[pos], &value, size_buffer);
 #endif //SETTINGS_IN_PREFERENCES
     return true;
 }
@@ -1088,41 +1064,30 @@ bool Settings_ESP3D::write_IP(int pos, const uint32_t value)
     return write_uint32(pos, value);
 }
 
+//Write default value of a setting
+static bool resetSetting(const esp3d_setting_desc_t * setting)
+{
+    switch (setting->type) {
+    case 'B':
+        return Settings_ESP3D::write_byte(setting->pos, setting->value);
+    case 'I':
+    case 'A':
+        return Settings_ESP3D::write_uint32(setting->pos, setting->value);
+    case 'S':
+        return Settings_ESP3D::write_string(setting->pos, setting->text);
+    default:
+        return false;
+    }
+}
+
 //clear all entries
 bool Settings_ESP3D::reset(bool networkonly)
 {
-    //radio mode
-    Settings_ESP3D::write_byte(ESP_RADIO_MODE,Settings_ESP3D::get_default_byte_value(ESP_RADIO_MODE));
-    Settings_ESP3D::write_byte(ESP_BOOT_RADIO_STATE,Settings_ESP3D::get_default_byte_value(ESP_BOOT_RADIO_STATE));
-    Settings_ESP3D::write_byte(ESP_STA_FALLBACK_MODE,Settings_ESP3D::get_default_byte_value(ESP_STA_FALLBACK_MODE));
-#if defined (WIFI_FEATURE)
-    //STA SSID
-    Settings_ESP3D::write_string(ESP_STA_SSID,Settings_ESP3D::get_default_string_value(ESP_STA_SSID).c_str());
-    //STA pwd
-    Settings_ESP3D::write_string(ESP_STA_PASSWORD,Settings_ESP3D::get_default_string_value(ESP_STA_PASSWORD).c_str());
-    //AP SSID
-    Settings_ESP3D::write_string(ESP_AP_SSID,Settings_ESP3D::get_default_string_value(ESP_AP_SSID).c_str());
-    //AP password
-    Settings_ESP3D::write_string(ESP_AP_PASSWORD,Settings_ESP3D::get_default_string_value(ESP_AP_PASSWORD).c_str());
-    //AP static IP
-    Settings_ESP3D::write_IP(ESP_AP_IP_VALUE, Settings_ESP3D::get_default_IP_value(ESP_AP_IP_VALUE));
-    //AP Channel
-    Settings_ESP3D::write_byte(ESP_AP_CHANNEL,Settings_ESP3D::get_default_byte_value(ESP_AP_CHANNEL));
-
-#endif //WIFI_FEATURE
-
-#if defined (WIFI_FEATURE) || defined (ETH_FEATURE)
-    //STA IP mode
-    Settings_ESP3D::write_byte(ESP_STA_IP_MODE,Settings_ESP3D::get_default_byte_value(ESP_STA_IP_MODE));
-    //STA static IP
-    Settings_ESP3D::write_IP(ESP_STA_IP_VALUE, Settings_ESP3D::get_default_IP_value(ESP_STA_IP_VALUE));
-    //STA static Gateway
-    Settings_ESP3D::write_IP(ESP_STA_GATEWAY_VALUE, Settings_ESP3D::get_default_IP_value(ESP_STA_GATEWAY_VALUE));
-    //STA static Mask
-    Settings_ESP3D::write_IP(ESP_STA_MASK_VALUE, Settings_ESP3D::get_default_IP_value(ESP_STA_MASK_VALUE));
-    //STA static DNS
-    Settings_ESP3D::write_IP(ESP_STA_DNS_VALUE, Settings_ESP3D::get_default_IP_value(ESP_STA_DNS_VALUE));
-#endif //WIFI_FEATURE || ETH_FEATURE
+    for (uint16_t i = 0; i < SETTINGS_COUNT; i++) {
+        if (settingsTable[i].flags & SETTING_FLAG_NETWORK) {
+            resetSetting(&settingsTable[i]);
+        }
+    }
     if (networkonly) {
         return true;
     }
@@ -1137,138 +1102,21 @@ bool Settings_ESP3D::reset(bool networkonly)
     }
     res = prefs.clear();
     prefs.end();
+    //RAM copy is no more valid
+    memset(_cacheLoaded, 0, sizeof(_cacheLoaded));
+    _dirtyCount = 0;
+    _dirty = false;
 #endif //SETTINGS_IN_PREFERENCES
 
 //for EEPROM need to overwrite all settings
 #if ESP_SAVE_SETTINGS == SETTINGS_IN_EEPROM
     log_esp3d("clear EEPROM");
-
-    //Setup done (internal only)
-    Settings_ESP3D::write_byte(ESP_SETUP,Settings_ESP3D::get_default_byte_value(ESP_SETUP));
-    //Verbose boot
-    Settings_ESP3D::write_byte(ESP_VERBOSE_BOOT,Settings_ESP3D::get_default_byte_value(ESP_VERBOSE_BOOT));
-    //Secure Serial
-#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
-    Settings_ESP3D::write_byte(ESP_SECURE_SERIAL,Settings_ESP3D::get_default_byte_value(ESP_SECURE_SERIAL));
-#endif //COMMUNICATION PROTOCOL
-#if defined(DISPLAY_DEVICE) && defined(DISPLAY_TOUCH_DRIVER)
-    //Calibration done (internal only)
-    Settings_ESP3D::write_byte(ESP_CALIBRATION,Settings_ESP3D::get_default_byte_value(ESP_CALIBRATION));
-    //Calibration data (internal only)
-    Settings_ESP3D::write_uint32 (ESP_CALIBRATION_1, Settings_ESP3D::get_default_int32_value(ESP_CALIBRATION_1));
-    Settings_ESP3D::write_uint32 (ESP_CALIBRATION_2, Settings_ESP3D::get_default_int32_value(ESP_CALIBRATION_2));
-    Settings_ESP3D::write_uint32 (ESP_CALIBRATION_3, Settings_ESP3D::get_default_int32_value(ESP_CALIBRATION_3));
-    Settings_ESP3D::write_uint32 (ESP_CALIBRATION_4, Settings_ESP3D::get_default_int32_value(ESP_CALIBRATION_4));
-    Settings_ESP3D::write_uint32 (ESP_CALIBRATION_5, Settings_ESP3D::get_default_int32_value(ESP_CALIBRATION_5));
-#endif // DISPLAY_DEVICE && DISPLAY_TOUCH_DRIVER
-#ifdef BUZZER_DEVICE
-    //Buzzer state
-    Settings_ESP3D::write_byte(ESP_BUZZER,Settings_ESP3D::get_default_byte_value(ESP_BUZZER));
-#endif //BUZZER_DEVICE
-#if defined (WIFI_FEATURE) || defined (BLUETOOTH_FEATURE) || defined (ETH_FEATURE)
-    //Hostname
-    Settings_ESP3D::write_string(ESP_HOSTNAME,Settings_ESP3D::get_default_string_value(ESP_HOSTNAME).c_str());
-#endif //WIFI_FEATURE ||  BLUETOOTH_FEATURE || ETH_FEATURE
-#ifdef NOTIFICATION_FEATURE
-    //Auto Notification
-    Settings_ESP3D::write_byte(ESP_AUTO_NOTIFICATION,Settings_ESP3D::get_default_byte_value(ESP_AUTO_NOTIFICATION));
-    //Notification Type
-    Settings_ESP3D::write_byte(ESP_NOTIFICATION_TYPE,Settings_ESP3D::get_default_byte_value(ESP_NOTIFICATION_TYPE));
-    //Notification Token1
-    Settings_ESP3D::write_string(ESP_NOTIFICATION_TOKEN1,Settings_ESP3D::get_default_string_value(ESP_NOTIFICATION_TOKEN1).c_str());
-    //Notification Token2
-    Settings_ESP3D::write_string(ESP_NOTIFICATION_TOKEN2,Settings_ESP3D::get_default_string_value(ESP_NOTIFICATION_TOKEN2).c_str());
-    //Notification Settings
-    Settings_ESP3D::write_string(ESP_NOTIFICATION_SETTINGS,Settings_ESP3D::get_default_string_value(ESP_NOTIFICATION_SETTINGS).c_str());
-#endif //NOTIFICATION_FEATURE
-    //radio mode
-    Settings_ESP3D::write_byte(ESP_RADIO_MODE,Settings_ESP3D::get_default_byte_value(ESP_RADIO_MODE));
-
-#ifdef FTP_FEATURE
-    //FTP On
-    Settings_ESP3D::write_byte(ESP_FTP_ON,Settings_ESP3D::get_default_byte_value(ESP_FTP_ON));
-    //FTP Ctrl Port
-    Settings_ESP3D::write_uint32 (ESP_FTP_CTRL_PORT, Settings_ESP3D::get_default_int32_value(ESP_FTP_CTRL_PORT));
-    //FTP Active data Port
-    Settings_ESP3D::write_uint32 (ESP_FTP_DATA_ACTIVE_PORT, Settings_ESP3D::get_default_int32_value(ESP_FTP_DATA_ACTIVE_PORT));
-    //FTP Pasive data Port
-    Settings_ESP3D::write_uint32 (ESP_FTP_DATA_PASSIVE_PORT, Settings_ESP3D::get_default_int32_value(ESP_FTP_DATA_PASSIVE_PORT));
-#endif //FTP_FEATURE
-
-#ifdef HTTP_FEATURE
-    //HTTP On
-    Settings_ESP3D::write_byte(ESP_HTTP_ON,Settings_ESP3D::get_default_byte_value(ESP_HTTP_ON));
-    //HTTP Port
-    Settings_ESP3D::write_uint32 (ESP_HTTP_PORT, Settings_ESP3D::get_default_int32_value(ESP_HTTP_PORT));
-#endif //HTTP_FEATURE
-
-#ifdef TELNET_FEATURE
-    //TELNET On
-    Settings_ESP3D::write_byte(ESP_TELNET_ON,Settings_ESP3D::get_default_byte_value(ESP_TELNET_ON));
-    //TELNET Port
-    Settings_ESP3D::write_uint32 (ESP_TELNET_PORT, Settings_ESP3D::get_default_int32_value(ESP_TELNET_PORT));
-#endif //TELNET
-#ifdef WS_DATA_FEATURE
-    //Websocket On
-    Settings_ESP3D::write_byte(ESP_WEBSOCKET_ON,Settings_ESP3D::get_default_byte_value(ESP_WEBSOCKET_ON));
-    //Websocket Port
-    Settings_ESP3D::write_uint32 (ESP_WEBSOCKET_PORT, Settings_ESP3D::get_default_int32_value(ESP_WEBSOCKET_PORT));
-#endif //WS_DATA_FEATURE
-#ifdef WEBDAV_FEATURE
-    //WebDav On
-    Settings_ESP3D::write_byte(ESP_WEBDAV_ON,Settings_ESP3D::get_default_byte_value(ESP_WEBDAV_ON));
-    //WebDav Port
-    Settings_ESP3D::write_uint32 (ESP_WEBDAV_PORT, Settings_ESP3D::get_default_int32_value(ESP_WEBDAV_PORT));
-#endif //WEBDAV_FEATURE
-#ifdef AUTHENTICATION_FEATURE
-    //Admin password
-    Settings_ESP3D::write_string(ESP_ADMIN_PWD,Settings_ESP3D::get_default_string_value(ESP_ADMIN_PWD).c_str());
-    //User password
-    Settings_ESP3D::write_string(ESP_USER_PWD,Settings_ESP3D::get_default_string_value(ESP_USER_PWD).c_str());
-    //Session timeout
-    Settings_ESP3D::write_byte(ESP_SESSION_TIMEOUT,Settings_ESP3D::get_default_byte_value(ESP_SESSION_TIMEOUT));
-#endif //AUTHENTICATION_FEATURE
-    //Target FW
-    Settings_ESP3D::write_byte(ESP_TARGET_FW,Settings_ESP3D::get_default_byte_value(ESP_TARGET_FW));
-    //Output flags
-    Settings_ESP3D::write_byte(ESP_SERIAL_FLAG,Settings_ESP3D::get_default_byte_value(ESP_SERIAL_FLAG));
-    Settings_ESP3D::write_byte(ESP_SERIAL_BRIDGE_FLAG,Settings_ESP3D::get_default_byte_value(ESP_SERIAL_BRIDGE_FLAG));
-    Settings_ESP3D::write_byte(ESP_REMOTE_SCREEN_FLAG,Settings_ESP3D::get_default_byte_value(ESP_REMOTE_SCREEN_FLAG));
-    Settings_ESP3D::write_byte(ESP_WEBSOCKET_FLAG,Settings_ESP3D::get_default_byte_value(ESP_WEBSOCKET_FLAG));
-    Settings_ESP3D::write_byte(ESP_TELNET_FLAG,Settings_ESP3D::get_default_byte_value(ESP_TELNET_FLAG));
-    Settings_ESP3D::write_byte(ESP_BT_FLAG,Settings_ESP3D::get_default_byte_value(ESP_BT_FLAG));
-    Settings_ESP3D::write_byte(ESP_SCREEN_FLAG,Settings_ESP3D::get_default_byte_value(ESP_SCREEN_FLAG));
-#ifdef SD_DEVICE
-    //SPI SD Divider
-    Settings_ESP3D::write_byte(ESP_SD_SPEED_DIV,Settings_ESP3D::get_default_byte_value(ESP_SD_SPEED_DIV));
-#ifdef SD_UPDATE_FEATURE
-    //SD Update feature
-    Settings_ESP3D::write_byte(ESP_SD_CHECK_UPDATE_AT_BOOT,Settings_ESP3D::get_default_byte_value(ESP_SD_CHECK_UPDATE_AT_BOOT));
-#endif //SD_UPDATE_FEATURE
-#endif //SD_DEVICE
-
-#ifdef TIMESTAMP_FEATURE
-    //Internet time
-    Settings_ESP3D::write_byte(ESP_INTERNET_TIME,Settings_ESP3D::get_default_byte_value(ESP_INTERNET_TIME));
-    //Time Zone
-    Settings_ESP3D::write_byte(ESP_TIMEZONE,Settings_ESP3D::get_default_byte_value(ESP_TIMEZONE));
-    //Is DST Time Zone
-    Settings_ESP3D::write_byte(ESP_TIME_IS_DST,Settings_ESP3D::get_default_byte_value(ESP_TIME_IS_DST));
-    //Time Server 1 address
-    Settings_ESP3D::write_string(ESP_TIME_SERVER1, Settings_ESP3D::get_default_string_value(ESP_TIME_SERVER1).c_str());
-    //Time Server 2 address
-    Settings_ESP3D::write_string(ESP_TIME_SERVER2, Settings_ESP3D::get_default_string_value(ESP_TIME_SERVER2).c_str());
-    //Time Server 3 address
-    Settings_ESP3D::write_string(ESP_TIME_SERVER3, Settings_ESP3D::get_default_string_value(ESP_TIME_SERVER3).c_str());
-#endif //TIMESTAMP_FEATURE
-#ifdef SENSOR_DEVICE
-    //Sensor device
-    Settings_ESP3D::write_byte(ESP_SENSOR_TYPE,Settings_ESP3D::get_default_byte_value(ESP_SENSOR_TYPE));
-    //Sensor query interval
-    Settings_ESP3D::write_uint32 (ESP_SENSOR_INTERVAL, Settings_ESP3D::get_default_int32_value(ESP_SENSOR_INTERVAL));
-#endif //SENSOR_DEVICE
-    //Start Delay
-    Settings_ESP3D::write_uint32 (ESP_BOOT_DELAY, Settings_ESP3D::get_default_int32_value(ESP_BOOT_DELAY));
+    for (uint16_t i = 0; i < SETTINGS_COUNT; i++) {
+        //version is set once all is done
+        if (!(settingsTable[i].flags & SETTING_FLAG_NETWORK) && (settingsTable[i].pos != ESP_SETTINGS_VERSION)) {
+            resetSetting(&settingsTable[i]);
+        }
+    }
 #endif //SETTINGS_IN_EEPROM
     //set version in settings
     if (res) {
@@ -1276,6 +1124,10 @@ bool Settings_ESP3D::reset(bool networkonly)
         //Settings version (internal only)
         res =  Settings_ESP3D::write_string(ESP_SETTINGS_VERSION, CURRENT_SETTINGS_VERSION);
     }
+    //save all settings at once
+    if (!commit()) {
+        res = false;
+    }
     return res;
 }
 
@@ -25,11 +25,52 @@
 #define _SETTINGS_ESP3D_H
 
 #include <Arduino.h>
+#include "../include/esp3d_config.h"
+
+//Setting description flags
+#define SETTING_FLAG_REBOOT     1  //change needs a restart (R)
+#define SETTING_FLAG_SECRET     2  //value is never displayed
+#define SETTING_FLAG_NULLABLE   4  //can be empty (N / MS)
+#define SETTING_FLAG_SIGNED     8  //byte is an int8_t
+#define SETTING_FLAG_NETWORK    16 //reset with network settings
+#define SETTING_FLAG_INTERNAL   32 //not listed by ESP400
+
+//Setting description options
+#define SETTING_OPTIONS_NONE    0
+#define SETTING_OPTIONS_LIST    1 //json list in text
+#define SETTING_OPTIONS_RANGE   2 //every value from min to max
+#define SETTING_OPTIONS_BAUD    3 //supported baud rates
+#define SETTING_OPTIONS_SENSOR  4 //supported sensors
+
+//One entry per setting, ESP400 order
+typedef struct {
+    uint16_t pos;
+    char type;          //B(yte), I(nt32), A(ddress IP), S(tring)
+    uint8_t flags;
+    uint8_t options;
+    int32_t min;        //value or string size
+    uint32_t max;       //value or string size
+    uint32_t value;     //default of byte, int32 and IP
+    const char * section;
+    const char * label;
+    const char * text;  //default of string, options list of byte
+} esp3d_setting_desc_t;
 
 class Settings_ESP3D
 {
 public:
     static bool begin();
+    static void handle();
+    static bool commit();
+    static void discard();
+    static uint32_t cacheHits()
+    {
+        return _cacheHits;
+    }
+    static uint32_t flashCommits()
+    {
+        return _flashCommits;
+    }
     static uint8_t get_default_byte_value(int pos);
     static uint32_t get_default_int32_value(int pos);
     static uint32_t get_default_IP_value(int pos);
@@ -40,6 +81,9 @@ public:
     static uint32_t get_min_int32_value(int pos);
     static uint8_t get_max_byte(int pos);
     static int8_t get_min_byte(int pos);
+    static uint16_t get_settings_count();
+    static const esp3d_setting_desc_t * get_setting(uint16_t index);
+    static const esp3d_setting_desc_t * get_setting_by_pos(int pos);
     static uint8_t read_byte (int pos, bool * haserror = NULL);
     static uint32_t read_uint32(int pos, bool * haserror = NULL);
     static uint32_t read_IP(int pos, bool * haserror = NULL);
@@ -62,8 +106,24 @@ public:
     static bool isLocalPasswordValid (const char * password);
 private:
     static bool is_string(const char * s, uint len);
+    static bool _cacheBegin();
+    static bool _setDirty(int pos, uint8_t type);
     static uint8_t _FirmwareTarget;
     static bool _isverboseboot;
+    static bool _cacheStarted;
+    static bool _dirty;
+    static uint32_t _lastWrite;
+    static bool _commitFailed;
+    static uint32_t _cacheHits;
+    static uint32_t _flashCommits;
+#if ESP_SAVE_SETTINGS == SETTINGS_IN_PREFERENCES
+    static bool _cacheLoad(int pos, uint8_t type);
+    static uint8_t _cache[];
+    static uint8_t _cacheLoaded[];
+    static int _dirtyPos[];
+    static uint8_t _dirtyType[];
+    static uint16_t _dirtyCount;
+#endif //SETTINGS_IN_PREFERENCES
 };
 
 
@@ -166,6 +166,23 @@
 #error SD_UPDATE_FEATURE is not available because SD_DEVICE is not enabled
 #endif
 
+/**************************
+ * Websocket
+ * ***********************/
+#if defined(ESP_WS_DEFLATE_FEATURE) && defined(ARDUINO_ARCH_ESP8266)
+#error ESP_WS_DEFLATE_FEATURE is not available in ESP8266
+#endif
+#if defined(ESP_STATUS_CHANNEL_FEATURE) && !defined(HTTP_FEATURE)
+#error ESP_STATUS_CHANNEL_FEATURE is not available because HTTP_FEATURE is not enabled
+#endif
+
+/**************************
+ * Gcode host
+ * ***********************/
+#if defined(GCODE_HOST_INDEPENDANT_TASK) && !defined(SERIAL_INDEPENDANT_TASK)
+#error GCODE_HOST_INDEPENDANT_TASK is not available because SERIAL_INDEPENDANT_TASK is not enabled
+#endif
+
 #endif //ESP_NO_SANITY_CHECK
 
 #endif //SANITY_ESP3D_H 
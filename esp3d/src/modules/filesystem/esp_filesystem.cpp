@@ -30,6 +30,7 @@
 File tFile_handle[ESP_MAX_OPENHANDLE];
 
 bool ESP_FileSystem::_started = false;
+uint32_t ESP_FileSystem::_revision = 0;
 
 uint8_t ESP_FileSystem::getFSType(const char * path)
 {
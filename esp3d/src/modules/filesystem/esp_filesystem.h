@@ -90,8 +90,18 @@ public:
         return _started;
     }
     static uint8_t getFSType(const char * path=nullptr);
+    //revision is changed each time content may have been modified
+    static uint32_t revision()
+    {
+        return _revision;
+    }
+    static void notifyChange()
+    {
+        _revision++;
+    }
 private:
     static bool _started;
+    static uint32_t _revision;
 };
 
 
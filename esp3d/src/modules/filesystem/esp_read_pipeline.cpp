@@ -0,0 +1,257 @@
+/*
+  esp_read_pipeline.cpp - ESP3D double buffered file reader class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+//#define ESP_DEBUG_FEATURE DEBUG_OUTPUT_SERIAL0
+#include "../../include/esp3d_config.h"
+#if defined (SD_DEVICE) || defined (FILESYSTEM_FEATURE)
+#include "esp_read_pipeline.h"
+
+#if defined (ARDUINO_ARCH_ESP32)
+//loop task is on core 1, so reader goes on core 0 with network stack
+#define ESP_READ_PIPELINE_RUNNING_PRIORITY 1
+#define ESP_READ_PIPELINE_RUNNING_CORE 0
+
+typedef struct {
+    uint8_t index;
+    int len;
+} esp_read_block_t;
+#endif //ARDUINO_ARCH_ESP32
+
+ESP_ReadPipeline::ESP_ReadPipeline()
+{
+    _remaining = 0;
+    _blockSize = 0;
+    _buffer[0] = nullptr;
+    _buffer[1] = nullptr;
+#if defined (ARDUINO_ARCH_ESP32)
+    _task = nullptr;
+    _freeQueue = nullptr;
+    _filledQueue = nullptr;
+    _stop = false;
+    _running = false;
+    _held = -1;
+#endif //ARDUINO_ARCH_ESP32
+}
+
+ESP_ReadPipeline::~ESP_ReadPipeline()
+{
+    end();
+}
+
+bool ESP_ReadPipeline::isPipelined()
+{
+#if defined (ARDUINO_ARCH_ESP32)
+    return _task != nullptr;
+#else
+    return false;
+#endif //ARDUINO_ARCH_ESP32
+}
+
+#if defined (ARDUINO_ARCH_ESP32)
+void ESP_ReadPipeline::readerTask(void * parameter)
+{
+    ESP_ReadPipeline * pipeline = (ESP_ReadPipeline *)parameter;
+    //keep local copies so a late reader never uses released handles
+    QueueHandle_t freeQueue = pipeline->_freeQueue;
+    QueueHandle_t filledQueue = pipeline->_filledQueue;
+    uint8_t * buffer[2] = {pipeline->_buffer[0], pipeline->_buffer[1]};
+    reader_t reader = pipeline->_reader;
+    size_t remaining = pipeline->_remaining;
+    size_t blockSize = pipeline->_blockSize;
+    esp_read_block_t block;
+    while (!pipeline->_stop) {
+        if (xQueueReceive(freeQueue, &block.index, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (pipeline->_stop) {
+            break;
+        }
+        size_t toRead = (remaining < blockSize)?remaining:blockSize;
+        block.len = (toRead > 0)?reader(buffer[block.index], toRead):0;
+        if (block.len > 0) {
+            remaining -= block.len;
+        } else {
+            block.len = 0;
+        }
+        xQueueSend(filledQueue, &block, portMAX_DELAY);
+        //empty block means end of data
+        if (block.len == 0) {
+            break;
+        }
+    }
+    pipeline->_running = false;
+    vTaskDelete( NULL );
+}
+#endif //ARDUINO_ARCH_ESP32
+
+bool ESP_ReadPipeline::begin(reader_t reader, size_t total, size_t blockSize)
+{
+    end();
+    _reader = reader;
+    _remaining = total;
+    _blockSize = blockSize;
+    _buffer[0] = (uint8_t *)malloc(_blockSize);
+    if (!_buffer[0]) {
+        log_esp3d("Pipeline: no memory");
+        return false;
+    }
+#if defined (ARDUINO_ARCH_ESP32)
+    _buffer[1] = (uint8_t *)malloc(_blockSize);
+    //one extra slot on free queue for the stop request
+    _freeQueue = xQueueCreate(3, sizeof(uint8_t));
+    _filledQueue = xQueueCreate(2, sizeof(esp_read_block_t));
+    if (_buffer[1] && _freeQueue && _filledQueue) {
+        uint8_t index = 0;
+        xQueueSend(_freeQueue, &index, 0);
+        index = 1;
+        xQueueSend(_freeQueue, &index, 0);
+        _stop = false;
+        _running = true;
+        _held = -1;
+        BaseType_t  res =  xTaskCreatePinnedToCore(
+                               readerTask, /* Task function. */
+                               "ESP3D Reader Task", /* name of task. */
+                               4096, /* Stack size of task */
+                               this, /* parameter of the task */
+                               ESP_READ_PIPELINE_RUNNING_PRIORITY, /* priority of the task */
+                               &_task, /* Task handle to keep track of created task */
+                               ESP_READ_PIPELINE_RUNNING_CORE    /* Core to run the task */
+                           );
+        if (res == pdPASS && _task) {
+            log_esp3d("Pipeline: reader task started");
+            return true;
+        }
+        _task = nullptr;
+        _running = false;
+    }
+    //fallback to synchronous reading
+    log_esp3d("Pipeline: no reader task, read in place");
+    if (_buffer[1]) {
+        free(_buffer[1]);
+        _buffer[1] = nullptr;
+    }
+    if (_freeQueue) {
+        vQueueDelete(_freeQueue);
+        _freeQueue = nullptr;
+    }
+    if (_filledQueue) {
+        vQueueDelete(_filledQueue);
+        _filledQueue = nullptr;
+    }
+#endif //ARDUINO_ARCH_ESP32
+    return true;
+}
+
+const uint8_t * ESP_ReadPipeline::next(size_t & len)
+{
+    len = 0;
+#if defined (ARDUINO_ARCH_ESP32)
+    if (_task) {
+        //give back previous block to reader
+        if (_held != -1) {
+            uint8_t index = _held;
+            xQueueSend(_freeQueue, &index, 0);
+            _held = -1;
+        }
+        if (!_running && (uxQueueMessagesWaiting(_filledQueue) == 0)) {
+            return nullptr;
+        }
+        esp_read_block_t block;
+        if (xQueueReceive(_filledQueue, &block, pdMS_TO_TICKS(ESP_READ_PIPELINE_TIMEOUT)) != pdTRUE) {
+            log_esp3d("Pipeline: read timeout");
+            return nullptr;
+        }
+        if (block.len == 0) {
+            return nullptr;
+        }
+        _held = block.index;
+        len = block.len;
+        return _buffer[block.index];
+    }
+#endif //ARDUINO_ARCH_ESP32
+    if (!_buffer[0] || (_remaining == 0)) {
+        return nullptr;
+    }
+    size_t toRead = (_remaining < _blockSize)?_remaining:_blockSize;
+    int v = _reader(_buffer[0], toRead);
+    if (v <= 0) {
+        _remaining = 0;
+        return nullptr;
+    }
+    _remaining -= v;
+    len = v;
+    return _buffer[0];
+}
+
+void ESP_ReadPipeline::sync()
+{
+#if defined (ARDUINO_ARCH_ESP32)
+    if (!_task) {
+        return;
+    }
+    //reader is idle once both buffers are filled or held
+    uint32_t start = millis();
+    while (_running && ((uxQueueMessagesWaiting(_filledQueue) + ((_held != -1)?1:0)) < 2)
+            && ((millis() - start) < ESP_READ_PIPELINE_TIMEOUT)) {
+        Hal::wait(0);
+    }
+#endif //ARDUINO_ARCH_ESP32
+}
+
+void ESP_ReadPipeline::end()
+{
+#if defined (ARDUINO_ARCH_ESP32)
+    if (_task) {
+        _stop = true;
+        //wake up reader if it waits for a free buffer
+        uint8_t index = 0;
+        xQueueSend(_freeQueue, &index, 0);
+        //no timeout: reader uses this object and the caller's file,
+        //both must stay valid until the current read returns
+        uint32_t start = millis();
+        while (_running) {
+            if ((millis() - start) > ESP_READ_PIPELINE_TIMEOUT) {
+                log_esp3d("Pipeline: reader task is slow to stop");
+                start = millis();
+            }
+            Hal::wait(1);
+        }
+        _task = nullptr;
+    }
+    if (_freeQueue) {
+        vQueueDelete(_freeQueue);
+        _freeQueue = nullptr;
+    }
+    if (_filledQueue) {
+        vQueueDelete(_filledQueue);
+        _filledQueue = nullptr;
+    }
+    _held = -1;
+#endif //ARDUINO_ARCH_ESP32
+    for (uint8_t i = 0; i < 2; i++) {
+        if (_buffer[i]) {
+            free(_buffer[i]);
+            _buffer[i] = nullptr;
+        }
+    }
+    _remaining = 0;
+    _reader = nullptr;
+}
+
+#endif //SD_DEVICE || FILESYSTEM_FEATURE
@@ -0,0 +1,73 @@
+/*
+  esp_read_pipeline.h - ESP3D double buffered file reader class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _ESP_READ_PIPELINE_H
+#define _ESP_READ_PIPELINE_H
+#include "../../include/esp3d_config.h"
+#include <functional>
+
+#if defined (ARDUINO_ARCH_ESP32)
+#define ESP_READ_PIPELINE_BLOCK_SIZE 4096
+#endif //ARDUINO_ARCH_ESP32
+#if defined (ARDUINO_ARCH_ESP8266)
+#define ESP_READ_PIPELINE_BLOCK_SIZE 1024
+#endif //ARDUINO_ARCH_ESP8266
+
+//max time to wait for a block from reader task
+#define ESP_READ_PIPELINE_TIMEOUT 5000
+
+//Two buffers are used: on ESP32 a task running on the other core
+//fills one buffer from the file while the caller sends the other one.
+//On ESP8266 (or if task cannot be created) reading is done in next()
+//so callers do not need to care about the mode.
+class ESP_ReadPipeline
+{
+public:
+    //read up to size bytes to buf, return number of bytes read, 0 or -1 at end
+    typedef std::function<int(uint8_t * buf, size_t size)> reader_t;
+    ESP_ReadPipeline();
+    ~ESP_ReadPipeline();
+    bool begin(reader_t reader, size_t total, size_t blockSize = ESP_READ_PIPELINE_BLOCK_SIZE);
+    //return next block and its size, nullptr at end of data or on error
+    //returned block stays valid until next call of next() or end()
+    const uint8_t * next(size_t & len);
+    //wait until reader task no longer accesses the file, so the caller
+    //can give hand to other file users between two next()
+    void sync();
+    //must be called before the file used by the reader is closed
+    void end();
+    bool isPipelined();
+private:
+    reader_t _reader;
+    size_t _remaining;
+    size_t _blockSize;
+    uint8_t * _buffer[2];
+#if defined (ARDUINO_ARCH_ESP32)
+    static void readerTask(void * parameter);
+    TaskHandle_t _task;
+    QueueHandle_t _freeQueue;
+    QueueHandle_t _filledQueue;
+    volatile bool _stop;
+    volatile bool _running;
+    int8_t _held;
+#endif //ARDUINO_ARCH_ESP32
+};
+
+#endif //_ESP_READ_PIPELINE_H
@@ -37,6 +37,8 @@ public:
     operator bool() const;
     bool isDirectory();
     bool seek(uint32_t pos, uint8_t mode = ESP_SEEK_SET);
+    //reserve contiguous space for a new empty file, false if not supported
+    bool preAllocate(size_t length);
     const char* name() const;
     const char* shortname() const;
     const char* filename() const;
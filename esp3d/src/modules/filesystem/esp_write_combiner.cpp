@@ -0,0 +1,122 @@
+/*
+  esp_write_combiner.cpp - ESP3D buffered file writer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+//#define ESP_DEBUG_FEATURE DEBUG_OUTPUT_SERIAL0
+#include "../../include/esp3d_config.h"
+#if defined (SD_DEVICE) || defined (FILESYSTEM_FEATURE)
+#include "esp_write_combiner.h"
+
+ESP_WriteCombiner::ESP_WriteCombiner()
+{
+    _buffer = nullptr;
+    _bufferSize = 0;
+    _used = 0;
+    _total = 0;
+}
+
+ESP_WriteCombiner::~ESP_WriteCombiner()
+{
+    end();
+}
+
+bool ESP_WriteCombiner::begin(writer_t writer, size_t bufferSize)
+{
+    end();
+    _writer = writer;
+    _bufferSize = bufferSize;
+    _buffer = (uint8_t *)malloc(_bufferSize);
+    if (!_buffer) {
+        log_esp3d("Combiner: no memory, write directly");
+        return false;
+    }
+    return true;
+}
+
+size_t ESP_WriteCombiner::write(const uint8_t * buf, size_t size)
+{
+    if (!_writer) {
+        return 0;
+    }
+    if (!_buffer) {
+        size_t w = _writer(buf, size);
+        _total += w;
+        return w;
+    }
+    size_t done = 0;
+    while (done < size) {
+        size_t remaining = size - done;
+        //nothing pending: write full buffers directly, no need to copy
+        if ((_used == 0) && (remaining >= _bufferSize)) {
+            size_t toWrite = remaining - (remaining % _bufferSize);
+            size_t w = _writer(&buf[done], toWrite);
+            _total += w;
+            done += w;
+            if (w != toWrite) {
+                log_esp3d("Combiner: write failed");
+                return done;
+            }
+            continue;
+        }
+        size_t toCopy = _bufferSize - _used;
+        if (toCopy > remaining) {
+            toCopy = remaining;
+        }
+        memcpy(&_buffer[_used], &buf[done], toCopy);
+        _used += toCopy;
+        done += toCopy;
+        if ((_used == _bufferSize) && !flush()) {
+            return done - toCopy;
+        }
+    }
+    return done;
+}
+
+bool ESP_WriteCombiner::flush()
+{
+    if (!_buffer || (_used == 0)) {
+        return true;
+    }
+    size_t w = _writer(_buffer, _used);
+    _total += w;
+    if (w != _used) {
+        log_esp3d("Combiner: flush failed %d vs %d", w, _used);
+        _used = 0;
+        return false;
+    }
+    _used = 0;
+    return true;
+}
+
+void ESP_WriteCombiner::end()
+{
+    if (_buffer) {
+        free(_buffer);
+        _buffer = nullptr;
+    }
+    _used = 0;
+    _total = 0;
+    _writer = nullptr;
+}
+
+size_t ESP_WriteCombiner::total()
+{
+    return _total;
+}
+
+#endif //SD_DEVICE || FILESYSTEM_FEATURE
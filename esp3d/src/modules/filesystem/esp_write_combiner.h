@@ -0,0 +1,60 @@
+/*
+  esp_write_combiner.h - ESP3D buffered file writer class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _ESP_WRITE_COMBINER_H
+#define _ESP_WRITE_COMBINER_H
+#include "../../include/esp3d_config.h"
+#include <functional>
+
+//must be a multiple of 512 (SD sector size)
+#if defined (ARDUINO_ARCH_ESP32)
+#define ESP_WRITE_COMBINER_SIZE 8192
+#endif //ARDUINO_ARCH_ESP32
+#if defined (ARDUINO_ARCH_ESP8266)
+#define ESP_WRITE_COMBINER_SIZE 4096
+#endif //ARDUINO_ARCH_ESP8266
+
+//Accumulate small chunks (e.g. upload packets) so file is written
+//by full buffers only, which keep SD writes sector aligned
+class ESP_WriteCombiner
+{
+public:
+    //write size bytes from buf, return number of bytes written
+    typedef std::function<size_t(const uint8_t * buf, size_t size)> writer_t;
+    ESP_WriteCombiner();
+    ~ESP_WriteCombiner();
+    //return false if no buffer could be allocated, data are then written directly
+    bool begin(writer_t writer, size_t bufferSize = ESP_WRITE_COMBINER_SIZE);
+    size_t write(const uint8_t * buf, size_t size);
+    //must be called before closing file
+    bool flush();
+    //release buffer, pending data not flushed are lost
+    void end();
+    //bytes actually written to file
+    size_t total();
+private:
+    writer_t _writer;
+    uint8_t * _buffer;
+    size_t _bufferSize;
+    size_t _used;
+    size_t _total;
+};
+
+#endif //_ESP_WRITE_COMBINER_H
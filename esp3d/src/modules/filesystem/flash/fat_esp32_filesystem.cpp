@@ -61,6 +61,7 @@ uint ESP_FileSystem::maxPathLength()
 
 bool ESP_FileSystem::rename(const char *oldpath, const char *newpath)
 {
+    notifyChange();
     return FFat.rename(oldpath,newpath);
 }
 
@@ -71,6 +72,7 @@ const char * ESP_FileSystem::FilesystemName()
 
 bool ESP_FileSystem::format()
 {
+    notifyChange();
     bool res = FFat.format();
     if (res) {
         res = begin();
@@ -80,6 +82,9 @@ bool ESP_FileSystem::format()
 
 ESP_File ESP_FileSystem::open(const char* path, uint8_t mode)
 {
+    if (mode != ESP_FILE_READ) {
+        notifyChange();
+    }
     log_esp3d("open %s as %s", path,(mode == ESP_FILE_WRITE?"write":"read") );
     //do some check
     if(((strcmp(path,"/") == 0) && ((mode == ESP_FILE_WRITE) || (mode == ESP_FILE_APPEND))) || (strlen(path) == 0)) {
@@ -123,6 +128,7 @@ bool ESP_FileSystem::exists(const char* path)
 
 bool ESP_FileSystem::remove(const char *path)
 {
+    notifyChange();
     return FFat.remove(path);
 }
 
@@ -142,6 +148,7 @@ bool ESP_FileSystem::mkdir(const char *path)
 
 bool ESP_FileSystem::rmdir(const char *path)
 {
+    notifyChange();
     String p = path;
     if (!p.startsWith("/")) {
         p = '/'+p;
@@ -265,6 +272,7 @@ void ESP_File::close()
         //reopen if mode = write
         //udate size + date
         if (_iswritemode && !_isdir) {
+            ESP_FileSystem::notifyChange();
             log_esp3d("Updating %s size", _filename.c_str());
             File ftmp = FFat.open(_filename.c_str());
             if (ftmp) {
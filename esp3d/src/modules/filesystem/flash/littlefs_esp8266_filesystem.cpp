@@ -64,6 +64,7 @@ uint ESP_FileSystem::maxPathLength()
 
 bool ESP_FileSystem::rename(const char *oldpath, const char *newpath)
 {
+    notifyChange();
     return LittleFS.rename(oldpath,newpath);
 }
 
@@ -74,6 +75,7 @@ const char * ESP_FileSystem::FilesystemName()
 
 bool ESP_FileSystem::format()
 {
+    notifyChange();
     bool res = LittleFS.format();
     if (res) {
         res = begin();
@@ -83,6 +85,9 @@ bool ESP_FileSystem::format()
 
 ESP_File ESP_FileSystem::open(const char* path, uint8_t mode)
 {
+    if (mode != ESP_FILE_READ) {
+        notifyChange();
+    }
     //do some check
     if(((strcmp(path,"/") == 0) && ((mode == ESP_FILE_WRITE) || (mode == ESP_FILE_APPEND))) || (strlen(path) == 0)) {
         return ESP_File();
@@ -128,6 +133,7 @@ bool ESP_FileSystem::exists(const char* path)
 
 bool ESP_FileSystem::remove(const char *path)
 {
+    notifyChange();
     String p = path;
     if(p[0]!='/') {
         p="/"+p;
@@ -153,6 +159,7 @@ bool ESP_FileSystem::mkdir(const char *path)
 
 bool ESP_FileSystem::rmdir(const char *path)
 {
+    notifyChange();
     String p = path;
     if (!p.endsWith("/")) {
         p+= '/';
@@ -287,6 +294,7 @@ void ESP_File::close()
         //reopen if mode = write
         //udate size + date
         if (_iswritemode && !_isdir) {
+            ESP_FileSystem::notifyChange();
             log_esp3d("Updating Size of %s",_filename.c_str());
             File ftmp = LittleFS.open(_filename.c_str(), "r");
             if (ftmp) {
@@ -59,6 +59,7 @@ uint ESP_FileSystem::maxPathLength()
 
 bool ESP_FileSystem::rename(const char *oldpath, const char *newpath)
 {
+    notifyChange();
     return SPIFFS.rename(oldpath,newpath);
 }
 
@@ -69,6 +70,7 @@ const char * ESP_FileSystem::FilesystemName()
 
 bool ESP_FileSystem::format()
 {
+    notifyChange();
     bool res = SPIFFS.format();
     if (res) {
         res = begin();
@@ -78,6 +80,9 @@ bool ESP_FileSystem::format()
 
 ESP_File ESP_FileSystem::open(const char* path, uint8_t mode)
 {
+    if (mode != ESP_FILE_READ) {
+        notifyChange();
+    }
     //do some check
     if(((strcmp(path,"/") == 0) && ((mode == ESP_FILE_WRITE) || (mode == ESP_FILE_APPEND))) || (strlen(path) == 0)) {
         return ESP_File();
@@ -139,6 +144,7 @@ bool ESP_FileSystem::exists(const char* path)
 
 bool ESP_FileSystem::remove(const char *path)
 {
+    notifyChange();
     String p = path;
     if(p[0]!='/') {
         p="/"+p;
@@ -166,6 +172,7 @@ bool ESP_FileSystem::mkdir(const char *path)
 
 bool ESP_FileSystem::rmdir(const char *path)
 {
+    notifyChange();
     String spath = path;
     spath.trim();
     if (!spath.startsWith("/")) {
@@ -282,6 +289,7 @@ void ESP_File::close()
         //reopen if mode = write
         //udate size + date
         if (_iswritemode && !_isdir) {
+            ESP_FileSystem::notifyChange();
             File ftmp = SPIFFS.open(_filename.c_str());
             if (ftmp) {
                 _size = ftmp.size();
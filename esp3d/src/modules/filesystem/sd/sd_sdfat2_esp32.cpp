@@ -447,6 +447,14 @@ bool ESP_SDFile::seek(uint32_t pos, uint8_t mode)
     return tSDFile_handle[_index].seek(pos);
 }
 
+bool ESP_SDFile::preAllocate(size_t length)
+{
+    if ((_index == -1) || _isdir || !_iswritemode || (length == 0)) {
+        return false;
+    }
+    return tSDFile_handle[_index].preAllocate(length);
+}
+
 ESP_SDFile::ESP_SDFile(void* handle, bool isdir, bool iswritemode, const char * path)
 {
     _isdir = isdir;
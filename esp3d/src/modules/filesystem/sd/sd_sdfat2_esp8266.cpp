@@ -413,6 +413,14 @@ bool ESP_SDFile::seek(uint32_t pos, uint8_t mode)
     return tSDFile_handle[_index].seekSet(pos);
 }
 
+bool ESP_SDFile::preAllocate(size_t length)
+{
+    if ((_index == -1) || _isdir || !_iswritemode || (length == 0)) {
+        return false;
+    }
+    return tSDFile_handle[_index].preAllocate(length);
+}
+
 void ESP_SD::closeAll()
 {
     for (uint8_t i = 0; i < ESP_MAX_SD_OPENHANDLE; i++) {
@@ -339,6 +339,13 @@ bool ESP_SDFile::seek(uint32_t pos, uint8_t mode)
     return tSDFile_handle[_index].seek(pos, (SeekMode)mode);
 }
 
+bool ESP_SDFile::preAllocate(size_t length)
+{
+    //not supported by this SD library
+    (void)length;
+    return false;
+}
+
 void ESP_SDFile::close()
 {
     if (_index != -1) {
@@ -76,6 +76,10 @@
 #include "../authentication/authentication_service.h"
 #include "../../core/settings_esp3d.h"
 #include "../../core/esp3doutput.h"
+#include "../filesystem/esp_read_pipeline.h"
+#ifdef ESP_BENCHMARK_FEATURE
+#include "../../core/benchmark.h"
+#endif //ESP_BENCHMARK_FEATURE
 #if FTP_FEATURE == FS_ROOT
 #include "../filesystem/esp_globalFS.h"
 typedef  ESP_GBFile FTPFile;
@@ -102,6 +106,13 @@ typedef  ESP_SD FTPFS;
 
 FTPFile  dir;
 FTPFile  file;
+//next block of retrieved file is read while current one is sent
+static ESP_ReadPipeline retrievePipeline;
+
+static int readRetrievedFile(uint8_t * rbuf, size_t size)
+{
+    return (int)file.read( rbuf, size );
+}
 
 FtpServer ftp_server;
 
@@ -744,12 +755,21 @@ bool FtpServer::processCommand()
                     log_esp3d("FTP: releaseFS");
                     releaseFS();
                 } else if( dataConnect( false )) {
-                    log_esp3d(" Sending %s", parameter);
-                    client << F("150-Connected to port ") << dataPort << eol;
-                    client << F("150 ") << file.size() << F(" bytes to download") << eol;
-                    millisBeginTrans = millis();
-                    bytesTransfered = 0;
-                    transferStage = FTP_Retrieve;
+                    if( ! retrievePipeline.begin(readRetrievedFile, file.size())) {
+                        client << F("451 Not enough memory") << eol;
+                        file.close();
+                        data.stop();
+                        log_esp3d("FTP: releaseFS");
+                        releaseFS();
+                    } else {
+                        log_esp3d(" Sending %s", parameter);
+                        client << F("150-Connected to port ") << dataPort << eol;
+                        client << F("150 ") << file.size() << F(" bytes to download") << eol;
+                        millisBeginTrans = millis();
+                        bytesTransfered = 0;
+                        transferStage = FTP_Retrieve;
+                        retrievePipeline.sync();
+                    }
                 }
             }
         }
@@ -1043,15 +1063,22 @@ bool FtpServer::dataConnected()
 bool FtpServer::doRetrieve()
 {
     if( ! dataConnected()) {
+        retrievePipeline.end();
         file.close();
         return false;
     }
-    int16_t nb = file.read( buf, FTP_BUF_SIZE );
-    if( nb > 0 ) {
-        data.write( buf, nb );
+    size_t nb = 0;
+    const uint8_t * block = retrievePipeline.next( nb );
+    if( block ) {
+        data.write( block, nb );
         bytesTransfered += nb;
+        //do not let reader access file while other services run
+        retrievePipeline.sync();
         return true;
     }
+#ifdef ESP_BENCHMARK_FEATURE
+    benchMark(retrievePipeline.isPipelined()?"FTP download (pipelined)":"FTP download", millisBeginTrans, millis(), bytesTransfered);
+#endif //ESP_BENCHMARK_FEATURE
     closeTransfer();
     return false;
 }
@@ -1156,6 +1183,7 @@ void FtpServer::closeTransfer()
         client << F("226 File successfully transferred") << eol;
     }
 
+    retrievePipeline.end();
     file.close();
     data.stop();
 }
@@ -1163,6 +1191,7 @@ void FtpServer::closeTransfer()
 void FtpServer::abortTransfer()
 {
     if( transferStage != FTP_Close ) {
+        retrievePipeline.end();
         file.close();
         dir.close();
         client << F("426 Transfer aborted") << eol;
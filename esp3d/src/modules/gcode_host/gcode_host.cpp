@@ -30,11 +30,87 @@
 #if defined(SD_DEVICE)
 #include "../filesystem/esp_sd.h"
 #endif //SD_DEVICE
+#ifdef ESP_BENCHMARK_FEATURE
+#include "../../core/benchmark.h"
+#endif //ESP_BENCHMARK_FEATURE
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+#include "../serial/serial_service.h"
+#endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
 
 GcodeHost esp3d_gcode_host;
 
+#if defined(ESP_HOST_TASK)
+//Hold the host mutex until end of scope, recursive as public functions call each other
+class HostLock
+{
+public:
+    HostLock(SemaphoreHandle_t mutex)
+    {
+        _mutex = mutex;
+        _locked = _mutex && (xSemaphoreTakeRecursive(_mutex, MUTEX_TIMEOUT / portTICK_PERIOD_MS) == pdTRUE);
+        if (_mutex && !_locked) {
+            log_esp3d("Host mutex timeout");
+        }
+    }
+    ~HostLock()
+    {
+        if (_locked) {
+            xSemaphoreGiveRecursive(_mutex);
+        }
+    }
+    bool locked()
+    {
+        return _locked || !_mutex;
+    }
+private:
+    SemaphoreHandle_t _mutex;
+    bool _locked;
+};
+//state is never touched without the lock, caller will try again on next pass
+#define HOST_LOCK(ret) HostLock hostLock(_mutex); if (!hostLock.locked()) { return ret; }
+#else
+#define HOST_LOCK(ret)
+#endif //ESP_HOST_TASK
+
+#if (defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)) && ESP_HOST_INDEX_SIDECAR
+//"EID2"
+#define ESP_HOST_INDEX_MAGIC 0x32444945
+typedef struct {
+    uint32_t magic;
+    uint32_t fileSize;
+    uint32_t fileTime;
+    uint32_t fileHash;
+    uint32_t step;
+    uint32_t count;
+} esp_host_index_header_t;
+
+//Sidecar layout: header, then count line numbers, then count offsets
+template <class T> static bool readIndexFile(T & file, esp_host_index_header_t & header, uint32_t * lines, uint32_t * offsets)
+{
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+    if ((header.magic != ESP_HOST_INDEX_MAGIC) || (header.count > ESP_HOST_INDEX_SIZE)) {
+        return false;
+    }
+    size_t size = header.count * sizeof(uint32_t);
+    return (file.read((uint8_t *)lines, size) == size) && (file.read((uint8_t *)offsets, size) == size);
+}
+
+template <class T> static bool writeIndexFile(T & file, esp_host_index_header_t & header, uint32_t * lines, uint32_t * offsets)
+{
+    size_t size = header.count * sizeof(uint32_t);
+    return (file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header))
+           && (file.write((const uint8_t *)lines, size) == size)
+           && (file.write((const uint8_t *)offsets, size) == size);
+}
+#endif //(FILESYSTEM_FEATURE || SD_DEVICE) && ESP_HOST_INDEX_SIDECAR
+
 GcodeHost::GcodeHost()
 {
+#if defined(ESP_HOST_TASK)
+    _mutex = nullptr;
+#endif //ESP_HOST_TASK
     reset();
 }
 
@@ -45,12 +121,24 @@ GcodeHost::~GcodeHost()
 
 bool GcodeHost::begin()
 {
+#if defined(ESP_HOST_TASK)
+    //never deleted, serial task may still be using it
+    if (!_mutex) {
+        _mutex = xSemaphoreCreateRecursiveMutex();
+        if (!_mutex) {
+            log_esp3d("Host mutex creation failed");
+            return false;
+        }
+    }
+#endif //ESP_HOST_TASK
+    HOST_LOCK(false);
     reset();
     return true;
 }
 
 void GcodeHost::end()
 {
+    HOST_LOCK();
     reset();
 }
 
@@ -78,12 +166,36 @@ void GcodeHost::reset()
     _processedSize = 0;
     _saveProcessedSize = 0;
     _auth_type = LEVEL_GUEST;
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+    _fileBufferSize = 0;
+    _fileBufferPos = 0;
+    _fileBufferOffset = 0;
+    _indexCount = 0;
+    _indexStep = ESP_HOST_INDEX_STEP;
+    _indexFileName = "";
+    _indexFsType = TYPE_SCRIPT_STREAM;
+    _indexFileSize = 0;
+    _indexFileTime = 0;
+    _indexFileHash = 0;
+    _fileHash = 0;
+#if ESP_HOST_INDEX_SIDECAR
+    _indexDirty = false;
+#endif //ESP_HOST_INDEX_SIDECAR
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
+#ifdef ESP_BENCHMARK_FEATURE
+    _benchStart = 0;
+    _benchLines = 0;
+#endif //ESP_BENCHMARK_FEATURE
+#if ESP_HOST_WINDOW_SIZE > 1
+    _resetWindow();
+#endif //ESP_HOST_WINDOW_SIZE > 1
 }
 
 
 //Input/response from the serial port to sbuf
 bool GcodeHost::push(const uint8_t * sbuf, size_t len)
 {
+    HOST_LOCK(false);
     log_esp3d("Push got %d bytes", len);
     for (size_t i = 0; i < len; i++) {
         //Found a line end, flush it
@@ -110,7 +222,8 @@ bool GcodeHost::push(const uint8_t * sbuf, size_t len)
 
 bool GcodeHost::_isAck(String & line)
 { //should probably also consider "invalid command" messages as Ack if they don't send one seperately
-    if (line.indexOf("ok") != -1) {
+    //"ok" alone or followed by parameters, not a message that contains it
+    if (line.startsWith("ok") && ((line.length() == 2) || (line[2] == ' '))) {
         log_esp3d("got ok");
         return true;
     }
@@ -133,6 +246,13 @@ bool GcodeHost::_isBusy(String & line)
     return false;
 }
 
+//Line number or checksum errors are followed by a resend request
+//so stream can continue
+bool GcodeHost::_isResendError(String & line)
+{
+    return (line.indexOf("line number") != -1) || (line.indexOf("checksum") != -1) || (line.indexOf("expected line") != -1) || (line.indexOf("last line") != -1);
+}
+
 uint32_t GcodeHost::_resendCommandNumber(String & line)
 {
     uint32_t l = 0;
@@ -173,6 +293,10 @@ void GcodeHost::_flush()
         if (_needAck == true){
             _needAck = false;
             _noTimeout = false;
+#if ESP_HOST_WINDOW_SIZE > 1
+        } else if (_ackWindow(_response)) {
+            _startTimeOut = millis();
+#endif //ESP_HOST_WINDOW_SIZE > 1
         } else {
             log_esp3d("Got ok but out of the query");
         }
@@ -184,14 +308,28 @@ void GcodeHost::_flush()
     
     } else {
         if (_response.indexOf("error") != -1) {
-            log_esp3d("Got error");
-            _step = HOST_ERROR_STREAM;
+            if (_isResendError(_response)) {
+                log_esp3d("Got error, wait for resend");
+            } else {
+                log_esp3d("Got error");
+                _step = HOST_ERROR_STREAM;
+            }
         }
     }
 
-    if ((_commandNumberToResend = _resendCommandNumber(_response)) != 0){
-        if (_needAck == false){
-            log_esp3d("Got resend out of the query");
+    uint32_t resend = _resendCommandNumber(_response);
+    if (resend != 0) {
+#if ESP_HOST_WINDOW_SIZE > 1
+        //line still in window, no need to seek in file
+        if (_resendWindow(resend)) {
+            resend = 0;
+        }
+#endif //ESP_HOST_WINDOW_SIZE > 1
+        if (resend != 0) {
+            _commandNumberToResend = resend;
+            if (_needAck == false){
+                log_esp3d("Got resend out of the query");
+            }
         }
     }
 
@@ -260,10 +398,18 @@ bool GcodeHost::_startStream()
         }
     }
 #endif //SD_DEVICE
-#if defined(FILESYSTEM_FEATURE) || defined(SDSUPPORT)
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
     _currentPosition = 0;
     _processedSize = 0;
     _currentCommand = "";
+    _fileBufferSize = 0;
+    _fileBufferPos = 0;
+    _fileBufferOffset = 0;
+    _fileHash = _hashFile();
+#ifdef ESP_BENCHMARK_FEATURE
+    _benchStart = millis();
+    _benchLines = 0;
+#endif //ESP_BENCHMARK_FEATURE
 
     _error = ERROR_NO_ERROR;
     _startTimeOut =millis();
@@ -278,6 +424,18 @@ bool GcodeHost::_startStream()
 void GcodeHost::_endStream()
 {
     log_esp3d("Ending Stream");
+#ifdef ESP_BENCHMARK_FEATURE
+    if ((_fsType == TYPE_FS_STREAM) || (_fsType == TYPE_SD_STREAM)) {
+        uint64_t bench_end = millis();
+        benchMark("Host stream", _benchStart, bench_end, _processedSize);
+        if (bench_end > _benchStart) {
+            report_esp3d("REPORT: Host stream %u lines, %.2f lines/s", _benchLines, 1000.F * _benchLines / (bench_end - _benchStart));
+        }
+    }
+#endif //ESP_BENCHMARK_FEATURE
+#if (defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)) && ESP_HOST_INDEX_SIDECAR
+    _indexSave();
+#endif //(FILESYSTEM_FEATURE || SD_DEVICE) && ESP_HOST_INDEX_SIDECAR
 #if defined(FILESYSTEM_FEATURE)
     if (_fsType == TYPE_FS_STREAM) {
         if (fileHandle.isOpen()) {
@@ -302,6 +460,7 @@ void GcodeHost::_endStream()
 
 bool GcodeHost::sendCommand(const uint8_t* injection, size_t len, level_authenticate_type auth_type, ESP3DOutput * output)
 {   
+    HOST_LOCK(false);
 #ifdef AUTHENTICATION_FEATURE
     if(auth_type < LEVEL_USER){
         log_esp3d("Sending commands requires user level authorization or greater");
@@ -372,100 +531,315 @@ bool GcodeHost::sendCommand(const uint8_t* injection, size_t len, level_authenti
     return true;
 }
 
-// Read the next line for processing from the script, FS file or SD file.
-//may be better to have seperate function for injection and check _injectionQueued in Handle
-void GcodeHost::_readNextCommand()
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+//Return next char of the streamed file, or -1 at end of file
+//File is read by blocks aligned on ESP_HOST_FILE_BUFFER_SIZE, instead of one byte per read
+int GcodeHost::_readFileChar()
 {
-    if (_step == HOST_READ_LINE){
-        _step = HOST_PROCESS_LINE;
+    _processedSize++;
+    _currentPosition++;
+    if (_fileBufferPos >= _fileBufferSize) {
+        _fileBufferOffset += _fileBufferSize;
+        //first read after a seek may not be aligned, so only read up to next block boundary
+        size_t toRead = ESP_HOST_FILE_BUFFER_SIZE - (_fileBufferOffset % ESP_HOST_FILE_BUFFER_SIZE);
+        _fileBufferSize = 0;
+        _fileBufferPos = 0;
+#if defined(FILESYSTEM_FEATURE)
+        if (_fsType == TYPE_FS_STREAM) {
+            _fileBufferSize = fileHandle.read(_fileBuffer, toRead);
+        }
+#endif //FILESYSTEM_FEATURE
+#if defined(SD_DEVICE)
+        if (_fsType == TYPE_SD_STREAM) {
+            _fileBufferSize = SDfileHandle.read(_fileBuffer, toRead);
+        }
+#endif //SD_DEVICE
+        //read may return -1 as size_t on error
+        if ((_fileBufferSize == 0) || (_fileBufferSize > toRead)) {
+            _fileBufferSize = 0;
+            return -1;
+        }
     }
+    return _fileBuffer[_fileBufferPos++];
+}
 
-
+//Move in streamed file and drop the block cache
+void GcodeHost::_seekFile(uint32_t pos)
+{
 #if defined(FILESYSTEM_FEATURE)
     if (_fsType ==TYPE_FS_STREAM) {
-        _processedSize++;
-        _currentPosition++; 
-        char c = (char)fileHandle.read(); //does casting need to be explicit? probably for the best for now at least
-        while (((c =='\n') || (c =='\r') || (c == ' '))){ //ignore any leading spaces and empty lines
-            _processedSize++;
-            _currentPosition++;
-            c = (char)fileHandle.read();
+        fileHandle.seek(pos);
+    }
+#endif //FILESYSTEM_FEATURE
+#if defined(SD_DEVICE)
+    if (_fsType ==TYPE_SD_STREAM) {
+        SDfileHandle.seek(pos);
+    }
+#endif //SD_DEVICE
+    _fileBufferOffset = pos;
+    _fileBufferSize = 0;
+    _fileBufferPos = 0;
+}
+
+//Same name, size and time may be another content (e.g. time is 0 on some filesystems)
+//so index is also keyed on first and last blocks, block cache is used to read them
+uint32_t GcodeHost::_hashFile()
+{
+    if ((_fsType != TYPE_FS_STREAM) && (_fsType != TYPE_SD_STREAM)) {
+        return 0;
+    }
+    uint32_t hash = 2166136261UL;
+    uint32_t starts[2] = {0, (_totalSize > (2 * ESP_HOST_FILE_BUFFER_SIZE))?(uint32_t)(_totalSize - ESP_HOST_FILE_BUFFER_SIZE):ESP_HOST_FILE_BUFFER_SIZE};
+    for (uint8_t b = 0; (b < 2) && (starts[b] < _totalSize); b++) {
+        _seekFile(starts[b]);
+        size_t len = 0;
+#if defined(FILESYSTEM_FEATURE)
+        if (_fsType == TYPE_FS_STREAM) {
+            len = fileHandle.read(_fileBuffer, ESP_HOST_FILE_BUFFER_SIZE);
         }
-        while (c == ';'){ // while its a full line comment, read on to the next line
-            _processedSize++;
-            _currentPosition++;
-            c = (char)fileHandle.read();
-            while (!((c =='\n') || (c =='\r') || (c == 0) || (c == -1))){ //skim to end of line
-                _processedSize++;
-                _currentPosition++;
-                c = (char)fileHandle.read();
-            }
-            while (((c =='\n') || (c =='\r') || (c == ' '))){ //ignore any leading spaces and empty lines
-                _processedSize++;
-                _currentPosition++;
-                c = (char)fileHandle.read();
-            }
+#endif //FILESYSTEM_FEATURE
+#if defined(SD_DEVICE)
+        if (_fsType == TYPE_SD_STREAM) {
+            len = SDfileHandle.read(_fileBuffer, ESP_HOST_FILE_BUFFER_SIZE);
+        }
+#endif //SD_DEVICE
+        if (len > ESP_HOST_FILE_BUFFER_SIZE) {
+            break;
+        }
+        //FNV-1a
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ _fileBuffer[i]) * 16777619UL;
         }
+    }
+    _seekFile(0);
+    return hash;
+}
 
-        while (!((c == '\n') || (c =='\r') || (c == 0) || (c == -1) || (_currentPosition > _totalSize))){ // while not end of line or end of file
-            if (c == ';'){ //reached a comment, skip to next line
-                while (!((c =='\n') || (c =='\r') || (c == 0) || (c == -1))){ //skim to end of line
-                    _processedSize++;
-                    _currentPosition++;
-                    c = (char)fileHandle.read();
-                }
-            } else { //no comment yet, read into command
-                _currentCommand += c;
-                _processedSize++;
-                _currentPosition++;
-                c = (char)fileHandle.read();
+//Make sure index belongs to the streamed file, if not reset it (or load it from sidecar)
+bool GcodeHost::_indexSelect()
+{
+    time_t fileTime = 0;
+    if ((_fsType != TYPE_FS_STREAM) && (_fsType != TYPE_SD_STREAM)) {
+        return false;
+    }
+#if defined(FILESYSTEM_FEATURE)
+    if (_fsType == TYPE_FS_STREAM) {
+        if (!fileHandle.isOpen()) {
+            return false;
+        }
+        fileTime = fileHandle.getLastWrite();
+    }
+#endif //FILESYSTEM_FEATURE
+#if defined(SD_DEVICE)
+    if (_fsType == TYPE_SD_STREAM) {
+        if (!SDfileHandle.isOpen()) {
+            return false;
+        }
+        fileTime = SDfileHandle.getLastWrite();
+    }
+#endif //SD_DEVICE
+    if ((_indexFsType == _fsType) && (_indexFileSize == _totalSize) && (_indexFileTime == fileTime) && (_indexFileHash == _fileHash) && (_indexFileName == _fileName)) {
+        return true;
+    }
+    log_esp3d("New line index for %s", _fileName.c_str());
+    _indexCount = 0;
+    _indexStep = ESP_HOST_INDEX_STEP;
+    _indexFileName = _fileName;
+    _indexFsType = _fsType;
+    _indexFileSize = _totalSize;
+    _indexFileTime = fileTime;
+    _indexFileHash = _fileHash;
+#if ESP_HOST_INDEX_SIDECAR
+    _indexDirty = false;
+    _indexLoad();
+#endif //ESP_HOST_INDEX_SIDECAR
+    return true;
+}
+
+//Remember position of start of line, if line is one of the indexed ones
+void GcodeHost::_indexLine(uint32_t line, uint32_t pos)
+{
+    if ((line == 0) || ((line % ESP_HOST_INDEX_STEP) != 0)) {
+        return;
+    }
+    if (!_indexSelect() || ((line % _indexStep) != 0)) {
+        return;
+    }
+    //already known (e.g. line read again after a resend)
+    if ((_indexCount > 0) && (line <= _indexLines[_indexCount - 1])) {
+        return;
+    }
+    if (_indexCount == ESP_HOST_INDEX_SIZE) {
+        //index is full: keep one entry out of two
+        _indexStep *= 2;
+        uint16_t n = 0;
+        for (uint16_t i = 0; i < _indexCount; i++) {
+            if ((_indexLines[i] % _indexStep) == 0) {
+                _indexLines[n] = _indexLines[i];
+                _indexOffsets[n] = _indexOffsets[i];
+                n++;
             }
         }
+        _indexCount = n;
+        if ((line % _indexStep) != 0) {
+            return;
+        }
+    }
+    _indexLines[_indexCount] = line;
+    _indexOffsets[_indexCount] = pos;
+    _indexCount++;
+#if ESP_HOST_INDEX_SIDECAR
+    _indexDirty = true;
+#endif //ESP_HOST_INDEX_SIDECAR
+}
+
+//Return closest indexed line before or equal to line and set its position
+//Line 1 at position 0 if none
+uint32_t GcodeHost::_indexFind(uint32_t line, uint32_t & pos)
+{
+    pos = 0;
+    if (!_indexSelect() || (_indexCount == 0) || (_indexLines[0] > line)) {
+        return 1;
+    }
+    uint16_t low = 0;
+    uint16_t high = _indexCount - 1;
+    while (low < high) {
+        uint16_t mid = (low + high + 1) / 2;
+        if (_indexLines[mid] <= line) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    pos = _indexOffsets[low];
+    return _indexLines[low];
+}
+
+#if ESP_HOST_INDEX_SIDECAR
+//Load index from <file>.idx if it matches the streamed file
+bool GcodeHost::_indexLoad()
+{
+    String name = _fileName + ESP_HOST_INDEX_EXTENSION;
+    esp_host_index_header_t header;
+    bool res = false;
+#if defined(FILESYSTEM_FEATURE)
+    if ((_fsType == TYPE_FS_STREAM) && ESP_FileSystem::exists(name.c_str())) {
+        ESP_File indexFile = ESP_FileSystem::open(name.c_str());
+        if (indexFile) {
+            res = readIndexFile(indexFile, header, _indexLines, _indexOffsets);
+            indexFile.close();
+        }
     }
 #endif //FILESYSTEM_FEATURE
-    
 #if defined(SD_DEVICE)
-    if (_fsType ==TYPE_SD_STREAM) {
-        _processedSize++;
-        _currentPosition++; 
-        char c = (char)SDfileHandle.read(); //does casting need to be explicit? probably for the best for now at least
+    if ((_fsType == TYPE_SD_STREAM) && ESP_SD::exists(name.c_str())) {
+        ESP_SDFile indexFile = ESP_SD::open(name.c_str());
+        if (indexFile) {
+            res = readIndexFile(indexFile, header, _indexLines, _indexOffsets);
+            indexFile.close();
+        }
+    }
+#endif //SD_DEVICE
+    if (!res || (header.fileSize != _indexFileSize) || (header.fileTime != (uint32_t)_indexFileTime) || (header.fileHash != _indexFileHash) || (header.step < ESP_HOST_INDEX_STEP)) {
+        _indexCount = 0;
+        return false;
+    }
+    _indexCount = header.count;
+    _indexStep = header.step;
+    log_esp3d("Line index loaded from %s, %d entries", name.c_str(), _indexCount);
+    return true;
+}
+
+//Save index to <file>.idx if it has new entries
+void GcodeHost::_indexSave()
+{
+    if (!_indexDirty || (_indexFsType != _fsType) || (_indexFileName != _fileName)) {
+        return;
+    }
+    String name = _fileName + ESP_HOST_INDEX_EXTENSION;
+    esp_host_index_header_t header;
+    header.magic = ESP_HOST_INDEX_MAGIC;
+    header.fileSize = _indexFileSize;
+    header.fileTime = (uint32_t)_indexFileTime;
+    header.fileHash = _indexFileHash;
+    header.step = _indexStep;
+    header.count = _indexCount;
+    bool res = false;
+#if defined(FILESYSTEM_FEATURE)
+    if (_fsType == TYPE_FS_STREAM) {
+        if (ESP_FileSystem::exists(name.c_str())) {
+            ESP_FileSystem::remove(name.c_str());
+        }
+        ESP_File indexFile = ESP_FileSystem::open(name.c_str(), ESP_FILE_WRITE);
+        if (indexFile) {
+            res = writeIndexFile(indexFile, header, _indexLines, _indexOffsets);
+            indexFile.close();
+        }
+    }
+#endif //FILESYSTEM_FEATURE
+#if defined(SD_DEVICE)
+    if (_fsType == TYPE_SD_STREAM) {
+        if (ESP_SD::exists(name.c_str())) {
+            ESP_SD::remove(name.c_str());
+        }
+        ESP_SDFile indexFile = ESP_SD::open(name.c_str(), ESP_FILE_WRITE);
+        if (indexFile) {
+            res = writeIndexFile(indexFile, header, _indexLines, _indexOffsets);
+            indexFile.close();
+        }
+    }
+#endif //SD_DEVICE
+    log_esp3d("Line index %s %s", name.c_str(), res?"saved":"not saved");
+    _indexDirty = !res;
+}
+#endif //ESP_HOST_INDEX_SIDECAR
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
+
+// Read the next line for processing from the script, FS file or SD file.
+//may be better to have seperate function for injection and check _injectionQueued in Handle
+void GcodeHost::_readNextCommand()
+{
+    if (_step == HOST_READ_LINE){
+        _step = HOST_PROCESS_LINE;
+    }
+
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+    if ((_fsType == TYPE_FS_STREAM) || (_fsType == TYPE_SD_STREAM)) {
+        //script lines are not numbered, so not indexed
+        if (_step != HOST_STREAMING_SCRIPT) {
+            _indexLine(_commandNumber, _currentPosition);
+        }
+        int c = _readFileChar();
         while (((c =='\n') || (c =='\r') || (c == ' '))){ //ignore any leading spaces and empty lines
-            _processedSize++;
-            _currentPosition++;
-            c = (char)SDfileHandle.read();
+            c = _readFileChar();
         }
         while (c == ';'){ // while its a full line comment, read on to the next line
-            _processedSize++;
-            _currentPosition++;
-            c = (char)SDfileHandle.read();
+            c = _readFileChar();
             while (!((c =='\n') || (c =='\r') || (c == 0) || (c == -1))){ //skim to end of line
-                _processedSize++;
-                _currentPosition++;
-                c = (char)SDfileHandle.read();
+                c = _readFileChar();
             }
             while (((c =='\n') || (c =='\r') || (c == ' '))){ //ignore any leading spaces and empty lines
-                _processedSize++;
-                _currentPosition++;
-                c = (char)SDfileHandle.read();
+                c = _readFileChar();
             }
         }
 
         while (!((c == '\n') || (c =='\r') || (c == 0) || (c == -1) || (_currentPosition > _totalSize))){ // while not end of line or end of file
             if (c == ';'){ //reached a comment, skip to next line
                 while (!((c =='\n') || (c =='\r') || (c == 0) || (c == -1))){ //skim to end of line
-                    _processedSize++;
-                    _currentPosition++;
-                    c = (char)SDfileHandle.read();
+                    c = _readFileChar();
                 }
             } else { //no comment yet, read into command
-                _currentCommand += c; // this results in a bad end char being added at the end
-                _processedSize++;
-                _currentPosition++;
-                c = (char)SDfileHandle.read();
+                _currentCommand += (char)c;
+                c = _readFileChar();
             }
         }
+#ifdef ESP_BENCHMARK_FEATURE
+        if (_currentCommand.length() > 0) {
+            _benchLines++;
+        }
+#endif //ESP_BENCHMARK_FEATURE
     }
-#endif //SD_DEVICE
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
 
     if (_currentCommand.length() == 0) {
         if (_step == HOST_PROCESS_LINE){
@@ -565,23 +939,22 @@ void GcodeHost::_processCommand()
             esp3d_commands.process((uint8_t *)_currentCommand.c_str(), _currentCommand.length(),&outputhost, _auth_type);
             log_esp3d("Command is ESP command: %s, client is %d", _currentCommand.c_str(), outputhost);
         } else {
-            _awaitAck();
             if(!_skipChecksum){ //For injected commands
                 _currentCommand = _CheckSumCommand(_currentCommand.c_str(), _commandNumber);
+#if ESP_HOST_WINDOW_SIZE > 1
+                //keep a copy for resend and do not wait for ack
+                _windowLines[_commandNumber % ESP_HOST_WINDOW_SIZE] = _currentCommand;
+                _windowNext = _commandNumber + 1;
+#else
+                _awaitAck();
+#endif //ESP_HOST_WINDOW_SIZE > 1
                 _commandNumber++;
+            } else {
+                _awaitAck();
             }
             _skipChecksum = false;
             _currentCommand = _currentCommand + "\n";
-
-#if COMMUNICATION_PROTOCOL == SOCKET_SERIAL
-            ESP3DOutput output(ESP_SOCKET_SERIAL_CLIENT);
-            esp3d_commands.process((uint8_t *)_currentCommand.c_str(), _currentCommand.length(),&_outputStream, _auth_type,&output,_outputStream.client()==ESP_ECHO_SERIAL_CLIENT?ESP_SOCKET_SERIAL_CLIENT:0 ) ;
-#endif //COMMUNICATION_PROTOCOL == SOCKET_SERIAL            
-#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
-            ESP3DOutput output(ESP_SERIAL_CLIENT);
-            esp3d_commands.process((uint8_t *)_currentCommand.c_str(), _currentCommand.length(),&outputhost, _auth_type,&output);
-#endif //COMMUNICATION_PROTOCOL == SERIAL           
-            _startTimeOut =millis();
+            _writeCommand(_currentCommand);
             log_esp3d("Command is GCODE command");
         
         }
@@ -592,8 +965,128 @@ void GcodeHost::_processCommand()
         _currentCommand = "";
 }
 
+//Send a line (with its \n) to the printer
+void GcodeHost::_writeCommand(String & command)
+{
+#if COMMUNICATION_PROTOCOL == SOCKET_SERIAL
+    ESP3DOutput output(ESP_SOCKET_SERIAL_CLIENT);
+    esp3d_commands.process((uint8_t *)command.c_str(), command.length(),&_outputStream, _auth_type,&output,_outputStream.client()==ESP_ECHO_SERIAL_CLIENT?ESP_SOCKET_SERIAL_CLIENT:0 ) ;
+#endif //COMMUNICATION_PROTOCOL == SOCKET_SERIAL            
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+    ESP3DOutput outputhost(ESP_STREAM_HOST_CLIENT);
+    ESP3DOutput output(ESP_SERIAL_CLIENT);
+    esp3d_commands.process((uint8_t *)command.c_str(), command.length(),&outputhost, _auth_type,&output);
+#endif //COMMUNICATION_PROTOCOL == SERIAL           
+    _startTimeOut =millis();
+}
+
+//Serial TX queue must take the whole line, otherwise wait next loop
+bool GcodeHost::_canSend()
+{
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+    return (size_t)serial_service.availableForWrite() >= (_currentCommand.length() + ESP_HOST_WINDOW_LINE_OVERHEAD);
+#else
+    return true;
+#endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+}
+
+#if ESP_HOST_WINDOW_SIZE > 1
+void GcodeHost::_resetWindow()
+{
+    for (uint8_t i = 0; i < ESP_HOST_WINDOW_SIZE; i++) {
+        _windowLines[i] = "";
+    }
+    _windowFirst = _commandNumber;
+    _windowNext = _commandNumber;
+    _windowLimit = ESP_HOST_WINDOW_SIZE;
+    _windowLastResend = 0;
+    _windowIgnoreResends = 0;
+    _windowIgnoreAcks = 0;
+}
+
+//Check if a line of len bytes can be sent without waiting for ack
+bool GcodeHost::_windowHasRoom(size_t len)
+{
+    if ((_windowNext - _windowFirst) >= _windowLimit) {
+        return false;
+    }
+    size_t inFlight = 0;
+    for (uint32_t n = _windowFirst; n != _windowNext; n++) {
+        inFlight += _windowLines[n % ESP_HOST_WINDOW_SIZE].length() + 1;
+    }
+    //an empty window always accept one line
+    return (inFlight == 0) || (inFlight + len <= ESP_HOST_WINDOW_RX_SIZE);
+}
+
+//Check if current command must wait, lines to resend are sent first
+bool GcodeHost::_windowBusy()
+{
+    if (_windowNext != _commandNumber) {
+        String line = _windowLines[_windowNext % ESP_HOST_WINDOW_SIZE];
+        if (_windowHasRoom(line.length() + 1)) {
+            log_esp3d("Resending line %d from window", _windowNext);
+            line += "\n";
+            _windowNext++;
+            _writeCommand(line);
+        }
+        return true;
+    }
+    //emergency commands do not wait
+    if ((_currentCommand.indexOf("M112") != -1) || (_currentCommand.indexOf("M108") != -1)) {
+        return false;
+    }
+    //injected commands have no number, so they need all acks to be received
+    if (_skipChecksum || _injectionNext) {
+        return (_windowFirst != _windowNext);
+    }
+    return !_windowHasRoom(_currentCommand.length() + ESP_HOST_WINDOW_LINE_OVERHEAD);
+}
+
+//Ack the oldest line of window, and use Marlin ADVANCED_OK "ok N.. P.. B.." to limit it
+bool GcodeHost::_ackWindow(String & line)
+{
+    if (_windowIgnoreAcks > 0) {
+        //ok following a rejected line
+        _windowIgnoreAcks--;
+        return true;
+    }
+    if (_windowFirst == _windowNext) {
+        return false;
+    }
+    _windowFirst++;
+    int pos = line.indexOf(" b");
+    if ((line.indexOf(" p") != -1) && (pos != -1) && isDigit(line[pos + 2])) {
+        long freeSlots = line.substring(pos + 2).toInt();
+        _windowLimit = constrain(freeSlots, 1, ESP_HOST_WINDOW_SIZE);
+    }
+    return true;
+}
+
+//Rewind window to resend line, return false if line is no more in window
+bool GcodeHost::_resendWindow(uint32_t line)
+{
+    if ((_windowIgnoreResends > 0) && (line == _windowLastResend)) {
+        //printer also rejects the lines sent after the wrong one
+        _windowIgnoreResends--;
+        return true;
+    }
+    if ((line < _windowFirst) || (line >= _windowNext)) {
+        log_esp3d("Line %d is not in window", line);
+        return false;
+    }
+    uint32_t rejected = _windowNext - line;
+    _windowFirst = line;
+    _windowNext = line;
+    _windowLastResend = line;
+    _windowIgnoreResends = rejected - 1;
+    _windowIgnoreAcks = rejected;
+    return true;
+}
+#endif //ESP_HOST_WINDOW_SIZE > 1
+
 void GcodeHost::handle()
 {
+    HOST_LOCK();
 
     switch(_step) {
 
@@ -609,6 +1102,19 @@ void GcodeHost::handle()
     break;
 
     case HOST_STOP_STREAM:
+#if ESP_HOST_WINDOW_SIZE > 1
+        //end of file but some lines are not yet acked
+        if ((_error == ERROR_NO_ERROR) && (_windowFirst != _commandNumber)) {
+            if (millis() - _startTimeOut > _timeoutInterval) {
+                log_esp3d("Timeout waiting for ack");
+                _error = ERROR_TIME_OUT;
+                _step = HOST_ERROR_STREAM;
+            } else {
+                _windowBusy();
+            }
+            break;
+        }
+#endif //ESP_HOST_WINDOW_SIZE > 1
         _endStream();
     break;
 
@@ -712,7 +1218,7 @@ void GcodeHost::handle()
                 _error = ERROR_TIME_OUT;
                 _step = HOST_ERROR_STREAM;
             }
-        } else {
+        } else if (_canSend()) {
             _skipChecksum = true;
             _processCommand();
         }
@@ -724,6 +1230,11 @@ void GcodeHost::handle()
             _gotoLine(_commandNumberToResend);
             _commandNumberToResend = 0;
             _readNextCommand();
+#if ESP_HOST_WINDOW_SIZE > 1
+        } else if ((_nextStep == HOST_PAUSE_STREAM) && (_windowFirst != _commandNumber)) {
+            //pause script must not get the acks of the lines in flight
+            _windowBusy();
+#endif //ESP_HOST_WINDOW_SIZE > 1
         } else if (_nextStep != HOST_READ_LINE){
             if (_nextStep == HOST_PAUSE_STREAM){
                 _step = HOST_PAUSE_STREAM;
@@ -759,7 +1270,15 @@ void GcodeHost::handle()
             _gotoLine(_commandNumberToResend);
             _commandNumberToResend = 0;
             _readNextCommand();
-        } else {
+#if ESP_HOST_WINDOW_SIZE > 1
+        } else if (_windowBusy()) {
+            if (millis() - _startTimeOut > _timeoutInterval) {
+                log_esp3d("Timeout waiting for ack");
+                _error = ERROR_TIME_OUT;
+                _step = HOST_ERROR_STREAM;
+            }
+#endif //ESP_HOST_WINDOW_SIZE > 1
+        } else if (_canSend()) {
             _processCommand();
             if (_saveCommand != ""){
                 _currentCommand = _saveCommand;
@@ -798,6 +1317,7 @@ void GcodeHost::handle()
 
 bool  GcodeHost::abort(level_authenticate_type auth_type)
 {
+    HOST_LOCK(false);
 #ifdef AUTHENTICATION_FEATURE
     if (auth_type < LEVEL_USER){
         log_esp3d("Stream actions require user level authorization or greater");
@@ -815,6 +1335,7 @@ bool  GcodeHost::abort(level_authenticate_type auth_type)
 
 bool GcodeHost::pause(level_authenticate_type auth_type)
 {
+    HOST_LOCK(false);
 #ifdef AUTHENTICATION_FEATURE
     if (auth_type < LEVEL_USER){
         log_esp3d("Stream actions require user level authorization or greater");
@@ -830,6 +1351,7 @@ bool GcodeHost::pause(level_authenticate_type auth_type)
 
 bool GcodeHost::resume(level_authenticate_type auth_type)
 {
+    HOST_LOCK(false);
 #ifdef AUTHENTICATION_FEATURE
     if (auth_type < LEVEL_USER){
         log_esp3d("Stream actions require user level authorization or greater");
@@ -865,18 +1387,23 @@ String GcodeHost::_CheckSumCommand(const char* command, uint32_t commandnb)
 
 void GcodeHost::resetCommandNumber()
 {
+    HOST_LOCK();
     String resetcmd = "M110 N0";
     if (Settings_ESP3D::GetFirmwareTarget() == SMOOTHIEWARE) {
         resetcmd = "N0 M110";
     }
 
     _commandNumber = 1;
+#if ESP_HOST_WINDOW_SIZE > 1
+    _resetWindow();
+#endif //ESP_HOST_WINDOW_SIZE > 1
     sendCommand((const uint8_t *)resetcmd.c_str(), resetcmd.length(), _auth_type);
 
 }
 
 bool GcodeHost::processFile(const char * filename, level_authenticate_type auth_type, ESP3DOutput * output)
 {
+    HOST_LOCK(false);
 #ifdef AUTHENTICATION_FEATURE
     if (auth_type < LEVEL_USER) {
         log_esp3d("File streaming requires user level authorization or greater");
@@ -944,22 +1471,22 @@ bool GcodeHost::processFile(const char * filename, level_authenticate_type auth_
 bool GcodeHost::_gotoLine(uint32_t line)
 {
     //add checks for current state and step. should be called from Handle()
+#ifdef ESP_BENCHMARK_FEATURE
+    uint64_t bench_start = millis();
+#endif //ESP_BENCHMARK_FEATURE
     _commandNumber = 1;
     _currentPosition = 0;
 
-#if defined(FILESYSTEM_FEATURE)
-    if (_fsType ==TYPE_FS_STREAM) {
-        fileHandle.seek(_currentPosition);
-    }
-#endif //FILESYSTEM_FEATURE
-#if defined(SD_DEVICE)
-    if (_fsType ==TYPE_SD_STREAM) {
-        SDfileHandle.seek(_currentPosition);
-    }
-#endif //SD_DEVICE
-
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+    //start from closest indexed line instead of beginning of file
+    _commandNumber = _indexFind(line, _currentPosition);
+    _seekFile(_currentPosition);
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
+#ifdef ESP_BENCHMARK_FEATURE
+    uint32_t bench_from = _commandNumber;
+#endif //ESP_BENCHMARK_FEATURE
 
-    for ( _commandNumber = 1; _commandNumber < line; _commandNumber++){
+    for ( ; _commandNumber < line; _commandNumber++){
         _currentCommand = "";
         _readNextCommand();
         if (esp3d_commands.is_esp_command((uint8_t *)_currentCommand.c_str(), _currentCommand.length())) {
@@ -968,48 +1495,17 @@ bool GcodeHost::_gotoLine(uint32_t line)
     }
 
     _currentCommand = "";
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+    //skipped lines are not processed ones
+    _processedSize = _currentPosition;
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
+#if ESP_HOST_WINDOW_SIZE > 1
+    _resetWindow();
+#endif //ESP_HOST_WINDOW_SIZE > 1
+#ifdef ESP_BENCHMARK_FEATURE
+    report_esp3d("REPORT: Host goto line %u from line %u in %u ms", line, bench_from, (uint32_t)(millis() - bench_start));
+#endif //ESP_BENCHMARK_FEATURE
     return true;
-
-
-    /* following method should be faster on long files but doesn't work yet
-    char c;
-    bool notEmpty = false;
-    String check = "";
-
-    if (line < _commandNumber) { //if we're going backwards (which should be the only use case really)
-        while (_commandNumber > line){
-            _currentPosition -= 1;
-            fileHandle.seek((_currentPosition-1));
-            c = (char)fileHandle.read();
-            if (c == '\n'){ // if we reach an end line, we're at the end of a previous line - make sure it's not a comment or ESP command.
-                if (notEmpty == true){ //line isn't empty
-                    while ((c == ' ') || (c == '\n') || (c == '\r')){
-                        c = (char)fileHandle.read();
-                    }
-                    if ((c != ';') && (c != '[')) { //not a comment or ESP command, or an empty line, must be a command - count it
-                        _commandNumber -= 1;
-                    }
-                }
-                
-            } else if (c != ' ') {
-                notEmpty = true;
-            }
-        }
-        fileHandle.seek((_currentPosition));
-    } else if (line > _commandNumber){
-        while (_commandNumber < line){
-            _readNextCommand();
-            _commandNumber++;
-        } 
-    } else {
-        //TODO error message for current line requested
-        return false;
-    }
-
-    return true;
-
-*/
-
 }
 
 
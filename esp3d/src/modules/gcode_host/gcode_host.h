@@ -73,8 +73,48 @@ class ESP3DOutput;
 
 #define  ESP_HOST_BUFFER_SIZE 255
 
+//Size of the block read from FS/SD when streaming a file, keep it a multiple of the 512 bytes sector
+#ifndef ESP_HOST_FILE_BUFFER_SIZE
+#define ESP_HOST_FILE_BUFFER_SIZE 1024
+#endif //ESP_HOST_FILE_BUFFER_SIZE
+
+//Sparse line index: file position of every Nth numbered line, used to go back to a line
+//Max number of entries, when full every other entry is dropped and N is doubled
+#ifndef ESP_HOST_INDEX_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define ESP_HOST_INDEX_SIZE 256
+#else
+#define ESP_HOST_INDEX_SIZE 128
+#endif //ARDUINO_ARCH_ESP32
+#endif //ESP_HOST_INDEX_SIZE
+//Initial N
+#ifndef ESP_HOST_INDEX_STEP
+#define ESP_HOST_INDEX_STEP 32
+#endif //ESP_HOST_INDEX_STEP
+//Save index next to the streamed file as <file>.idx to reuse it later, 0 = disabled
+#ifndef ESP_HOST_INDEX_SIDECAR
+#define ESP_HOST_INDEX_SIDECAR 0
+#endif //ESP_HOST_INDEX_SIDECAR
+#define ESP_HOST_INDEX_EXTENSION ".idx"
+
+//Sliding window: number of numbered lines sent without waiting for their ack, 1 = disabled
+#ifndef ESP_HOST_WINDOW_SIZE
+#define ESP_HOST_WINDOW_SIZE 1
+#endif //ESP_HOST_WINDOW_SIZE
+//Max bytes in flight, should not exceed printer serial RX buffer
+#ifndef ESP_HOST_WINDOW_RX_SIZE
+#define ESP_HOST_WINDOW_RX_SIZE 127
+#endif //ESP_HOST_WINDOW_RX_SIZE
+//Room for "N<number> " and "*<checksum>\n" added to each line
+#define ESP_HOST_WINDOW_LINE_OVERHEAD 16
+
 #define MUTEX_TIMEOUT 10000 //portMAX_DELAY
 
+//Host is handled by serial task instead of main loop
+#if defined(ARDUINO_ARCH_ESP32) && defined(SERIAL_INDEPENDANT_TASK) && defined(GCODE_HOST_INDEPENDANT_TASK) && (COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL)
+#define ESP_HOST_TASK
+#endif //ARDUINO_ARCH_ESP32 && SERIAL_INDEPENDANT_TASK && GCODE_HOST_INDEPENDANT_TASK
+
 class GcodeHost
 {
 public:
@@ -119,18 +159,40 @@ private:
     void _flush();
     bool _isAck(String & line);
     bool _isBusy(String & line);
+    bool _isResendError(String & line);
     uint32_t _resendCommandNumber(String & line);
 
     bool _startStream();
     void _endStream();
 
     void _readNextCommand();
+    int _readFileChar();
+    void _seekFile(uint32_t pos);
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+    uint32_t _hashFile();
+    bool _indexSelect();
+    void _indexLine(uint32_t line, uint32_t pos);
+    uint32_t _indexFind(uint32_t line, uint32_t & pos);
+#if ESP_HOST_INDEX_SIDECAR
+    bool _indexLoad();
+    void _indexSave();
+#endif //ESP_HOST_INDEX_SIDECAR
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
     void _readInjectedCommand();
 
     uint8_t _Checksum(const char * command, uint32_t commandSize);
     String _CheckSumCommand(const char* command, uint32_t commandnb);
     void _processCommand();
+    void _writeCommand(String & command);
+    bool _canSend();
     void _awaitAck();
+#if ESP_HOST_WINDOW_SIZE > 1
+    void _resetWindow();
+    bool _windowHasRoom(size_t len);
+    bool _windowBusy();
+    bool _ackWindow(String & line);
+    bool _resendWindow(uint32_t line);
+#endif //ESP_HOST_WINDOW_SIZE > 1
 
     bool _gotoLine(uint32_t line);
 
@@ -138,6 +200,33 @@ private:
     uint8_t _buffer [ESP_HOST_BUFFER_SIZE+1];
     size_t _bufferSize;
 
+#if defined(FILESYSTEM_FEATURE) || defined(SD_DEVICE)
+    //block cache of the streamed file, shared by FS and SD
+    uint8_t _fileBuffer[ESP_HOST_FILE_BUFFER_SIZE];
+    size_t _fileBufferSize;
+    size_t _fileBufferPos;
+    uint32_t _fileBufferOffset;
+    //line index of the streamed file, sorted by line number
+    uint32_t _indexLines[ESP_HOST_INDEX_SIZE];
+    uint32_t _indexOffsets[ESP_HOST_INDEX_SIZE];
+    uint16_t _indexCount;
+    uint32_t _indexStep;
+    String _indexFileName;
+    uint8_t _indexFsType;
+    size_t _indexFileSize;
+    time_t _indexFileTime;
+    uint32_t _indexFileHash;
+    //hash of first and last blocks of the streamed file, taken when opened
+    uint32_t _fileHash;
+#if ESP_HOST_INDEX_SIDECAR
+    bool _indexDirty;
+#endif //ESP_HOST_INDEX_SIDECAR
+#endif //FILESYSTEM_FEATURE || SD_DEVICE
+
+#ifdef ESP_BENCHMARK_FEATURE
+    uint64_t _benchStart;
+    uint32_t _benchLines;
+#endif //ESP_BENCHMARK_FEATURE
     
 #if defined(FILESYSTEM_FEATURE)
     ESP_File fileHandle;
@@ -163,6 +252,19 @@ private:
     uint32_t _commandNumberToResend;
     uint32_t _saveCommandNumber;
 
+#if ESP_HOST_WINDOW_SIZE > 1
+    //sent lines kept for resend, slot is command number % ESP_HOST_WINDOW_SIZE
+    //lines from _windowFirst to _windowNext are waiting for ack
+    //lines from _windowNext to _commandNumber are waiting to be sent again
+    String _windowLines[ESP_HOST_WINDOW_SIZE];
+    uint32_t _windowFirst;
+    uint32_t _windowNext;
+    uint8_t _windowLimit;
+    uint32_t _windowLastResend;
+    uint32_t _windowIgnoreResends;
+    uint32_t _windowIgnoreAcks;
+#endif //ESP_HOST_WINDOW_SIZE > 1
+
     String _fileName;
     String _saveFileName;
 
@@ -185,6 +287,10 @@ private:
 
     ESP3DOutput _outputStream;
     level_authenticate_type _auth_type;
+#if defined(ESP_HOST_TASK)
+    //serial task and main loop both use the host
+    SemaphoreHandle_t _mutex;
+#endif //ESP_HOST_TASK
     
     
 };
@@ -49,16 +49,7 @@ void HTTP_Server:: handle_not_found()
     String pathWithGz = path + ".gz";
     log_esp3d("URI: %s", path.c_str());
 #if defined (FILESYSTEM_FEATURE)
-    if(ESP_FileSystem::exists(pathWithGz.c_str()) || ESP_FileSystem::exists(path.c_str())) {
-        log_esp3d("Path found `%s`", path.c_str());
-        if(ESP_FileSystem::exists(pathWithGz.c_str())) {
-            _webserver->sendHeader("Content-Encoding", "gzip");
-            path = pathWithGz;
-            log_esp3d("Path is gz `%s`", path.c_str());
-        }
-        if(!StreamFSFile(path.c_str(),contentType.c_str())) {
-            log_esp3d("Stream `%s` failed", path.c_str());
-        }
+    if (StreamFSStaticFile(path.c_str())) {
         return;
     }
     if (path=="favicon.ico" || path=="/favicon.ico") {
@@ -100,17 +91,7 @@ void HTTP_Server:: handle_not_found()
 
 #ifdef FILESYSTEM_FEATURE
     //check local page
-    path = "/404.htm";
-    contentType =  getContentType(path.c_str());
-    pathWithGz =  path + ".gz";
-    if(ESP_FileSystem::exists(pathWithGz.c_str()) || ESP_FileSystem::exists(path.c_str())) {
-        if(ESP_FileSystem::exists(pathWithGz.c_str())) {
-            _webserver->sendHeader("Content-Encoding", "gzip");
-            path = pathWithGz;
-        }
-        if(!StreamFSFile(path.c_str(),contentType.c_str())) {
-            log_esp3d("Stream `%s` failed", path.c_str());
-        }
+    if (StreamFSStaticFile("/404.htm")) {
         return;
     }
 #endif //FILESYSTEM_FEATURE
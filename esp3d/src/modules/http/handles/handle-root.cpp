@@ -41,20 +41,11 @@ void HTTP_Server::handle_root()
         path = path + "/";
     }
     path += "index.html";
-    String contentType =  getContentType(path.c_str());
-    String pathWithGz = path + ".gz";
     //if have a index.html or gzip version this is default root page
-    if((ESP_FileSystem::exists(pathWithGz.c_str()) || ESP_FileSystem::exists(path.c_str())) && !_webserver->hasArg("forcefallback") && _webserver->arg("forcefallback")!="yes") {
-        log_esp3d("Path found `%s`", path.c_str());
-        if(ESP_FileSystem::exists(pathWithGz.c_str())) {
-            _webserver->sendHeader("Content-Encoding", "gzip");
-            path = pathWithGz;
-            log_esp3d("Path is gz `%s`", path.c_str());
+    if(!_webserver->hasArg("forcefallback") && _webserver->arg("forcefallback")!="yes") {
+        if (StreamFSStaticFile(path.c_str())) {
+            return;
         }
-        if(!StreamFSFile(path.c_str(),contentType.c_str())) {
-            log_esp3d("Stream `%s` failed", path.c_str());
-        }
-        return;
     }
     //if no lets launch the default content
     _webserver->sendHeader("Content-Encoding", "gzip");
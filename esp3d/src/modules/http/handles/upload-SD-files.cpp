@@ -28,6 +28,7 @@
 #include <ESP8266WebServer.h>
 #endif //ARDUINO_ARCH_ESP8266
 #include "../../filesystem/esp_sd.h"
+#include "../../filesystem/esp_write_combiner.h"
 #include "../../authentication/authentication_service.h"
 #ifdef ESP_BENCHMARK_FEATURE
 #include "../../../core/benchmark.h"
@@ -49,6 +50,8 @@ void HTTP_Server::SDFileupload ()
     level_authenticate_type auth_level= AuthenticationService::authenticated_level();
     static String filename;
     static ESP_SDFile fsUploadFile;
+    static ESP_WriteCombiner uploadWriter;
+    static bool preallocated;
     //Guest cannot upload - only admin
     if (auth_level == LEVEL_GUEST) {
         pushError(ESP_ERROR_AUTHENTICATION, "Upload rejected", 401);
@@ -132,6 +135,7 @@ void HTTP_Server::SDFileupload ()
                     }
                 }
                 if (fsUploadFile.isOpen() ) {
+                    uploadWriter.end();
                     fsUploadFile.close();
                 }
                 String  sizeargname  = upload.filename + "S";
@@ -155,6 +159,15 @@ void HTTP_Server::SDFileupload ()
                         //if yes upload is started
                         _upload_status= UPLOAD_STATUS_ONGOING;
                         log_esp3d("Try file creation");
+                        //reserve contiguous clusters when size is known
+                        preallocated = false;
+                        if (_webserver->hasArg (sizeargname.c_str()) ) {
+                            preallocated = fsUploadFile.preAllocate(_webserver->arg (sizeargname.c_str()).toInt());
+                        }
+                        //write by SD aligned blocks instead of upload packets
+                        uploadWriter.begin([](const uint8_t * buf, size_t size) {
+                            return fsUploadFile.write(buf, size);
+                        });
                     } else {
                         //if no set cancel flag
                         _upload_status=UPLOAD_STATUS_FAILED;
@@ -176,7 +189,7 @@ void HTTP_Server::SDFileupload ()
                         last_WS_update = millis();
                     }
                     //no error so write post date
-                    int writeddatanb=fsUploadFile.write(upload.buf, upload.currentSize);
+                    int writeddatanb=uploadWriter.write(upload.buf, upload.currentSize);
                     if(upload.currentSize != (size_t)writeddatanb) {
                         //we have a problem set flag UPLOAD_STATUS_FAILED
                         log_esp3d("File write failed du to mismatch size %d vs %d", writeddatanb, upload.currentSize);
@@ -194,7 +207,10 @@ void HTTP_Server::SDFileupload ()
                 uint32_t filesize = 0;
                 //check if file is still open
                 if(fsUploadFile) {
-                    //close it
+                    //write pending data and close it
+                    bool flushed = uploadWriter.flush();
+                    size_t written = uploadWriter.total();
+                    uploadWriter.end();
                     fsUploadFile.close();
 #ifdef ESP_BENCHMARK_FEATURE
                     benchMark("SD upload", bench_start, millis(), bench_transfered);
@@ -202,9 +218,13 @@ void HTTP_Server::SDFileupload ()
                     //check size
                     String  sizeargname  = upload.filename + "S";
                     //fsUploadFile = ESP_SD::open (filename, ESP_FILE_READ);
-                    filesize = fsUploadFile.size();
+                    //preallocated file has the announced size, so use what was written
+                    filesize = preallocated?written:fsUploadFile.size();
                     _upload_status = UPLOAD_STATUS_SUCCESSFUL;
-                    if (_webserver->hasArg (sizeargname.c_str()) ) {
+                    if (!flushed) {
+                        _upload_status = UPLOAD_STATUS_FAILED;
+                        pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                    } else if (_webserver->hasArg (sizeargname.c_str()) ) {
                         if (_webserver->arg (sizeargname.c_str()) != String(filesize)) {
                             _upload_status = UPLOAD_STATUS_FAILED;
                             pushError(ESP_ERROR_SIZE, "File upload failed");
@@ -239,6 +259,7 @@ void HTTP_Server::SDFileupload ()
 
     if(_upload_status == UPLOAD_STATUS_FAILED) {
         cancelUpload();
+        uploadWriter.end();
         if(fsUploadFile) {
             fsUploadFile.close();
         }
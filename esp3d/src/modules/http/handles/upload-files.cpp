@@ -28,6 +28,7 @@
 #include <ESP8266WebServer.h>
 #endif //ARDUINO_ARCH_ESP8266
 #include "../../filesystem/esp_filesystem.h"
+#include "../../filesystem/esp_write_combiner.h"
 #include "../../authentication/authentication_service.h"
 #if defined(ESP3DLIB_ENV) && COMMUNICATION_PROTOCOL == SOCKET_SERIAL
 #include "../../serial2socket/serial2socket.h"
@@ -50,6 +51,7 @@ void HTTP_Server::FSFileupload ()
     level_authenticate_type auth_level= AuthenticationService::authenticated_level();
     static String filename;
     static ESP_File fsUploadFile;
+    static ESP_WriteCombiner uploadWriter;
     //Guest cannot upload - only admin
     if (auth_level == LEVEL_GUEST) {
         pushError(ESP_ERROR_AUTHENTICATION, "Upload rejected", 401);
@@ -115,6 +117,7 @@ void HTTP_Server::FSFileupload ()
                     }
                 }
                 if (fsUploadFile.isOpen() ) {
+                    uploadWriter.end();
                     fsUploadFile.close();
                 }
                 String  sizeargname  = upload.filename + "S";
@@ -133,6 +136,10 @@ void HTTP_Server::FSFileupload ()
                     if (fsUploadFile) {
                         //if yes upload is started
                         _upload_status= UPLOAD_STATUS_ONGOING;
+                        //write by large blocks instead of upload packets
+                        uploadWriter.begin([](const uint8_t * buf, size_t size) {
+                            return fsUploadFile.write(buf, size);
+                        });
                     } else {
                         //if no set cancel flag
                         _upload_status=UPLOAD_STATUS_FAILED;
@@ -148,7 +155,7 @@ void HTTP_Server::FSFileupload ()
 #ifdef ESP_BENCHMARK_FEATURE
                     bench_transfered += upload.currentSize;
 #endif//ESP_BENCHMARK_FEATURE
-                    if(upload.currentSize != fsUploadFile.write(upload.buf, upload.currentSize)) {
+                    if(upload.currentSize != uploadWriter.write(upload.buf, upload.currentSize)) {
                         //we have a problem set flag UPLOAD_STATUS_FAILED
                         _upload_status=UPLOAD_STATUS_FAILED;
                         pushError(ESP_ERROR_FILE_WRITE, "File write failed");
@@ -163,7 +170,9 @@ void HTTP_Server::FSFileupload ()
                 log_esp3d("upload end");
                 //check if file is still open
                 if(fsUploadFile) {
-                    //close it
+                    //write pending data and close it
+                    bool flushed = uploadWriter.flush();
+                    uploadWriter.end();
                     fsUploadFile.close();
 #ifdef ESP_BENCHMARK_FEATURE
                     benchMark("FS upload", bench_start, millis(), bench_transfered);
@@ -173,7 +182,11 @@ void HTTP_Server::FSFileupload ()
                     //fsUploadFile = ESP_FileSystem::open (filename, ESP_FILE_READ);
                     uint32_t filesize = fsUploadFile.size();
                     _upload_status = UPLOAD_STATUS_SUCCESSFUL;
-                    if (_webserver->hasArg (sizeargname.c_str()) ) {
+                    if (!flushed) {
+                        log_esp3d("Write Error");
+                        _upload_status = UPLOAD_STATUS_FAILED;
+                        pushError(ESP_ERROR_FILE_WRITE, "File write failed");
+                    } else if (_webserver->hasArg (sizeargname.c_str()) ) {
                         log_esp3d("Size check: %s vs %s", _webserver->arg (sizeargname.c_str()).c_str(), String(filesize).c_str());
                         if (_webserver->arg (sizeargname.c_str()) != String(filesize)) {
                             log_esp3d("Size Error");
@@ -205,6 +218,7 @@ void HTTP_Server::FSFileupload ()
 
     if(_upload_status == UPLOAD_STATUS_FAILED) {
         cancelUpload();
+        uploadWriter.end();
         if(fsUploadFile) {
             fsUploadFile.close();
         }
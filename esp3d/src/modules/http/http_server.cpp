@@ -38,6 +38,7 @@
 #include "../websocket/websocket_server.h"
 #if defined(SD_DEVICE)
 #include "../filesystem/esp_sd.h"
+#include "../filesystem/esp_read_pipeline.h"
 
 #endif //SD_DEVICE
 #ifdef ESP_BENCHMARK_FEATURE
@@ -59,6 +60,10 @@ void HTTP_Server::init_handlers()
     _webserver->on ("/command", HTTP_ANY, handle_web_command);
     //config
     _webserver->on ("/config", HTTP_ANY, handle_config);
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    //last printer state
+    _webserver->on ("/printerstate", HTTP_GET, handle_printer_state);
+#endif //ESP_STATUS_CHANNEL_FEATURE
     //need to be there even no authentication to say to UI no authentication
     _webserver->on("/login", HTTP_ANY, handle_login);
 #ifdef FILESYSTEM_FEATURE
@@ -94,29 +99,133 @@ void HTTP_Server::init_handlers()
 #endif //CAPTIVE_PORTAL_FEATURE
 }
 
+//range bound must be digits only, toInt() would take junk as 0
+static bool getRangeValue(const String & s, size_t & value)
+{
+    if (s.length() == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < s.length(); i++) {
+        if (!isDigit(s[i])) {
+            return false;
+        }
+    }
+    value = strtoul(s.c_str(), nullptr, 10);
+    return true;
+}
+
+//check if request has a valid single byte range
+//return 0 if whole file must be sent, 1 if range is valid, -1 if range cannot be satisfied
+int8_t HTTP_Server::getRange(size_t fileSize, size_t & start, size_t & end)
+{
+    start = 0;
+    end = (fileSize > 0)?fileSize - 1:0;
+    String range = _webserver->header("Range");
+    if (!range.startsWith("bytes=") || (range.indexOf(',') != -1)) {
+        //no range or multiple ranges: send everything
+        return 0;
+    }
+    int sep = range.indexOf('-');
+    if (sep == -1) {
+        return 0;
+    }
+    String first = range.substring(6, sep);
+    String last = range.substring(sep + 1);
+    first.trim();
+    last.trim();
+    if (first.length() == 0) {
+        //suffix range: last N bytes
+        size_t suffix = 0;
+        if (!getRangeValue(last, suffix) || (suffix == 0) || (fileSize == 0)) {
+            return -1;
+        }
+        start = (suffix >= fileSize)?0:fileSize - suffix;
+    } else {
+        if (!getRangeValue(first, start)) {
+            return -1;
+        }
+        if (last.length() > 0) {
+            size_t e = 0;
+            if (!getRangeValue(last, e)) {
+                return -1;
+            }
+            if (e < end) {
+                end = e;
+            }
+        }
+    }
+    if ((start >= fileSize) || (start > end)) {
+        return -1;
+    }
+    log_esp3d("Range: %d -> %d / %d", start, end, fileSize);
+    return 1;
+}
+
+//seek file to range start then send headers for whole file or range
+//return false if range cannot be served, error is already answered then
+bool HTTP_Server::sendRangeHeaders(size_t fileSize, const char * contentType, seeker_t seek, size_t & start, size_t & len)
+{
+    size_t end;
+    int8_t range = getRange(fileSize, start, end);
+    _webserver->sendHeader("Accept-Ranges", "bytes");
+    if (range == -1) {
+        _webserver->sendHeader("Content-Range", "bytes */" + String(fileSize));
+        _webserver->send(416);
+        return false;
+    }
+    //no status is sent before seek, so a failure can still be answered
+    if ((start > 0) && !seek(start)) {
+        log_esp3d("Seek to %d failed", start);
+        _webserver->send(500);
+        return false;
+    }
+    if (range == 1) {
+        len = end - start + 1;
+        _webserver->sendHeader("Content-Range", "bytes " + String(start) + "-" + String(end) + "/" + String(fileSize));
+        _webserver->setContentLength(len);
+        _webserver->send(206, contentType, "");
+    } else {
+        len = fileSize;
+        _webserver->setContentLength(len);
+        _webserver->send(200, contentType, "");
+    }
+    return true;
+}
+
 bool HTTP_Server::StreamFSFile(const char* filename, const char * contentType)
 {
     ESP_File datafile = ESP_FileSystem::open(filename);
     uint64_t last_WS_update = millis();
+#ifdef ESP_BENCHMARK_FEATURE
+    uint64_t bench_start = millis();
+#endif//ESP_BENCHMARK_FEATURE
     if (!datafile) {
         return false;
     }
-    size_t totalFileSize = datafile.size();
+    size_t fileSize = datafile.size();
+    size_t start = 0;
+    size_t totalSize = 0;
+    seeker_t seek = [&datafile](size_t pos) {
+        return (bool)datafile.seek(pos);
+    };
+    if (!sendRangeHeaders(fileSize, contentType, seek, start, totalSize)) {
+        datafile.close();
+        return false;
+    }
     size_t i = 0;
-    bool done = false;
-    _webserver->setContentLength(totalFileSize);
-    _webserver->send(200, contentType, "");
+    bool done = (totalSize == 0);
     uint8_t buf[DOWNLOAD_PACKET_SIZE];
     while (!done && _webserver->client().connected()) {
         Hal::wait(0);
-        int v = datafile.read(buf,DOWNLOAD_PACKET_SIZE);
+        size_t toRead = ((totalSize - i) < DOWNLOAD_PACKET_SIZE)?(totalSize - i):DOWNLOAD_PACKET_SIZE;
+        int v = datafile.read(buf,toRead);
         if ((v == -1) ||  (v == 0)) {
             done = true;
         } else {
             _webserver->client().write(buf,v);
             i+=v;
         }
-        if (i >= totalFileSize) {
+        if (i >= totalSize) {
             done = true;
         }
         //update websocket every 2000 ms
@@ -126,9 +235,138 @@ bool HTTP_Server::StreamFSFile(const char* filename, const char * contentType)
         }
     }
     datafile.close();
-    if ( i != totalFileSize) {
+    if ( i != totalSize) {
         return false;
     }
+#ifdef ESP_BENCHMARK_FEATURE
+    if (totalSize != fileSize) {
+        benchMark("FS ranged download", bench_start, millis(), i);
+    }
+#endif//ESP_BENCHMARK_FEATURE
+    return true;
+}
+
+//metadata of static files served from flash filesystem
+typedef struct {
+    String path;
+    bool exists;
+    bool gz;
+    size_t size;
+    time_t lastWrite;
+    char etag[32];
+    uint32_t lastUse;
+} static_file_info_t;
+
+static static_file_info_t staticFiles[HTTP_STATIC_CACHE_SIZE];
+static uint32_t staticFilesRevision = 0;
+
+//without modification time, same size is not enough to identify a version:
+//whole content is hashed, only once as result is kept until filesystem changes
+#define STATIC_FILE_HASH_BLOCK 512
+static uint32_t staticFileHash(ESP_File & f, size_t size)
+{
+    uint8_t buf[STATIC_FILE_HASH_BLOCK];
+    uint32_t hash = 2166136261UL;
+    if (!f.seek(0)) {
+        return 0;
+    }
+    size_t done = 0;
+    while (done < size) {
+        size_t len = f.read(buf, STATIC_FILE_HASH_BLOCK);
+        if ((len == 0) || (len > STATIC_FILE_HASH_BLOCK)) {
+            break;
+        }
+        //FNV-1a
+        for (size_t i = 0; i < len; i++) {
+            hash = (hash ^ buf[i]) * 16777619UL;
+        }
+        done += len;
+    }
+    return hash;
+}
+
+//get file metadata from cache, filesystem is only accessed if not yet known
+//cache is cleared as soon as flash filesystem content may have changed
+static static_file_info_t * getStaticFileInfo(const char * path)
+{
+    if (staticFilesRevision != ESP_FileSystem::revision()) {
+        log_esp3d("Static files cache cleared");
+        for (uint8_t i = 0; i < HTTP_STATIC_CACHE_SIZE; i++) {
+            staticFiles[i].path = "";
+            staticFiles[i].lastUse = 0;
+        }
+        staticFilesRevision = ESP_FileSystem::revision();
+    }
+    uint8_t slot = 0;
+    for (uint8_t i = 0; i < HTTP_STATIC_CACHE_SIZE; i++) {
+        if ((staticFiles[i].lastUse != 0) && (staticFiles[i].path == path)) {
+            staticFiles[i].lastUse = millis() | 1;
+            return &staticFiles[i];
+        }
+        //oldest or free slot will be reused
+        if (staticFiles[i].lastUse < staticFiles[slot].lastUse) {
+            slot = i;
+        }
+    }
+    static_file_info_t * info = &staticFiles[slot];
+    info->path = path;
+    info->exists = false;
+    info->gz = false;
+    info->size = 0;
+    info->lastWrite = 0;
+    info->etag[0] = 0;
+    info->lastUse = millis() | 1;
+    String pathWithGz = info->path + ".gz";
+    ESP_File f;
+    if (ESP_FileSystem::exists(pathWithGz.c_str())) {
+        f = ESP_FileSystem::open(pathWithGz.c_str(), ESP_FILE_READ);
+        info->gz = true;
+    } else if (ESP_FileSystem::exists(path)) {
+        f = ESP_FileSystem::open(path, ESP_FILE_READ);
+    }
+    if (f) {
+        if (!f.isDirectory()) {
+            info->exists = true;
+            info->size = f.size();
+            info->lastWrite = f.getLastWrite();
+            uint32_t version = (info->lastWrite > 0)?(uint32_t)info->lastWrite:staticFileHash(f, info->size);
+            snprintf(info->etag, sizeof(info->etag), "\"%x-%x%s\"", (unsigned int)info->size, (unsigned int)version, info->gz?"-gz":"");
+        }
+        f.close();
+    }
+    log_esp3d("Static file %s: %s %s", path, info->exists?"found":"not found", info->etag);
+    return info;
+}
+
+//stream static file (or its gz version) from flash filesystem
+//answer 304 without reading file if browser already has same version
+bool HTTP_Server::StreamFSStaticFile(const char* path)
+{
+    static_file_info_t * info = getStaticFileInfo(path);
+    if (!info->exists) {
+        return false;
+    }
+    _webserver->sendHeader("ETag", info->etag);
+    _webserver->sendHeader("Cache-Control", "no-cache");
+    if (info->lastWrite > 0) {
+        char lastModified[32];
+        struct tm * tmstruct = gmtime(&info->lastWrite);
+        strftime(lastModified, sizeof(lastModified), "%a, %d %b %Y %H:%M:%S GMT", tmstruct);
+        _webserver->sendHeader("Last-Modified", lastModified);
+    }
+    if (_webserver->header("If-None-Match") == info->etag) {
+        log_esp3d("%s not modified", path);
+        _webserver->send(304);
+        return true;
+    }
+    String filename = path;
+    if (info->gz) {
+        _webserver->sendHeader("Content-Encoding", "gzip");
+        filename += ".gz";
+    }
+    if(!StreamFSFile(filename.c_str(), getContentType(path))) {
+        log_esp3d("Stream `%s` failed", filename.c_str());
+    }
     return true;
 }
 
@@ -144,16 +382,35 @@ bool HTTP_Server::StreamSDFile(const char* filename, const char * contentType)
     if (!datafile) {
         return false;
     }
-    size_t totalFileSize = datafile.size();
+    size_t fileSize = datafile.size();
+    size_t start = 0;
+    size_t totalSize = 0;
+    seeker_t seek = [&datafile](size_t pos) {
+        return (bool)datafile.seek(pos);
+    };
+    if (!sendRangeHeaders(fileSize, contentType, seek, start, totalSize)) {
+        datafile.close();
+        return false;
+    }
     size_t i = 0;
-    bool done = false;
-    _webserver->setContentLength(totalFileSize);
-    _webserver->send(200, contentType, "");
-    uint8_t buf[DOWNLOAD_PACKET_SIZE];
+    bool done = (totalSize == 0);
+    //next block is read from SD while current one is sent
+    ESP_ReadPipeline pipeline;
+    ESP_ReadPipeline::reader_t reader = [&datafile](uint8_t * buf, size_t size) {
+        return (int)datafile.read(buf, size);
+    };
+    if (!done && !pipeline.begin(reader, totalSize)) {
+        datafile.close();
+        return false;
+    }
+#ifdef ESP_BENCHMARK_FEATURE
+    bool pipelined = pipeline.isPipelined();
+#endif//ESP_BENCHMARK_FEATURE
     while (!done && _webserver->client().connected()) {
         Hal::wait(0);
-        int v = datafile.read(buf,DOWNLOAD_PACKET_SIZE);
-        if ((v == -1) ||  (v == 0)) {
+        size_t v = 0;
+        const uint8_t * buf = pipeline.next(v);
+        if (!buf) {
             done = true;
         } else {
             _webserver->client().write(buf,v);
@@ -162,7 +419,7 @@ bool HTTP_Server::StreamSDFile(const char* filename, const char * contentType)
             bench_transfered += v;
 #endif//ESP_BENCHMARK_FEATURE
         }
-        if (i >= totalFileSize) {
+        if (i >= totalSize) {
             done = true;
         }
 
@@ -172,12 +429,17 @@ bool HTTP_Server::StreamSDFile(const char* filename, const char * contentType)
             last_WS_update = millis();
         }
     }
+    pipeline.end();
     datafile.close();
-    if ( i != totalFileSize) {
+    if ( i != totalSize) {
         return false;
     }
 #ifdef ESP_BENCHMARK_FEATURE
-    benchMark("SD download", bench_start, millis(), bench_transfered);
+    if (totalSize != fileSize) {
+        benchMark(pipelined?"SD ranged download (pipelined)":"SD ranged download", bench_start, millis(), bench_transfered);
+    } else {
+        benchMark(pipelined?"SD download (pipelined)":"SD download", bench_start, millis(), bench_transfered);
+    }
 #endif//ESP_BENCHMARK_FEATURE
     return true;
 }
@@ -237,9 +499,9 @@ bool HTTP_Server::begin()
     //Autorization is already added
     //ask server to track these headers
 #ifdef AUTHENTICATION_FEATURE
-    const char * headerkeys[] = {"Cookie","Content-Length"} ;
+    const char * headerkeys[] = {"Cookie","Content-Length","If-None-Match","Range"} ;
 #else
-    const char * headerkeys[] = {"Content-Length"} ;
+    const char * headerkeys[] = {"Content-Length","If-None-Match","Range"} ;
 #endif
     size_t headerkeyssize = sizeof (headerkeys) / sizeof (char*);
     _webserver->collectHeaders (headerkeys, headerkeyssize );
@@ -22,6 +22,7 @@
 #ifndef _HTTP_SERVER_H
 #define _HTTP_SERVER_H
 #include "../../include/esp3d_config.h"
+#include <functional>
 //class WebSocketsServer;
 #if defined (ARDUINO_ARCH_ESP32)
 class WebServer;
@@ -32,6 +33,10 @@ class WebServer;
 #define WEBSERVER ESP8266WebServer
 #endif //ARDUINO_ARCH_ESP8266
 
+//number of static files metadata kept in memory
+#ifndef HTTP_STATIC_CACHE_SIZE
+#define HTTP_STATIC_CACHE_SIZE 8
+#endif //HTTP_STATIC_CACHE_SIZE
 
 //Upload status
 typedef enum {
@@ -72,12 +77,19 @@ private:
     static void handle_snap();
 #endif //CAMERA_DEVICE
     static void init_handlers();
+    static int8_t getRange(size_t fileSize, size_t & start, size_t & end);
+    typedef std::function<bool(size_t)> seeker_t;
+    static bool sendRangeHeaders(size_t fileSize, const char * contentType, seeker_t seek, size_t & start, size_t & len);
     static bool StreamFSFile(const char* filename, const char * contentType);
+    static bool StreamFSStaticFile(const char* path);
     static void handle_root();
     static void handle_login();
     static void handle_not_found ();
     static void handle_web_command ();
     static void handle_config ();
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    static void handle_printer_state ();
+#endif //ESP_STATUS_CHANNEL_FEATURE
     // static void handle_Websocket_Event(uint8_t num, uint8_t type, uint8_t * payload, size_t length);
 #ifdef FILESYSTEM_FEATURE
     static void FSFileupload ();
@@ -99,12 +99,22 @@
 
 #define UPLOAD_BAUD_RATE    1958400
 
+//Command frame handshake states
+#define MKS_COMMAND_IDLE        0
+#define MKS_COMMAND_WAITING     1
+
 bool MKSService::_started = false;
 uint8_t MKSService::_frame[MKS_FRAME_SIZE] = {0};
 char MKSService::_moduleId[22] = {0};
 uint8_t MKSService::_uploadStatus = UNKNOW_STATE;
 long MKSService::_commandBaudRate = 115200;
 bool MKSService::_uploadMode = false;
+uint8_t MKSService::_commandFrame[MKS_FRAME_SIZE] = {0};
+size_t MKSService::_commandSize = 0;
+uint16_t MKSService::_commandLines = 0;
+uint32_t MKSService::_commandsLost = 0;
+uint8_t MKSService::_commandState = MKS_COMMAND_IDLE;
+uint32_t MKSService::_commandStartTime = 0;
 
 bool MKSService::isHead(const char c)
 {
@@ -150,6 +160,8 @@ void MKSService::commandMode(bool fromSettings)
 void MKSService::uploadMode()
 {
     log_esp3d("Upload Mode");
+    //commands must reach board before baud rate change
+    flushCommands();
     _uploadMode = true;
     serial_service.updateBaudRate(UPLOAD_BAUD_RATE);
 }
@@ -505,6 +517,8 @@ void MKSService::messageWiFiConfig(const uint8_t * dataFrame, const size_t dataS
 
 bool MKSService::canSendFrame()
 {
+    //keep frames order and do not mix handshakes
+    flushCommands();
     log_esp3d("Is board ready for frame?");
     digitalWrite(ESP_FLAG_PIN, BOARD_READY_FLAG_VALUE);
     uint32_t startTime = millis();
@@ -525,44 +539,100 @@ void MKSService::sendFrameDone()
 
 }
 
+//Lines are packed in command frame until board is ready to get it
+//so several lines share same handshake
+//return false if line is refused or lost, lines lost later are counted in commandsLost()
 bool MKSService::sendGcodeFrame(const char* cmd)
 {
     if (_uploadMode) {
         return false;
     }
-    String tmp = cmd;
-    if (tmp.endsWith("\n")) {
-        tmp[tmp.length()-1]='\0';
+    size_t len = strlen(cmd);
+    while ((len > 0) && ((cmd[len-1] == '\n') || (cmd[len-1] == '\r'))) {
+        len--;
     }
-    log_esp3d("Packing: *%s*, size=%d", tmp.c_str(), strlen(tmp.c_str()));
-    clearFrame();
-    _frame[MKS_FRAME_HEAD_OFFSET] = MKS_FRAME_HEAD_FLAG;
-    _frame[MKS_FRAME_TYPE_OFFSET] = MKS_FRAME_DATA_COMMAND_TYPE;
-    for(uint i = 0 ; i < strlen(tmp.c_str()); i++) {
-        _frame[MKS_FRAME_DATA_OFFSET + i]=tmp[i];
+    //line end is \r\n in frame
+    if ((len + 2) > MKS_FRAME_DATA_MAX_SIZE) {
+        log_esp3d("Command too long %d", len);
+        return false;
     }
-    _frame[MKS_FRAME_DATA_OFFSET + strlen(tmp.c_str())] = '\r';
-    _frame[MKS_FRAME_DATA_OFFSET + strlen(tmp.c_str())+1] = '\n';
-    _frame[MKS_FRAME_DATA_OFFSET + strlen(tmp.c_str())+2] = MKS_FRAME_TAIL_FLAG;
-    _frame[MKS_FRAME_DATALEN_OFFSET] = (strlen(tmp.c_str())+2) & 0xff;
-    _frame[MKS_FRAME_DATALEN_OFFSET+1] = ((strlen(tmp.c_str())+2) >> 8) & 0xff;
+    //no more room, so wait for pending lines to be sent
+    if ((_commandSize + len + 2) > MKS_FRAME_DATA_MAX_SIZE) {
+        if (!flushCommands()) {
+            log_esp3d("Pending commands lost");
+        }
+    }
+    log_esp3d("Packing: %d chars, frame data size=%d", len, _commandSize + len + 2);
+    memcpy(&_commandFrame[MKS_FRAME_DATA_OFFSET + _commandSize], cmd, len);
+    _commandSize += len;
+    _commandFrame[MKS_FRAME_DATA_OFFSET + _commandSize] = '\r';
+    _commandFrame[MKS_FRAME_DATA_OFFSET + _commandSize + 1] = '\n';
+    _commandSize += 2;
+    _commandLines++;
+    //send now if board is already ready
+    return processCommandFrame();
+}
 
-    log_esp3d("Size of data in frame %d ", strlen(tmp.c_str())+2);
-    //for (uint i =0; i< strlen(tmp.c_str())+7;i++){
-    //log_esp3d("%c %x",_frame[i],_frame[i]);
-    //}
+//Reset command frame, lines not sent are counted as lost
+void MKSService::clearCommandFrame(bool lost)
+{
+    if (lost) {
+        _commandsLost += _commandLines;
+        log_esp3d("%d commands lost, %d total", _commandLines, _commandsLost);
+    }
+    sendFrameDone();
+    _commandState = MKS_COMMAND_IDLE;
+    _commandSize = 0;
+    _commandLines = 0;
+}
 
-    if (canSendFrame()) {
+//Handshake of command frame, never wait
+//return false if frame could not be sent
+bool MKSService::processCommandFrame()
+{
+    if (_commandSize == 0) {
+        return true;
+    }
+    if (_commandState == MKS_COMMAND_IDLE) {
+        log_esp3d("Is board ready for command frame?");
+        digitalWrite(ESP_FLAG_PIN, BOARD_READY_FLAG_VALUE);
+        _commandStartTime = millis();
+        _commandState = MKS_COMMAND_WAITING;
+    }
+    size_t frameSize = _commandSize + 5;
+    if ((digitalRead(BOARD_FLAG_PIN) == BOARD_READY_FLAG_VALUE) && (serial_service.availableForWrite() >= (int)frameSize)) {
+        _commandFrame[MKS_FRAME_HEAD_OFFSET] = MKS_FRAME_HEAD_FLAG;
+        _commandFrame[MKS_FRAME_TYPE_OFFSET] = MKS_FRAME_DATA_COMMAND_TYPE;
+        _commandFrame[MKS_FRAME_DATALEN_OFFSET] = _commandSize & 0xff;
+        _commandFrame[MKS_FRAME_DATALEN_OFFSET+1] = (_commandSize >> 8) & 0xff;
+        _commandFrame[MKS_FRAME_DATA_OFFSET + _commandSize] = MKS_FRAME_TAIL_FLAG;
+        log_esp3d("Size of data in frame %d ", _commandSize);
         ESP3DOutput output(ESP_SERIAL_CLIENT);
-        if (output.write(_frame,strlen(tmp.c_str())+7) == (strlen(tmp.c_str())+7)) {
-            log_esp3d("Ok");
-            sendFrameDone();
-            return true;
+        bool res = (output.write(_commandFrame, frameSize) == frameSize);
+        log_esp3d("%s", res?"Ok":"Failed");
+        clearCommandFrame(!res);
+        return res;
+    }
+    if ((millis() - _commandStartTime) > FRAME_WAIT_TO_SEND_TIMEOUT) {
+        log_esp3d("Time out no board answer");
+        clearCommandFrame(true);
+        return false;
+    }
+    return true;
+}
+
+//Send pending commands, waiting for board if necessary
+bool MKSService::flushCommands()
+{
+    while (_commandSize > 0) {
+        if (!processCommandFrame()) {
+            return false;
+        }
+        if (_commandSize > 0) {
+            Hal::wait(0);
         }
     }
-    log_esp3d("Failed");
-    sendFrameDone();
-    return false;
+    return true;
 }
 
 bool MKSService::sendNetworkFrame()
@@ -746,12 +816,14 @@ void MKSService::clearFrame(uint start)
 void MKSService::handle()
 {
     if (_started ) {
+        processCommandFrame();
         sendNetworkFrame();
     }
     //network frame every 10s
 }
 void MKSService::end()
 {
+    clearCommandFrame(_commandLines > 0);
     _started = false;
 }
 
@@ -37,6 +37,10 @@ public:
     {
         return _started;
     }
+    static uint32_t commandsLost()
+    {
+        return _commandsLost;
+    }
     static bool isHead(const char c);
     static bool isTail(const char c);
     static bool isFrame(const char c);
@@ -46,6 +50,7 @@ public:
     static uint getFragmentID(uint32_t fragmentNumber, bool isLast=false);
     static void commandMode(bool fromSettings=false);
     static void uploadMode();
+    static bool flushCommands();
 private:
     static uint8_t _uploadStatus;
     static long _commandBaudRate;
@@ -56,8 +61,17 @@ private:
     static void clearFrame(uint start=0);
     static bool canSendFrame();
     static void sendFrameDone();
+    static bool processCommandFrame();
+    static void clearCommandFrame(bool lost);
     static bool _started;
     static uint8_t _frame[MKS_FRAME_SIZE];
+    //G-code lines waiting to be sent in one frame
+    static uint8_t _commandFrame[MKS_FRAME_SIZE];
+    static size_t _commandSize;
+    static uint16_t _commandLines;
+    static uint32_t _commandsLost;
+    static uint8_t _commandState;
+    static uint32_t _commandStartTime;
     static char _moduleId[22];
     static bool _uploadMode;
 };
@@ -24,6 +24,7 @@
 #include "netservices.h"
 #include "../../core/settings_esp3d.h"
 #include "../../core/esp3doutput.h"
+#include "../../core/profiler.h"
 #ifdef MDNS_FEATURE
 #include "../mDNS/mDNS.h"
 #endif //MDNS_FEATURE
@@ -58,6 +59,9 @@
 #if defined(HTTP_FEATURE) || defined(WS_DATA_FEATURE)
 #include "../websocket/websocket_server.h"
 #endif //HTTP_FEATURE || WS_DATA_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+#include "../printer_status/printer_status.h"
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #ifdef CAPTIVE_PORTAL_FEATURE
 #include <DNSServer.h>
 const byte DNS_PORT = 53;
@@ -78,6 +82,150 @@ DNSServer dnsServer;
 
 bool NetServices::_started = false;
 bool NetServices::_restart = false;
+uint8_t NetServices::_nextService = 0;
+
+//Scheduled network services
+//High priority services are called at each pass,
+//low priority ones only when they have activity or their interval is elapsed,
+//and while time budget of the pass is not spent
+#define NET_SERVICE_HIGH 0
+#define NET_SERVICE_LOW  1
+
+typedef struct {
+    uint8_t id; //profiler id
+    uint8_t priority;
+    uint16_t interval; //ms between 2 calls when idle
+    void (*handle)();
+    bool (*active)(); //readiness hint, nullptr if none
+} esp3d_net_service_t;
+
+#if COMMUNICATION_PROTOCOL == MKS_SERIAL
+static void handleMKS()
+{
+    MKSService::handle();
+}
+#endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
+#ifdef HTTP_FEATURE
+static void handleHTTP()
+{
+    HTTP_Server::handle();
+}
+static void handleWSTerminal()
+{
+    websocket_terminal_server.handle();
+}
+#endif //HTTP_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+static void handleStatus()
+{
+    PrinterStatus::handle();
+}
+#endif //ESP_STATUS_CHANNEL_FEATURE
+#ifdef WS_DATA_FEATURE
+static void handleWSData()
+{
+    websocket_data_server.handle();
+}
+#endif //WS_DATA_FEATURE
+#ifdef TELNET_FEATURE
+static void handleTelnet()
+{
+    telnet_server.handle();
+}
+#endif //TELNET_FEATURE
+#ifdef MDNS_FEATURE
+static void handleMDNS()
+{
+    esp3d_mDNS.handle();
+}
+#endif //MDNS_FEATURE
+#ifdef OTA_FEATURE
+static void handleOTA()
+{
+    ArduinoOTA.handle();
+}
+#endif //OTA_FEATURE
+#ifdef CAPTIVE_PORTAL_FEATURE
+static void handleCaptivePortal()
+{
+    if (NetConfig::getMode() == ESP_AP_SETUP) {
+        dnsServer.processNextRequest();
+    }
+}
+#endif //CAPTIVE_PORTAL_FEATURE
+#ifdef WEBDAV_FEATURE
+static void handleWebdav()
+{
+    webdav_server.handle();
+}
+static bool webdavActive()
+{
+    return webdav_server.isConnected();
+}
+#endif //WEBDAV_FEATURE
+#ifdef FTP_FEATURE
+static void handleFTP()
+{
+    ftp_server.handle();
+}
+static bool ftpActive()
+{
+    return ftp_server.isConnected();
+}
+#endif //FTP_FEATURE
+#ifdef NOTIFICATION_FEATURE
+static void handleNotifications()
+{
+    notificationsservice.handle();
+}
+#endif //NOTIFICATION_FEATURE
+
+//printer related services first
+static const esp3d_net_service_t netServices[] = {
+#if COMMUNICATION_PROTOCOL == MKS_SERIAL
+    {PROFILE_MKS, NET_SERVICE_HIGH, 0, handleMKS, nullptr},
+#endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
+#ifdef HTTP_FEATURE
+    {PROFILE_WS_TERMINAL, NET_SERVICE_HIGH, 0, handleWSTerminal, nullptr},
+#endif //HTTP_FEATURE
+#ifdef TELNET_FEATURE
+    {PROFILE_TELNET, NET_SERVICE_HIGH, 0, handleTelnet, nullptr},
+#endif //TELNET_FEATURE
+#ifdef WS_DATA_FEATURE
+    {PROFILE_WS_DATA, NET_SERVICE_HIGH, 0, handleWSData, nullptr},
+#endif //WS_DATA_FEATURE
+#ifdef HTTP_FEATURE
+    {PROFILE_HTTP, NET_SERVICE_HIGH, 0, handleHTTP, nullptr},
+#endif //HTTP_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    {PROFILE_STATUS, NET_SERVICE_LOW, 10, handleStatus, nullptr},
+#endif //ESP_STATUS_CHANNEL_FEATURE
+#ifdef CAPTIVE_PORTAL_FEATURE
+    {PROFILE_CAPTIVE_PORTAL, NET_SERVICE_LOW, 10, handleCaptivePortal, nullptr},
+#endif //CAPTIVE_PORTAL_FEATURE
+#ifdef WEBDAV_FEATURE
+    {PROFILE_WEBDAV, NET_SERVICE_LOW, 20, handleWebdav, webdavActive},
+#endif //WEBDAV_FEATURE
+#ifdef FTP_FEATURE
+    {PROFILE_FTP, NET_SERVICE_LOW, 20, handleFTP, ftpActive},
+#endif //FTP_FEATURE
+#ifdef MDNS_FEATURE
+    {PROFILE_MDNS, NET_SERVICE_LOW, 50, handleMDNS, nullptr},
+#endif //MDNS_FEATURE
+#ifdef OTA_FEATURE
+    {PROFILE_OTA, NET_SERVICE_LOW, 50, handleOTA, nullptr},
+#endif //OTA_FEATURE
+#ifdef NOTIFICATION_FEATURE
+    {PROFILE_NOTIFICATIONS, NET_SERVICE_LOW, 100, handleNotifications, nullptr},
+#endif //NOTIFICATION_FEATURE
+    //end of list
+    {PROFILE_COUNT, NET_SERVICE_HIGH, 0, nullptr, nullptr}
+};
+
+#define NET_SERVICES_COUNT ((sizeof(netServices) / sizeof(esp3d_net_service_t)) - 1)
+
+//last call of each service
+static uint32_t netServicesLastCall[NET_SERVICES_COUNT + 1];
 
 bool NetServices::begin()
 {
@@ -245,6 +393,16 @@ bool NetServices::begin()
         output.printMSG("Failed start Terminal Web Socket");
     }
 #endif //HTTP_FEATURE 
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    if (!PrinterStatus::begin()) {
+        output.printMSG("Failed start Status Web Socket");
+    } else {
+        if (Settings_ESP3D::isVerboseBoot()) {
+            String stmp = "Status channel started port " + String(PrinterStatus::port());
+            output.printMSG(stmp.c_str());
+        }
+    }
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #ifdef MDNS_FEATURE
     esp3d_mDNS.addESP3DServices(HTTP_Server::port());
 #endif //MDNS_FEATURE
@@ -338,6 +496,9 @@ void NetServices::end()
 #if defined(HTTP_FEATURE)
     websocket_terminal_server.end();
 #endif //HTTP_FEATURE
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+    PrinterStatus::end();
+#endif //ESP_STATUS_CHANNEL_FEATURE
 #ifdef WEBDAV_FEATURE
     webdav_server.end();
 #endif //WEBDAV_FEATURE
@@ -358,41 +519,34 @@ void NetServices::end()
 void NetServices::handle()
 {
     if (_started) {
-#if COMMUNICATION_PROTOCOL == MKS_SERIAL
-        MKSService::handle();
-#endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
-#ifdef MDNS_FEATURE
-        esp3d_mDNS.handle();
-#endif //MDNS_FEATURE
-#ifdef OTA_FEATURE
-        ArduinoOTA.handle();
-#endif //OTA_FEATURE
-#ifdef CAPTIVE_PORTAL_FEATURE
-        if (NetConfig::getMode() == ESP_AP_SETUP) {
-            dnsServer.processNextRequest();
+        uint32_t passStart = millis();
+        //high priority services
+        for (uint8_t i = 0; i < NET_SERVICES_COUNT; i++) {
+            if (netServices[i].priority == NET_SERVICE_HIGH) {
+                PROFILE_HANDLE(netServices[i].id, netServices[i].handle());
+            }
+        }
+        //low priority services, round robin so the same ones are not always the ones delayed
+        for (uint8_t n = 0; n < NET_SERVICES_COUNT; n++) {
+            uint8_t i = (_nextService + n) % NET_SERVICES_COUNT;
+            const esp3d_net_service_t & service = netServices[i];
+            if (service.priority != NET_SERVICE_LOW) {
+                continue;
+            }
+            uint32_t now = millis();
+            uint32_t elapsed = now - netServicesLastCall[i];
+            bool active = service.active && service.active();
+            if (!active && (elapsed < service.interval)) {
+                continue;
+            }
+            //budget spent: wait next pass, unless service is starving
+            if (((now - passStart) >= ESP_NET_SCHEDULER_BUDGET) && (elapsed < ESP_NET_SCHEDULER_MAX_DELAY)) {
+                _nextService = i;
+                break;
+            }
+            PROFILE_HANDLE(service.id, service.handle());
+            netServicesLastCall[i] = millis();
         }
-#endif //CAPTIVE_PORTAL_FEATURE
-#ifdef HTTP_FEATURE
-        HTTP_Server::handle();
-#endif //HTTP_FEATURE
-#ifdef WEBDAV_FEATURE
-        webdav_server.handle();
-#endif //WEBDAV_FEATURE
-#ifdef WS_DATA_FEATURE
-        websocket_data_server.handle();
-#endif //WS_DATA_FEATURE
-#if defined(HTTP_FEATURE)
-        websocket_terminal_server.handle();
-#endif //HTTP_FEATURE
-#ifdef TELNET_FEATURE
-        telnet_server.handle();
-#endif //TELNET_FEATURE
-#ifdef FTP_FEATURE
-        ftp_server.handle();
-#endif //FTP_FEATURE
-#ifdef NOTIFICATION_FEATURE
-        notificationsservice.handle();
-#endif //NOTIFICATION_FEATURE
     }
     if (_restart) {
         begin();
@@ -23,6 +23,16 @@
 #ifndef _NET_SERVICES_H
 #define _NET_SERVICES_H
 
+//Time budget of network services in one loop in ms,
+//low priority services are then delayed to next loop
+#ifndef ESP_NET_SCHEDULER_BUDGET
+#define ESP_NET_SCHEDULER_BUDGET 20
+#endif //ESP_NET_SCHEDULER_BUDGET
+//Low priority services are never delayed longer than this in ms
+#ifndef ESP_NET_SCHEDULER_MAX_DELAY
+#define ESP_NET_SCHEDULER_MAX_DELAY 500
+#endif //ESP_NET_SCHEDULER_MAX_DELAY
+
 
 class NetServices
 {
@@ -37,6 +47,8 @@ public:
 private:
     static bool _started;
     static bool _restart;
+    //first low priority service of next pass
+    static uint8_t _nextService;
 };
 
 #endif //_NET_SERVICES_H
@@ -0,0 +1,393 @@
+/*
+  printer_status.cpp -  printer status channel functions class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "../../include/esp3d_config.h"
+#if defined(ESP_STATUS_CHANNEL_FEATURE)
+#include "printer_status.h"
+#include <WebSocketsServer.h>
+#include "../../core/settings_esp3d.h"
+#include "../../core/commands.h"
+#include "../../core/esp3doutput.h"
+#if defined(GCODE_HOST_FEATURE)
+#include "../gcode_host/gcode_host.h"
+#endif //GCODE_HOST_FEATURE
+
+WebSocketsServer * PrinterStatus::_server = nullptr;
+uint16_t PrinterStatus::_port = 0;
+esp3d_printer_status_t PrinterStatus::_state;
+volatile uint8_t PrinterStatus::_changed = 0;
+uint32_t PrinterStatus::_interval = ESP_STATUS_INTERVAL;
+uint32_t PrinterStatus::_lastSent = 0;
+uint32_t PrinterStatus::_framesSent = 0;
+char PrinterStatus::_line[ESP_STATUS_LINE_SIZE + 1];
+size_t PrinterStatus::_lineSize = 0;
+uint8_t PrinterStatus::_heaters = 0;
+uint32_t PrinterStatus::_lastReport[STATUS_REPORTS] = {0};
+uint32_t PrinterStatus::_pollInterval = ESP_PRINTER_POLL_INTERVAL;
+uint32_t PrinterStatus::_lastPoll = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+//parse runs in serial task, handle and commands in main loop
+//only stores are done under lock, never parsing, so lock is short
+static portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+#define STATUS_LOCK() portENTER_CRITICAL(&statusMux)
+#define STATUS_UNLOCK() portEXIT_CRITICAL(&statusMux)
+#else
+#define STATUS_LOCK()
+#define STATUS_UNLOCK()
+#endif //ARDUINO_ARCH_ESP32
+
+static const char * const heaterTags[STATUS_HEATERS] = {"T0:", "T1:", "B:", "C:"};
+static const char * const axisTags[STATUS_AXIS] = {"X:", "Y:", "Z:", "E:"};
+
+//tag must start the line or follow a space, so B: does not match in B@: or in T:
+static char * findTag(char * line, const char * tag)
+{
+    size_t tagLen = strlen(tag);
+    char * p = line;
+    while ((p = strstr(p, tag)) != nullptr) {
+        if ((p == line) || (p[-1] == ' ')) {
+            return p + tagLen;
+        }
+        p += tagLen;
+    }
+    return nullptr;
+}
+
+static uint8_t * putU16(uint8_t * p, uint16_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    return p + 2;
+}
+
+static uint8_t * putU32(uint8_t * p, uint32_t value)
+{
+    p = putU16(p, value & 0xFFFF);
+    return putU16(p, (value >> 16) & 0xFFFF);
+}
+
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+//Same path as a command from web client, so gcode host keeps track of acks
+static void sendPoll(const char * command)
+{
+    ESP3DOutput output(ESP_ALL_CLIENTS);
+    ESP3DOutput outputOnly(ESP_SERIAL_CLIENT);
+    esp3d_commands.process((uint8_t *)command, strlen(command), &output, LEVEL_ADMIN, &outputOnly);
+}
+#endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+
+esp3d_printer_status_t PrinterStatus::state()
+{
+    STATUS_LOCK();
+    esp3d_printer_status_t state = _state;
+    STATUS_UNLOCK();
+    return state;
+}
+
+uint8_t PrinterStatus::heaters()
+{
+    STATUS_LOCK();
+    uint8_t heaters = _heaters;
+    STATUS_UNLOCK();
+    return heaters;
+}
+
+uint32_t PrinterStatus::lastReport(uint8_t report)
+{
+    if (report >= STATUS_REPORTS) {
+        return 0;
+    }
+    STATUS_LOCK();
+    uint32_t last = _lastReport[report];
+    STATUS_UNLOCK();
+    return last;
+}
+
+void PrinterStatus::setPollInterval(uint32_t interval)
+{
+    if ((interval != 0) && (interval < ESP_PRINTER_MIN_POLL_INTERVAL)) {
+        interval = ESP_PRINTER_MIN_POLL_INTERVAL;
+    }
+    _pollInterval = interval;
+}
+
+//Only poller of the printer: a report received since last poll,
+//from auto report or from another client query, is as good as a new one
+void PrinterStatus::_poll()
+{
+#if COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+    if (_pollInterval == 0) {
+        return;
+    }
+    uint32_t now = millis();
+    if ((now - _lastPoll) < _pollInterval) {
+        return;
+    }
+    _lastPoll = now;
+    if ((now - lastReport(STATUS_REPORT_TEMPERATURE)) >= _pollInterval) {
+        sendPoll("M105\n");
+    }
+    bool streaming = false;
+#if defined(GCODE_HOST_FEATURE)
+    //progress of a stream from ESP is known without asking
+    streaming = (esp3d_gcode_host.getStatus() != HOST_NO_STREAM);
+#endif //GCODE_HOST_FEATURE
+    if (!streaming && ((now - lastReport(STATUS_REPORT_PROGRESS)) >= _pollInterval)) {
+        sendPoll("M27\n");
+    }
+    //M114 waits for moves to end on some firmwares, so position is only polled when not printing
+    if (!streaming && !state().printing && ((now - lastReport(STATUS_REPORT_POSITION)) >= _pollInterval)) {
+        sendPoll("M114\n");
+    }
+#endif //COMMUNICATION_PROTOCOL == RAW_SERIAL || COMMUNICATION_PROTOCOL == MKS_SERIAL
+}
+
+bool PrinterStatus::begin()
+{
+    end();
+    _port = Settings_ESP3D::read_uint32(ESP_HTTP_PORT) + ESP_STATUS_PORT_OFFSET;
+    _server = new WebSocketsServer(_port, "", ESP_STATUS_PROTOCOL);
+    if (!_server) {
+        _port = 0;
+        return false;
+    }
+    _server->begin();
+    _server->onEvent(PrinterStatus::onEvent);
+    _interval = ESP_STATUS_INTERVAL;
+    _lastSent = millis();
+    _framesSent = 0;
+    return true;
+}
+
+void PrinterStatus::end()
+{
+    if (_server) {
+        _server->close();
+        delete _server;
+        _server = nullptr;
+    }
+    _port = 0;
+}
+
+void PrinterStatus::handle()
+{
+    if (!_server) {
+        return;
+    }
+    _server->loop();
+    _poll();
+    if (_changed == 0) {
+        return;
+    }
+    //a new client gets the full state anyway
+    if (_server->connectedClients() == 0) {
+        STATUS_LOCK();
+        _changed = 0;
+        STATUS_UNLOCK();
+        return;
+    }
+    if ((millis() - _lastSent) < _interval) {
+        return;
+    }
+    //state and mask are taken together, so a change made after is sent next time
+    STATUS_LOCK();
+    uint8_t mask = _changed;
+    _changed = 0;
+    esp3d_printer_status_t state = _state;
+    STATUS_UNLOCK();
+    uint8_t frame[STATUS_FRAME_MAX_SIZE];
+    size_t size = _buildFrame(state, mask, frame);
+    _server->broadcastBIN(frame, size);
+    _lastSent = millis();
+    _framesSent++;
+}
+
+void PrinterStatus::onEvent(uint8_t num, uint8_t type, uint8_t * payload, size_t length)
+{
+    (void)length;
+    switch(type) {
+    case WStype_CONNECTED: {
+        log_esp3d("[%u] Status client connected port %d", num, _port);
+        uint8_t frame[STATUS_FRAME_MAX_SIZE];
+        size_t size = _buildFrame(state(), STATUS_FIELD_ALL, frame);
+        _server->sendBIN(num, frame, size);
+    }
+    break;
+    case WStype_DISCONNECTED:
+        log_esp3d("[%u] Status client disconnected port %d", num, _port);
+        break;
+    case WStype_TEXT:
+        //only setting is the rate, shared by all clients
+        if (strncmp((const char *)payload, "interval:", 9) == 0) {
+            uint32_t interval = strtoul((const char *)payload + 9, nullptr, 10);
+            _interval = (interval < ESP_STATUS_MIN_INTERVAL)?ESP_STATUS_MIN_INTERVAL:interval;
+            log_esp3d("Status interval %d ms", _interval);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+size_t PrinterStatus::_buildFrame(const esp3d_printer_status_t & state, uint8_t mask, uint8_t * frame)
+{
+    uint8_t * p = frame;
+    *p++ = STATUS_FRAME_VERSION;
+    *p++ = mask;
+    for (uint8_t i = 0; i < STATUS_HEATERS; i++) {
+        if (mask & (1 << i)) {
+            p = putU16(p, state.temperature[i]);
+            p = putU16(p, state.target[i]);
+        }
+    }
+    if (mask & STATUS_FIELD_POSITION) {
+        for (uint8_t i = 0; i < STATUS_AXIS; i++) {
+            p = putU32(p, state.position[i]);
+        }
+    }
+    if (mask & STATUS_FIELD_PROGRESS) {
+        *p++ = state.printing;
+        p = putU32(p, state.printed);
+        p = putU32(p, state.size);
+    }
+    return p - frame;
+}
+
+//Called for each chunk of printer output, lines are assembled here
+//because a chunk may not end with a line
+void PrinterStatus::parse(const uint8_t * sbuf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if ((sbuf[i] == '\n') || (sbuf[i] == '\r')) {
+            if (_lineSize > 0) {
+                _line[_lineSize] = 0;
+                _parseLine(_line);
+                _lineSize = 0;
+            }
+        } else if (_lineSize < ESP_STATUS_LINE_SIZE) {
+            //beginning of a too long line is enough for reports
+            _line[_lineSize++] = sbuf[i];
+        }
+    }
+}
+
+void PrinterStatus::_setHeater(uint8_t index, float temperature, float target, bool hasTarget)
+{
+    int16_t value = lroundf(temperature * 10);
+    int16_t targetValue = lroundf(target * 10);
+    uint32_t now = millis();
+    STATUS_LOCK();
+    if (value != _state.temperature[index]) {
+        _state.temperature[index] = value;
+        _changed |= (1 << index);
+    }
+    if (hasTarget && (targetValue != _state.target[index])) {
+        _state.target[index] = targetValue;
+        _changed |= (1 << index);
+    }
+    _heaters |= (1 << index);
+    _lastReport[STATUS_REPORT_TEMPERATURE] = now;
+    STATUS_UNLOCK();
+}
+
+void PrinterStatus::_parseLine(char * l)
+{
+    char * p;
+    //M27: "SD printing byte 1234/5678" or "Not SD printing"
+    if ((p = strstr(l, "SD printing byte ")) != nullptr) {
+        char * end;
+        uint32_t printed = strtoul(p + 17, &end, 10);
+        uint32_t size = (*end == '/')?strtoul(end + 1, nullptr, 10):0;
+        uint32_t now = millis();
+        STATUS_LOCK();
+        _lastReport[STATUS_REPORT_PROGRESS] = now;
+        if (!_state.printing || (printed != _state.printed) || (size != _state.size)) {
+            _state.printing = 1;
+            _state.printed = printed;
+            _state.size = size;
+            _changed |= STATUS_FIELD_PROGRESS;
+        }
+        STATUS_UNLOCK();
+        return;
+    }
+    if (strstr(l, "Not SD printing") || strstr(l, "Done printing file")) {
+        uint32_t now = millis();
+        STATUS_LOCK();
+        _lastReport[STATUS_REPORT_PROGRESS] = now;
+        if (_state.printing) {
+            _state.printing = 0;
+            _changed |= STATUS_FIELD_PROGRESS;
+        }
+        STATUS_UNLOCK();
+        return;
+    }
+    //M114: "X:10.00 Y:20.00 Z:0.30 E:0.00 Count X:800 Y:1600 Z:120"
+    if (findTag(l, "X:") && findTag(l, "Y:") && findTag(l, "Z:")) {
+        //stepper counts are not positions
+        if ((p = strstr(l, " Count")) != nullptr) {
+            *p = 0;
+        }
+        int32_t values[STATUS_AXIS];
+        bool found[STATUS_AXIS];
+        for (uint8_t i = 0; i < STATUS_AXIS; i++) {
+            found[i] = ((p = findTag(l, axisTags[i])) != nullptr);
+            values[i] = found[i]?lroundf(strtof(p, nullptr) * 100):0;
+        }
+        uint32_t now = millis();
+        STATUS_LOCK();
+        _lastReport[STATUS_REPORT_POSITION] = now;
+        for (uint8_t i = 0; i < STATUS_AXIS; i++) {
+            if (found[i] && (values[i] != _state.position[i])) {
+                _state.position[i] = values[i];
+                _changed |= STATUS_FIELD_POSITION;
+            }
+        }
+        STATUS_UNLOCK();
+        return;
+    }
+    //M105 or auto report: "ok T:210.0 /210.0 B:60.0 /60.0 T0:210.0 /210.0 @:0 B@:0"
+    for (uint8_t i = 0; i < STATUS_HEATERS; i++) {
+        p = findTag(l, heaterTags[i]);
+        //single tool printers only report T:
+        if (!p && (i == 0)) {
+            p = findTag(l, "T:");
+        }
+        if (p) {
+            char * end;
+            float temperature = strtof(p, &end);
+            if (end == p) {
+                continue;
+            }
+            while (*end == ' ') {
+                end++;
+            }
+            float target = 0;
+            bool hasTarget = false;
+            if (*end == '/') {
+                target = strtof(end + 1, nullptr);
+                hasTarget = true;
+            }
+            _setHeater(i, temperature, target, hasTarget);
+        }
+    }
+}
+
+#endif //ESP_STATUS_CHANNEL_FEATURE
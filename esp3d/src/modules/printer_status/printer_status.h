@@ -0,0 +1,135 @@
+/*
+  printer_status.h -  printer status channel functions class
+
+  Copyright (c) 2014 Luc Lebosse. All rights reserved.
+
+  This code is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with This code; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _PRINTER_STATUS_H
+#define _PRINTER_STATUS_H
+#include "../../include/esp3d_config.h"
+
+//Websocket sub-protocol of status channel
+#define ESP_STATUS_PROTOCOL "esp3d-status"
+
+//Status channel port is HTTP port + offset (terminal websocket is HTTP port + 1)
+#ifndef ESP_STATUS_PORT_OFFSET
+#define ESP_STATUS_PORT_OFFSET 2
+#endif //ESP_STATUS_PORT_OFFSET
+
+//Default min time in ms between 2 frames, a client can change it by sending "interval:<ms>"
+#ifndef ESP_STATUS_INTERVAL
+#define ESP_STATUS_INTERVAL 500
+#endif //ESP_STATUS_INTERVAL
+#define ESP_STATUS_MIN_INTERVAL 100
+
+//Default time in ms between 2 polls of the printer, 0 to disable,
+//can be changed with [ESP702]POLL=<ms>
+#ifndef ESP_PRINTER_POLL_INTERVAL
+#define ESP_PRINTER_POLL_INTERVAL 3000
+#endif //ESP_PRINTER_POLL_INTERVAL
+#define ESP_PRINTER_MIN_POLL_INTERVAL 500
+
+//Longest printer report line parsed
+#define ESP_STATUS_LINE_SIZE 128
+
+//Heaters: tool 0, tool 1, bed, chamber
+#define STATUS_HEATERS 4
+#define STATUS_BED     2
+#define STATUS_CHAMBER 3
+//Axis: X, Y, Z, E
+#define STATUS_AXIS    4
+
+//Kind of reports
+#define STATUS_REPORT_TEMPERATURE 0
+#define STATUS_REPORT_POSITION    1
+#define STATUS_REPORT_PROGRESS    2
+#define STATUS_REPORTS            3
+
+//Frame: version byte, fields mask byte, then fields of mask in bits order, little endian
+//bits 0 to 3: heater temperature and target, 2 x int16 in 1/10 degree
+//bit 4: position, 4 x int32 in 1/100 mm
+//bit 5: progress, uint8 printing flag, uint32 printed bytes, uint32 file size
+#define STATUS_FRAME_VERSION   1
+#define STATUS_FIELD_POSITION  (1 << STATUS_HEATERS)
+#define STATUS_FIELD_PROGRESS  (1 << (STATUS_HEATERS + 1))
+#define STATUS_FIELD_ALL       ((1 << (STATUS_HEATERS + 2)) - 1)
+#define STATUS_FRAME_MAX_SIZE  (2 + (STATUS_HEATERS * 4) + (STATUS_AXIS * 4) + 9)
+
+typedef struct {
+    int16_t temperature[STATUS_HEATERS];
+    int16_t target[STATUS_HEATERS];
+    int32_t position[STATUS_AXIS];
+    uint8_t printing;
+    uint32_t printed;
+    uint32_t size;
+} esp3d_printer_status_t;
+
+class WebSocketsServer;
+
+class PrinterStatus
+{
+public:
+    static bool begin();
+    static void end();
+    static void handle();
+    static bool started()
+    {
+        return _server != nullptr;
+    }
+    static uint16_t port()
+    {
+        return _port;
+    }
+    //printer output, may be any part of lines
+    static void parse(const uint8_t * sbuf, size_t len);
+    //copy, as parse may update state from serial task
+    static esp3d_printer_status_t state();
+    static uint32_t framesSent()
+    {
+        return _framesSent;
+    }
+    //heaters reported at least once, bit per heater
+    static uint8_t heaters();
+    //millis() of last report of this kind, 0 if none yet
+    static uint32_t lastReport(uint8_t report);
+    static uint32_t pollInterval()
+    {
+        return _pollInterval;
+    }
+    static void setPollInterval(uint32_t interval);
+    static void onEvent(uint8_t num, uint8_t type, uint8_t * payload, size_t length);
+private:
+    static WebSocketsServer * _server;
+    static uint16_t _port;
+    static esp3d_printer_status_t _state;
+    static volatile uint8_t _changed;
+    static uint32_t _interval;
+    static uint32_t _lastSent;
+    static uint32_t _framesSent;
+    static uint8_t _heaters;
+    static uint32_t _lastReport[STATUS_REPORTS];
+    static uint32_t _pollInterval;
+    static uint32_t _lastPoll;
+    static char _line[ESP_STATUS_LINE_SIZE + 1];
+    static size_t _lineSize;
+    static void _parseLine(char * line);
+    static void _setHeater(uint8_t index, float temperature, float target, bool hasTarget);
+    static size_t _buildFrame(const esp3d_printer_status_t & state, uint8_t mask, uint8_t * frame);
+    static void _poll();
+};
+
+#endif //_PRINTER_STATUS_H
@@ -28,6 +28,9 @@
 #include "../mks/mks_service.h"
 #endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
 #include "../authentication/authentication_service.h"
+#if defined(GCODE_HOST_FEATURE)
+#include "../gcode_host/gcode_host.h"
+#endif //GCODE_HOST_FEATURE
 #if defined (ARDUINO_ARCH_ESP8266)
 #define MAX_SERIAL 2
 HardwareSerial * Serials[MAX_SERIAL] = {&Serial, &Serial1};
@@ -65,6 +68,36 @@ TaskHandle_t _hserialtask= nullptr;
 const long SupportedBaudList[] = {9600, 19200, 38400, 57600, 74880, 115200, 230400, 250000, 500000, 921600, 1958400};
 
 #define TIMEOUT_SERIAL_FLUSH 1500
+#define TX_MUTEX_TIMEOUT 100
+
+#if defined(ARDUINO_ARCH_ESP32)
+//Hold the TX queue mutex until end of scope
+class TxLock
+{
+public:
+    TxLock(SemaphoreHandle_t mutex)
+    {
+        _mutex = mutex;
+        _locked = _mutex && (xSemaphoreTake(_mutex, TX_MUTEX_TIMEOUT / portTICK_PERIOD_MS) == pdTRUE);
+    }
+    ~TxLock()
+    {
+        if (_locked) {
+            xSemaphoreGive(_mutex);
+        }
+    }
+    bool locked()
+    {
+        return _locked || !_mutex;
+    }
+private:
+    SemaphoreHandle_t _mutex;
+    bool _locked;
+};
+#define TX_LOCK(ret) TxLock txLock(_txMutex); if (!txLock.locked()) { return ret; }
+#else
+#define TX_LOCK(ret)
+#endif //ARDUINO_ARCH_ESP32
 //Constructor
 SerialService::SerialService(uint8_t id)
 {
@@ -72,6 +105,12 @@ SerialService::SerialService(uint8_t id)
     _started = false;
     _needauthentication = true;
     _id = id;
+    _txStart = 0;
+    _txSize = 0;
+    resetTxStats();
+#if defined(ARDUINO_ARCH_ESP32)
+    _txMutex = nullptr;
+#endif //ARDUINO_ARCH_ESP32
     switch (_id) {
     case MAIN_SERIAL:
         _rxPin = ESP_RX_PIN;
@@ -105,6 +144,14 @@ void ESP3DSerialTaskfn( void * parameter )
 {
     for(;;) {
         serial_service.process();
+#if defined(ESP_HOST_TASK)
+        esp3d_gcode_host.handle();
+        //do not slow down streaming, acks are waited here
+        if (esp3d_gcode_host.getStatus() != HOST_NO_STREAM) {
+            Hal::wait(1);
+            continue;
+        }
+#endif //ESP_HOST_TASK
         Hal::wait(SERIAL_YIELD);  // Yield to other tasks
     }
     vTaskDelete( NULL );
@@ -135,6 +182,14 @@ bool SerialService::begin(uint8_t serialIndex)
         return false;
     }
     _lastflush = millis();
+    _txStart = 0;
+    _txSize = 0;
+#if defined(ARDUINO_ARCH_ESP32)
+    //never deleted, serial task may still be using it
+    if (!_txMutex) {
+        _txMutex = xSemaphoreCreateMutex();
+    }
+#endif //ARDUINO_ARCH_ESP32
     //read from settings
     long br = 0;
     long defaultBr = 0;
@@ -204,6 +259,8 @@ bool SerialService::end()
     swap();
     Serials[_serialIndex]->end();
     _buffer_size = 0;
+    _txStart = 0;
+    _txSize = 0;
     _started = false;
     return true;
 }
@@ -235,21 +292,42 @@ void SerialService::process()
     if (!_started) {
         return;
     }
+    {
+        //send queued output first
+        TX_LOCK();
+        _sendQueue();
+    }
     //Do we have some data waiting
     size_t len = available();
     if (len > 0) {
-        //if yes read them
         log_esp3d("Got %d chars in serial", len);
-        uint8_t * sbuf = (uint8_t *)malloc(len);
-        if(sbuf) {
-            size_t count = readBytes(sbuf, len);
-            //push to buffer
-            if (count > 0) {
-                push2buffer(sbuf, count);
+#if COMMUNICATION_PROTOCOL == MKS_SERIAL
+        uint8_t sbuf[ESP3D_SERIAL_RX_CHUNK];
+        while ((len > 0) && _started) {
+            size_t count = readBytes(sbuf, (len < ESP3D_SERIAL_RX_CHUNK)?len:ESP3D_SERIAL_RX_CHUNK);
+            if ((count == 0) || (count > ESP3D_SERIAL_RX_CHUNK)) {
+                break;
+            }
+            len -= count;
+            push2buffer(sbuf, count);
+        }
+#else
+        //read in place after pending data, no copy
+        while ((len > 0) && _started) {
+            if (_buffer_size == ESP3D_SERIAL_BUFFER_SIZE) {
+                //line too long, send it as it is
+                flushbuffer();
+            }
+            size_t room = ESP3D_SERIAL_BUFFER_SIZE - _buffer_size;
+            size_t count = readBytes(&_buffer[_buffer_size], (len < room)?len:room);
+            if ((count == 0) || (count > room)) {
+                break;
             }
-            //freen buffer
-            free(sbuf);
+            len -= count;
+            _lastflush = millis();
+            _scanLines(_buffer_size, _buffer_size + count);
         }
+#endif //COMMUNICATION_PROTOCOL == MKS_SERIAL
     }
     //we cannot left data in buffer too long
     //in case some commands "forget" to add \n
@@ -284,6 +362,79 @@ void SerialService::flushbuffer()
     _buffer_size = 0;
 }
 
+//Index of first byte which is not printable (so \r and \n too), or len if none
+//Aligned words are checked 4 bytes at once, and only a word with such byte is checked byte per byte
+static size_t scanPrintable(const uint8_t * data, size_t len)
+{
+    size_t i = 0;
+    while ((i < len) && (((uintptr_t)&data[i]) & 3)) {
+        if ((data[i] < 0x20) || (data[i] > 0x7E)) {
+            return i;
+        }
+        i++;
+    }
+    while ((i + 4) <= len) {
+        uint32_t w = *(const uint32_t *)&data[i];
+        //high bit of a byte is set if one byte is < 0x20 or > 0x7E
+        if ((((w - 0x20202020UL) & ~w) | (w + 0x01010101UL) | w) & 0x80808080UL) {
+            break;
+        }
+        i += 4;
+    }
+    for (; i < len; i++) {
+        if ((data[i] < 0x20) || (data[i] > 0x7E)) {
+            return i;
+        }
+    }
+    return len;
+}
+
+//Process complete lines of _buffer in place, bytes before start are already scanned
+//Incomplete line is moved to beginning of buffer
+void SerialService::_scanLines(size_t start, size_t end)
+{
+    size_t lineStart = 0;
+    size_t pos = start;
+    while (pos < end) {
+        pos += scanPrintable(&_buffer[pos], end - pos);
+        if (pos == end) {
+            break;
+        }
+        if ((_buffer[pos] == '\n') || (_buffer[pos] == '\r')) {
+            //command is defined
+            _processLine(lineStart, pos + 1 - lineStart);
+        } else {
+            //not printable char is processed alone, after pending data
+            if (pos > lineStart) {
+                _processLine(lineStart, pos - lineStart);
+            }
+            _processLine(pos, 1);
+        }
+        pos++;
+        lineStart = pos;
+        //serial may be stopped by a command
+        if (!_started) {
+            _buffer_size = 0;
+            return;
+        }
+    }
+    if (lineStart > 0) {
+        memmove(_buffer, &_buffer[lineStart], end - lineStart);
+    }
+    _buffer_size = end - lineStart;
+}
+
+void SerialService::_processLine(size_t start, size_t len)
+{
+    ESP3DOutput output(_client);
+    //line must be 0 terminated, so next byte is saved
+    uint8_t next = _buffer[start + len];
+    _buffer[start + len] = 0x0;
+    esp3d_commands.process(&_buffer[start], len, &output,_needauthentication?LEVEL_GUEST:LEVEL_ADMIN);
+    _buffer[start + len] = next;
+    _lastflush = millis();
+}
+
 //push collected data to buffer and proceed accordingly
 void SerialService::push2buffer(uint8_t * sbuf, size_t len)
 {
@@ -385,34 +536,19 @@ void SerialService::push2buffer(uint8_t * sbuf, size_t len)
         }
     }
 #else
-    for (size_t i = 0; i < len; i++) {
-        _lastflush = millis();
-        //command is defined
-        if ((char(sbuf[i]) == '\n')|| (char(sbuf[i]) == '\r')) {
-            if (_buffer_size < ESP3D_SERIAL_BUFFER_SIZE) {
-                _buffer[_buffer_size] = sbuf[i];
-                _buffer_size++;
-            }
-            flushbuffer();
-        } else if (isPrintable (char(sbuf[i]) ))  {
-            if (_buffer_size < ESP3D_SERIAL_BUFFER_SIZE) {
-                _buffer[_buffer_size] = sbuf[i];
-                _buffer_size++;
-            } else {
-                flushbuffer();
-                _buffer[_buffer_size] = sbuf[i];
-                _buffer_size++;
-            }
-        } else { //it is not printable char
-            //clean buffer first
-            if (_buffer_size > 0) {
-                flushbuffer();
-            }
-            //process char
-            _buffer[_buffer_size] = sbuf[i];
-            _buffer_size++;
+    while ((len > 0) && _started) {
+        if (_buffer_size == ESP3D_SERIAL_BUFFER_SIZE) {
             flushbuffer();
         }
+        size_t count = ESP3D_SERIAL_BUFFER_SIZE - _buffer_size;
+        if (count > len) {
+            count = len;
+        }
+        memcpy(&_buffer[_buffer_size], sbuf, count);
+        sbuf += count;
+        len -= count;
+        _lastflush = millis();
+        _scanLines(_buffer_size, _buffer_size + count);
     }
 #endif
 }
@@ -460,49 +596,106 @@ long SerialService::baudRate()
     return br;
 }
 
-size_t SerialService::write(uint8_t c)
+void SerialService::resetTxStats()
 {
-    if (!_started) {
-        return 0;
+    _txHighWater = 0;
+    _txDropped = 0;
+}
+
+//Move queued data to UART as long as it has room, never wait
+void SerialService::_sendQueue()
+{
+    while (_txSize > 0) {
+        size_t room = Serials[_serialIndex]->availableForWrite();
+        size_t count = ESP3D_SERIAL_TX_QUEUE_SIZE - _txStart;
+        if (count > _txSize) {
+            count = _txSize;
+        }
+        if (count > room) {
+            count = room;
+        }
+        if (count == 0) {
+            return;
+        }
+        count = Serials[_serialIndex]->write(&_txQueue[_txStart], count);
+        if (count == 0) {
+            return;
+        }
+        _txStart = (_txStart + count) % ESP3D_SERIAL_TX_QUEUE_SIZE;
+        _txSize -= count;
     }
-    return Serials[_serialIndex]->write(c);
+    _txStart = 0;
 }
 
+size_t SerialService::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+//Never wait: data go to UART if nothing is queued, otherwise to queue
+//Data are accepted all or nothing, so a line is never cut, unless they
+//are bigger than queue; the accepted size is returned
 size_t SerialService::write(const uint8_t *buffer, size_t size)
 {
-    if (!_started) {
+    if (!_started || (size == 0)) {
         return 0;
     }
-    if ((uint)Serials[_serialIndex]->availableForWrite() >= size) {
-        return Serials[_serialIndex]->write(buffer, size);
-    } else {
-        size_t sizetosend = size;
-        size_t sizesent = 0;
-        uint8_t *buffertmp=(uint8_t *)buffer;
-        uint32_t starttime = millis();
-        //loop until all is sent or timeout
-        while (sizetosend>0 && ((millis() - starttime) < 100)) {
-            size_t available = Serials[_serialIndex]->availableForWrite();
-            if(available>0) {
-                //in case less is sent
-                available = Serials[_serialIndex]->write(&buffertmp[sizesent], (available >= sizetosend)?sizetosend:available);
-                sizetosend-=available;
-                sizesent+=available;
-                starttime=millis();
-            } else {
-                Hal::wait(5);
-            }
+    TX_LOCK(0);
+    //older data first
+    _sendQueue();
+    size_t direct = 0;
+    if (_txSize == 0) {
+        direct = Serials[_serialIndex]->availableForWrite();
+    }
+    size_t room = direct + (ESP3D_SERIAL_TX_QUEUE_SIZE - _txSize);
+    size_t accepted = size;
+    if (size > room) {
+        if (size <= ESP3D_SERIAL_TX_QUEUE_SIZE) {
+            //may fit later, caller can retry
+            _txDropped += size;
+            log_esp3d("Serial TX full, %d bytes refused", size);
+            return 0;
         }
-        return sizesent;
+        accepted = room;
+        _txDropped += size - room;
+    }
+    size_t sent = 0;
+    if (direct > 0) {
+        sent = Serials[_serialIndex]->write(buffer, (accepted < direct)?accepted:direct);
+    }
+    //queue the rest
+    size_t count = accepted - sent;
+    if (count > (ESP3D_SERIAL_TX_QUEUE_SIZE - _txSize)) {
+        //UART took less than announced
+        _txDropped += count - (ESP3D_SERIAL_TX_QUEUE_SIZE - _txSize);
+        count = ESP3D_SERIAL_TX_QUEUE_SIZE - _txSize;
+        accepted = sent + count;
+    }
+    size_t pos = (_txStart + _txSize) % ESP3D_SERIAL_TX_QUEUE_SIZE;
+    size_t first = ESP3D_SERIAL_TX_QUEUE_SIZE - pos;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&_txQueue[pos], &buffer[sent], first);
+    memcpy(_txQueue, &buffer[sent + first], count - first);
+    _txSize += count;
+    if (_txSize > _txHighWater) {
+        _txHighWater = _txSize;
     }
+    return accepted;
 }
 
+//Room for a write to be accepted, it is how backpressure is seen by callers
 int SerialService::availableForWrite()
 {
     if (!_started) {
         return 0;
     }
-    return Serials[_serialIndex]->availableForWrite();
+    size_t room = ESP3D_SERIAL_TX_QUEUE_SIZE - _txSize;
+    if (_txSize == 0) {
+        room += Serials[_serialIndex]->availableForWrite();
+    }
+    return room;
 }
 
 int SerialService::available()
@@ -529,11 +722,28 @@ size_t SerialService::readBytes(uint8_t * sbuf, size_t len)
     return Serials[_serialIndex]->readBytes(sbuf, len);
 }
 
+//Queue is not waited for, only what is already in UART
 void SerialService::flush()
 {
     if (!_started) {
         return ;
     }
+    //queue is drained at UART pace, lock is released between tries so serial task can read
+    uint32_t start = millis();
+    while (true) {
+        {
+            TX_LOCK();
+            _sendQueue();
+            if (_txSize == 0) {
+                break;
+            }
+        }
+        if ((millis() - start) > TIMEOUT_SERIAL_FLUSH) {
+            log_esp3d("Serial flush timeout, %d bytes pending", _txSize);
+            break;
+        }
+        Hal::wait(0);
+    }
     Serials[_serialIndex]->flush();
 }
 
@@ -24,6 +24,18 @@
 #include "Print.h"
 
 #define ESP3D_SERIAL_BUFFER_SIZE 1024
+//MKS frames are decoded byte per byte from chunks of this size
+#define ESP3D_SERIAL_RX_CHUNK 128
+
+//Output waiting for the UART, writes never wait:
+//data which cannot be queued are refused and counted as dropped
+#ifndef ESP3D_SERIAL_TX_QUEUE_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define ESP3D_SERIAL_TX_QUEUE_SIZE 2048
+#else
+#define ESP3D_SERIAL_TX_QUEUE_SIZE 1024
+#endif //ARDUINO_ARCH_ESP32
+#endif //ESP3D_SERIAL_TX_QUEUE_SIZE
 
 class SerialService : public Print {
  public:
@@ -54,6 +66,11 @@ class SerialService : public Print {
   int read();
   size_t readBytes(uint8_t *sbuf, size_t len);
   inline bool started() { return _started; }
+  // TX queue statistics
+  size_t txQueued() { return _txSize; }
+  size_t txHighWater() { return _txHighWater; }
+  uint32_t txDropped() { return _txDropped; }
+  void resetTxStats();
 
  private:
   uint8_t _serialIndex;
@@ -68,6 +85,18 @@ class SerialService : public Print {
   size_t _buffer_size;
   void push2buffer(uint8_t *sbuf, size_t len);
   void flushbuffer();
+  void _scanLines(size_t start, size_t end);
+  void _processLine(size_t start, size_t len);
+  uint8_t _txQueue[ESP3D_SERIAL_TX_QUEUE_SIZE];
+  size_t _txStart;
+  size_t _txSize;
+  size_t _txHighWater;
+  uint32_t _txDropped;
+#if defined(ARDUINO_ARCH_ESP32)
+  // serial task and main loop may write at same time
+  SemaphoreHandle_t _txMutex;
+#endif  // ARDUINO_ARCH_ESP32
+  void _sendQueue();
 };
 
 extern SerialService serial_service;
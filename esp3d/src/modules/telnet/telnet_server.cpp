@@ -32,10 +32,105 @@ Telnet_Server telnet_server;
 
 #define TIMEOUT_TELNET_FLUSH 1500
 
+#if defined(ARDUINO_ARCH_ESP32)
+//WiFiClient::write waits when socket is full, so check it can take data first
+static bool socketWritable(WiFiClient & client)
+{
+    int fd = client.fd();
+    if (fd < 0) {
+        return false;
+    }
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    struct timeval tv = {0, 0};
+    return select(fd + 1, NULL, &set, NULL, &tv) > 0;
+}
+#endif //ARDUINO_ARCH_ESP32
+
 void Telnet_Server::closeClient()
 {
-    if(_telnetClients) {
-        _telnetClients.stop();
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        _closeClient(i);
+    }
+}
+
+bool Telnet_Server::_isClientConnected(uint8_t index)
+{
+    return _clients[index].txQueue && _clients[index].client && _clients[index].client.connected();
+}
+
+bool Telnet_Server::_openClient(uint8_t index)
+{
+    esp3d_telnet_client_t & c = _clients[index];
+    c.txQueue = (uint8_t *)malloc(ESP3D_TELNET_TX_QUEUE_SIZE);
+    if (!c.txQueue) {
+        return false;
+    }
+    if (!_isdebug) {
+        c.rxBuffer = (uint8_t *)malloc(ESP3D_TELNET_BUFFER_SIZE +1);
+        if (!c.rxBuffer) {
+            free(c.txQueue);
+            c.txQueue = nullptr;
+            return false;
+        }
+    }
+    c.rxSize = 0;
+    c.lastRx = millis();
+    c.txStart = 0;
+    c.txSize = 0;
+    c.dropped = 0;
+    return true;
+}
+
+void Telnet_Server::_closeClient(uint8_t index)
+{
+    esp3d_telnet_client_t & c = _clients[index];
+    if (c.client) {
+        c.client.stop();
+    }
+    if (c.dropped > 0) {
+        log_esp3d("Telnet client %d dropped %d bytes", index, c.dropped);
+    }
+    if (c.rxBuffer) {
+        free(c.rxBuffer);
+        c.rxBuffer = nullptr;
+    }
+    if (c.txQueue) {
+        free(c.txQueue);
+        c.txQueue = nullptr;
+    }
+    c.rxSize = 0;
+    c.txStart = 0;
+    c.txSize = 0;
+    c.dropped = 0;
+}
+
+void Telnet_Server::_acceptClients()
+{
+    //release sessions closed by remote
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        if (_clients[i].txQueue && !_isClientConnected(i)) {
+            _closeClient(i);
+        }
+    }
+    //check if there are any new clients
+    while (_telnetserver->hasClient()) {
+        //find free spot
+        uint8_t i = 0;
+        while ((i < ESP3D_TELNET_MAX_CLIENTS) && _clients[i].txQueue) {
+            i++;
+        }
+        if ((i == ESP3D_TELNET_MAX_CLIENTS) || !_openClient(i)) {
+            //no free spot or no memory so reject
+            _telnetserver->available().stop();
+            log_esp3d("Telnet client rejected");
+        } else {
+            //new client
+            _clients[i].client = _telnetserver->available();
+            _clients[i].client.setNoDelay(true);
+            log_esp3d("Telnet client %d connected", i);
+        }
     }
 }
 
@@ -44,30 +139,48 @@ bool Telnet_Server::isConnected()
     if ( !_started || _telnetserver == NULL) {
         return false;
     }
-    //check if there are any new clients
-    if (_telnetserver->hasClient()) {
-        //find free/disconnected spot
-        if (!_telnetClients || !_telnetClients.connected()) {
-            if(_telnetClients) {
-                _telnetClients.stop();
+    _acceptClients();
+    return clientsCount() > 0;
+}
+
+uint8_t Telnet_Server::clientsCount()
+{
+    uint8_t count = 0;
+    if (_started) {
+        for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+            if (_isClientConnected(i)) {
+                count++;
             }
-            _telnetClients = _telnetserver->available();
-            //new client
         }
     }
-    if (_telnetserver->hasClient()) {
-        //no free/disconnected spot so reject
-        _telnetserver->available().stop();
+    return count;
+}
+
+uint32_t Telnet_Server::droppedBytes()
+{
+    uint32_t count = 0;
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        count += _clients[i].dropped;
     }
-    return _telnetClients.connected();
+    return count;
 }
 
 const char* Telnet_Server::clientIPAddress()
 {
     static String res;
-    res = "0.0.0.0";
-    if (_telnetClients && _telnetClients.connected()) {
-        res = _telnetClients.remoteIP().toString();
+    res = "";
+    if (_started) {
+        for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+            if (_isClientConnected(i)) {
+                if (res.length() > 0) {
+                    res += ", ";
+                }
+                res += _clients[i].client.remoteIP().toString();
+            }
+        }
+    }
+    if (res.length() == 0) {
+        res = "0.0.0.0";
     }
     return res.c_str();
 }
@@ -75,12 +188,19 @@ const char* Telnet_Server::clientIPAddress()
 
 Telnet_Server::Telnet_Server()
 {
-    _buffer_size = 0;
     _started = false;
     _isdebug = false;
     _port = 0;
-    _buffer = nullptr;
+    _replyClient = -1;
     _telnetserver = nullptr;
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        _clients[i].rxBuffer = nullptr;
+        _clients[i].txQueue = nullptr;
+        _clients[i].rxSize = 0;
+        _clients[i].txStart = 0;
+        _clients[i].txSize = 0;
+        _clients[i].dropped = 0;
+    }
 }
 Telnet_Server::~Telnet_Server()
 {
@@ -103,12 +223,6 @@ bool Telnet_Server::begin(uint16_t port, bool debug)
         _port = port;
     }
     _isdebug = debug;
-    if (!_isdebug) {
-        _buffer= (uint8_t *)malloc(ESP3D_TELNET_BUFFER_SIZE +1);
-        if (!_buffer) {
-            return false;
-        }
-    }
     //create instance
     _telnetserver= new WiFiServer(_port);
     if (!_telnetserver) {
@@ -118,7 +232,6 @@ bool Telnet_Server::begin(uint16_t port, bool debug)
     //start telnet server
     _telnetserver->begin();
     _started = true;
-    _lastflush = millis();
     return _started;
 }
 /**
@@ -127,19 +240,14 @@ bool Telnet_Server::begin(uint16_t port, bool debug)
 void Telnet_Server::end()
 {
     _started = false;
-    _buffer_size = 0;
     _port = 0;
     _isdebug = false;
+    _replyClient = -1;
     closeClient();
     if (_telnetserver) {
         delete _telnetserver;
         _telnetserver = nullptr;
     }
-
-    if (_buffer) {
-        free(_buffer);
-        _buffer = nullptr;
-    }
 }
 
 /**
@@ -159,79 +267,151 @@ bool Telnet_Server::started()
 void Telnet_Server::handle()
 {
     Hal::wait(0);
-    if (isConnected()) {
-        //check clients for data
-        size_t len = _telnetClients.available();
+    if (!isConnected()) {
+        return;
+    }
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        if (!_isClientConnected(i)) {
+            continue;
+        }
+        esp3d_telnet_client_t & c = _clients[i];
+        //send pending output
+        _sendQueue(i);
+        //check client for data
+        size_t len = c.client.available();
         if(len > 0) {
             //if yes read them
             uint8_t * sbuf = (uint8_t *)malloc(len);
             if(sbuf) {
-                size_t count = _telnetClients.read(sbuf, len);
+                size_t count = c.client.read(sbuf, len);
                 //push to buffer
                 if (count > 0) {
-                    push2buffer(sbuf, count);
+                    push2buffer(i, sbuf, count);
                 }
                 //free buffer
                 free(sbuf);
             }
         }
-
-    }
-    //we cannot left data in buffer too long
-    //in case some commands "forget" to add \n
-    if (((millis() - _lastflush) > TIMEOUT_TELNET_FLUSH) && (_buffer_size > 0)) {
-        flushbuffer();
+        //we cannot left data in buffer too long
+        //in case some commands "forget" to add \n
+        if (((millis() - c.lastRx) > TIMEOUT_TELNET_FLUSH) && (c.rxSize > 0)) {
+            flushbuffer(i);
+        }
     }
 }
 
-void Telnet_Server::flushbuffer()
+void Telnet_Server::flushbuffer(uint8_t index)
 {
-    if (!_buffer || !_started) {
-        _buffer_size = 0;
+    esp3d_telnet_client_t & c = _clients[index];
+    if (!c.rxBuffer || !_started) {
+        c.rxSize = 0;
         return;
     }
     ESP3DOutput output(ESP_TELNET_CLIENT);
-    _buffer[_buffer_size] = 0x0;
-    //dispatch command
-    esp3d_commands.process(_buffer, _buffer_size, &output);
-    _lastflush = millis();
-    _buffer_size = 0;
+    c.rxBuffer[c.rxSize] = 0x0;
+    //dispatch command, direct answers only go to this session
+    _replyClient = index;
+    esp3d_commands.process(c.rxBuffer, c.rxSize, &output);
+    _replyClient = -1;
+    c.lastRx = millis();
+    c.rxSize = 0;
 }
 
-void Telnet_Server::push2buffer(uint8_t * sbuf, size_t len)
+void Telnet_Server::push2buffer(uint8_t index, uint8_t * sbuf, size_t len)
 {
-    if (!_buffer) {
-        return;
-    }
+    esp3d_telnet_client_t & c = _clients[index];
     for (size_t i = 0; i < len; i++) {
-        _lastflush = millis();
+        //session may be closed by a command
+        if (!c.rxBuffer) {
+            return;
+        }
+        c.lastRx = millis();
         //command is defined
         if ((char(sbuf[i]) == '\n') || (char(sbuf[i]) == '\r')) {
-            if (_buffer_size < ESP3D_TELNET_BUFFER_SIZE) {
-                _buffer[_buffer_size] = sbuf[i];
-                _buffer_size++;
+            if (c.rxSize < ESP3D_TELNET_BUFFER_SIZE) {
+                c.rxBuffer[c.rxSize] = sbuf[i];
+                c.rxSize++;
             }
-            flushbuffer();
+            flushbuffer(index);
         } else if (isPrintable (char(sbuf[i]) )) {
-            if (_buffer_size < ESP3D_TELNET_BUFFER_SIZE) {
-                _buffer[_buffer_size] = sbuf[i];
-                _buffer_size++;
+            if (c.rxSize < ESP3D_TELNET_BUFFER_SIZE) {
+                c.rxBuffer[c.rxSize] = sbuf[i];
+                c.rxSize++;
             } else {
-                flushbuffer();
-                _buffer[_buffer_size] = sbuf[i];
-                _buffer_size++;
+                flushbuffer(index);
+                if (c.rxBuffer) {
+                    c.rxBuffer[c.rxSize] = sbuf[i];
+                    c.rxSize++;
+                }
             }
         } else { //it is not printable char
             //clean buffer first
-            if (_buffer_size > 0) {
-                flushbuffer();
+            if (c.rxSize > 0) {
+                flushbuffer(index);
+                if (!c.rxBuffer) {
+                    return;
+                }
             }
             //process char
-            _buffer[_buffer_size] = sbuf[i];
-            _buffer_size++;
-            flushbuffer();
+            c.rxBuffer[c.rxSize] = sbuf[i];
+            c.rxSize++;
+            flushbuffer(index);
+        }
+    }
+}
+
+//Copy data to session ring buffer, what does not fit is dropped
+size_t Telnet_Server::_queue(uint8_t index, const uint8_t * buffer, size_t size)
+{
+    esp3d_telnet_client_t & c = _clients[index];
+    size_t free_space = ESP3D_TELNET_TX_QUEUE_SIZE - c.txSize;
+    size_t count = (size > free_space)?free_space:size;
+    if (count < size) {
+        c.dropped += size - count;
+    }
+    size_t pos = (c.txStart + c.txSize) % ESP3D_TELNET_TX_QUEUE_SIZE;
+    size_t first = ESP3D_TELNET_TX_QUEUE_SIZE - pos;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&c.txQueue[pos], buffer, first);
+    memcpy(c.txQueue, &buffer[first], count - first);
+    c.txSize += count;
+    return count;
+}
+
+//Send what the socket can take without waiting
+void Telnet_Server::_sendQueue(uint8_t index)
+{
+    esp3d_telnet_client_t & c = _clients[index];
+    while (c.txSize > 0) {
+#ifdef ARDUINO_ARCH_ESP32
+        if (!socketWritable(c.client)) {
+            return;
+        }
+        size_t room = 128; //hard code for esp32
+#endif //ARDUINO_ARCH_ESP32
+#ifdef ARDUINO_ARCH_ESP8266
+        size_t room = c.client.availableForWrite();
+#endif //ARDUINO_ARCH_ESP8266
+        size_t count = ESP3D_TELNET_TX_QUEUE_SIZE - c.txStart;
+        if (count > c.txSize) {
+            count = c.txSize;
+        }
+        if (count > room) {
+            count = room;
         }
+        if (count == 0) {
+            return;
+        }
+        count = c.client.write(&c.txQueue[c.txStart], count);
+        if (count == 0) {
+            return;
+        }
+        c.txStart = (c.txStart + count) % ESP3D_TELNET_TX_QUEUE_SIZE;
+        c.txSize -= count;
     }
+    c.txStart = 0;
 }
 
 size_t Telnet_Server::write(uint8_t c)
@@ -239,53 +419,65 @@ size_t Telnet_Server::write(uint8_t c)
     return write(&c,1);
 }
 
+//Answer of a command only goes to the session which sent it
 size_t Telnet_Server::write(const uint8_t *buffer, size_t size)
 {
-    if (isConnected() && (size>0) && _started) {
-        if ((size_t)availableForWrite() >= size) {
-            //push data to connected telnet client
-            return _telnetClients.write(buffer, size);
-        } else {
-            size_t sizetosend = size;
-            size_t sizesent = 0;
-            uint8_t *buffertmp=(uint8_t *)buffer;
-            uint32_t starttime = millis();
-            //loop until all is sent or timeout
-            while (sizetosend>0 && ((millis() - starttime) < 100)) {
-                size_t available = availableForWrite();
-                if(available>0) {
-                    //in case less is sent
-                    available = _telnetClients.write(&buffertmp[sizesent], (available >= sizetosend)?sizetosend:available);
-                    sizetosend-=available;
-                    sizesent+=available;
-                    starttime=millis();
-                } else {
-                    Hal::wait(5);
-                }
-            }
-            return sizesent;
+    return _write(buffer, size, _replyClient);
+}
+
+//Data for every session, like printer output
+size_t Telnet_Server::broadcast(const uint8_t *buffer, size_t size)
+{
+    return _write(buffer, size, -1);
+}
+
+//Never wait for a client: data are queued for each session and sent when possible
+size_t Telnet_Server::_write(const uint8_t *buffer, size_t size, int8_t target)
+{
+    if (!isConnected() || (size == 0)) {
+        return 0;
+    }
+    size_t sent = 0;
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        if (!_isClientConnected(i) || ((target != -1) && (target != i))) {
+            continue;
+        }
+        size_t count = _queue(i, buffer, size);
+        if (count > sent) {
+            sent = count;
         }
+        _sendQueue(i);
     }
-    return 0;
+    return sent;
 }
 
+//Space of the session with most room, a stalled session does not throttle others
 int Telnet_Server::availableForWrite()
 {
     if (!isConnected()) {
         return 0;
     }
-#ifdef ARDUINO_ARCH_ESP32
-    return 128; //hard code for esp32
-#endif //ARDUINO_ARCH_ESP32
-#ifdef ARDUINO_ARCH_ESP8266
-    return _telnetClients.availableForWrite();
-#endif //ARDUINO_ARCH_ESP8266
+    size_t room = 0;
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        if (!_isClientConnected(i) || ((_replyClient != -1) && (_replyClient != i))) {
+            continue;
+        }
+        size_t free_space = ESP3D_TELNET_TX_QUEUE_SIZE - _clients[i].txSize;
+        if (free_space > room) {
+            room = free_space;
+        }
+    }
+    return room;
 }
 
 int Telnet_Server::available()
 {
     if(isConnected()) {
-        return _telnetClients.available();
+        for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+            if (_isClientConnected(i) && (_clients[i].client.available() > 0)) {
+                return _clients[i].client.available();
+            }
+        }
     }
     return 0;
 }
@@ -293,8 +485,10 @@ int Telnet_Server::available()
 int Telnet_Server::read(void)
 {
     if(isConnected()) {
-        if(_telnetClients.available() > 0) {
-            return _telnetClients.read();
+        for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+            if (_isClientConnected(i) && (_clients[i].client.available() > 0)) {
+                return _clients[i].client.read();
+            }
         }
     }
     return -1;
@@ -303,8 +497,10 @@ int Telnet_Server::read(void)
 size_t Telnet_Server::readBytes(uint8_t * sbuf, size_t len)
 {
     if(isConnected()) {
-        if(_telnetClients.available() > 0) {
-            return _telnetClients.read(sbuf, len);
+        for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+            if (_isClientConnected(i) && (_clients[i].client.available() > 0)) {
+                return _clients[i].client.read(sbuf, len);
+            }
         }
     }
     return 0;
@@ -313,7 +509,12 @@ size_t Telnet_Server::readBytes(uint8_t * sbuf, size_t len)
 
 void Telnet_Server::flush()
 {
-    _telnetClients.flush();
+    for (uint8_t i = 0; i < ESP3D_TELNET_MAX_CLIENTS; i++) {
+        if (_isClientConnected(i)) {
+            _sendQueue(i);
+            _clients[i].client.flush();
+        }
+    }
 }
 
 #endif //TELNET_FEATURE
@@ -27,6 +27,38 @@ class WiFiClient;
 
 #define ESP3D_TELNET_BUFFER_SIZE 1200
 
+//Max simultaneous telnet sessions
+#ifndef ESP3D_TELNET_MAX_CLIENTS
+#if defined(ARDUINO_ARCH_ESP32)
+#define ESP3D_TELNET_MAX_CLIENTS 4
+#else
+#define ESP3D_TELNET_MAX_CLIENTS 2
+#endif //ARDUINO_ARCH_ESP32
+#endif //ESP3D_TELNET_MAX_CLIENTS
+
+//Output queued for each session, when a session does not read fast enough
+//new data are dropped for this session only
+#ifndef ESP3D_TELNET_TX_QUEUE_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define ESP3D_TELNET_TX_QUEUE_SIZE 2048
+#else
+#define ESP3D_TELNET_TX_QUEUE_SIZE 1024
+#endif //ARDUINO_ARCH_ESP32
+#endif //ESP3D_TELNET_TX_QUEUE_SIZE
+
+typedef struct {
+    WiFiClient client;
+    //command line assembler, not used in debug mode
+    uint8_t * rxBuffer;
+    size_t rxSize;
+    uint32_t lastRx;
+    //output ring buffer
+    uint8_t * txQueue;
+    size_t txStart;
+    size_t txSize;
+    uint32_t dropped;
+} esp3d_telnet_client_t;
+
 class Telnet_Server : public Print
 {
 public:
@@ -41,6 +73,7 @@ public:
     const char* clientIPAddress();
     size_t write(uint8_t c);
     size_t write(const uint8_t *buffer, size_t size);
+    size_t broadcast(const uint8_t *buffer, size_t size);
     inline size_t write(const char * s)
     {
         return write((uint8_t*) s, strlen(s));
@@ -71,17 +104,25 @@ public:
         return _port;
     }
     void closeClient();
+    uint8_t clientsCount();
+    uint32_t droppedBytes();
 private:
     bool _started;
     WiFiServer * _telnetserver;
-    WiFiClient  _telnetClients;
+    esp3d_telnet_client_t _clients[ESP3D_TELNET_MAX_CLIENTS];
+    //session which sent the command being processed, -1 if none
+    int8_t _replyClient;
     uint16_t _port;
     bool _isdebug;
-    uint32_t _lastflush;
-    uint8_t *_buffer;
-    size_t _buffer_size;
-    void push2buffer(uint8_t * sbuf, size_t len);
-    void flushbuffer();
+    void _acceptClients();
+    bool _openClient(uint8_t index);
+    void _closeClient(uint8_t index);
+    bool _isClientConnected(uint8_t index);
+    size_t _write(const uint8_t *buffer, size_t size, int8_t target);
+    size_t _queue(uint8_t index, const uint8_t * buffer, size_t size);
+    void _sendQueue(uint8_t index);
+    void push2buffer(uint8_t index, uint8_t * sbuf, size_t len);
+    void flushbuffer(uint8_t index);
 };
 
 extern Telnet_Server telnet_server;
@@ -36,6 +36,36 @@ ESP_ConfigFile::ESP_ConfigFile(const char * path, TProcessingFunction fn)
     _filename = (char *)malloc(strlen(path)+1);
     strcpy(_filename, path);
     _pfunction = fn;
+    _bufferPos = 0;
+    _bufferSize = 0;
+}
+
+//Read next line from file buffer, refilled by blocks
+//line is cut if longer than LINE_MAX_SIZE
+//return false once end of file is reached
+bool ESP_ConfigFile::readLine(ESP_SDFile & file, char * line)
+{
+    uint8_t pos = 0;
+    while (pos < (LINE_MAX_SIZE-1)) {
+        if (_bufferPos == _bufferSize) {
+            _bufferPos = 0;
+            _bufferSize = file.read(_buffer, CONFIG_FILE_BUFFER_SIZE);
+            //end of file or read error
+            if ((_bufferSize == 0) || (_bufferSize > CONFIG_FILE_BUFFER_SIZE)) {
+                _bufferSize = 0;
+                line[pos] = '\0';
+                return (pos > 0);
+            }
+        }
+        char c = (char)_buffer[_bufferPos++];
+        if ((c =='\n') || (c =='\r')) {
+            break;
+        }
+        line[pos] = c;
+        pos++;
+    }
+    line[pos] = '\0';
+    return true;
 }
 
 bool ESP_ConfigFile::processFile()
@@ -47,48 +77,32 @@ bool ESP_ConfigFile::processFile()
     }
     ESP_SDFile rFile = ESP_SD::open(_filename);
     if (rFile) {
-        bool processing = true;
         char line[LINE_MAX_SIZE+1];
         char section[SECTION_MAX_SIZE+1]; //system / network / services
         char key[KEY_MAX_SIZE+1];
-        uint8_t pos = 0;
-        line[0] = '\0';
         section[0]='\0';
-        while (processing) {
-            //to handle file without endline
-            processing = rFile.available();
-            char c = '\0';
-            if (processing) {
-                c = (char)rFile.read();
-                if (!((c =='\n') || (c =='\r')) && (pos<(LINE_MAX_SIZE-1))) {
-                    line[pos] = c;
-                    pos++;
-                }
-            }
-            if ((c =='\n') || (c =='\r') || !processing || (pos==(LINE_MAX_SIZE-1))) {
-                line[pos] = '\0';
-                char * stmp = trimSpaces(line);
-                if(strlen(stmp)>0) {
-                    //is comment ?
-                    if (!isComment(stmp)) {
-                        //is section ?
-                        if(isSection(stmp)) {
-                            strcpy(section,getSectionName(stmp));
-                        } else {
-                            //is key + value?
-                            if (isValue(stmp) && strlen(section)>0) {
-                                strcpy(key,getKeyName(stmp));
-                                if(_pfunction) {
-                                    if(!_pfunction(section, key, getValue(stmp))) {
-                                        res=false;
-                                    }
+        _bufferPos = 0;
+        _bufferSize = 0;
+        while (readLine(rFile, line)) {
+            char * stmp = trimSpaces(line);
+            if(strlen(stmp)>0) {
+                //is comment ?
+                if (!isComment(stmp)) {
+                    //is section ?
+                    if(isSection(stmp)) {
+                        strcpy(section,getSectionName(stmp));
+                    } else {
+                        //is key + value?
+                        if (isValue(stmp) && strlen(section)>0) {
+                            strcpy(key,getKeyName(stmp));
+                            if(_pfunction) {
+                                if(!_pfunction(section, key, getValue(stmp))) {
+                                    res=false;
                                 }
                             }
                         }
                     }
                 }
-                pos = 0;
-                line[pos] = '\0';
             }
         }
         rFile.close();
@@ -219,42 +233,27 @@ bool ESP_ConfigFile::revokeFile()
     ESP_SDFile rFile = ESP_SD::open(_filename);
     free(filename);
     if (wFile && rFile) {
-        bool processing = true;
         char line[LINE_MAX_SIZE+1];
-        uint8_t pos = 0;
-        line[0] = '\0';
-        while (processing) {
-            processing = rFile.available();
-            char c = '\0';
-            if (processing) {
-                c = (char)rFile.read();
-                if (!((c =='\n') || (c =='\r')) && (pos<(LINE_MAX_SIZE-1))) {
-                    line[pos] = c;
-                    pos++;
-                }
-            }
-            if ((c =='\n') || (c =='\r') || !processing || (pos==(LINE_MAX_SIZE-1))) {
-                line[pos] = '\0';
-                char * stmp = trimSpaces(line);
-                if (strlen(stmp) > 0 ) {
-                    if(sizeof(protectedkeys) > 0) {
-                        bool foundscramble = false;
-                        uint8_t size = sizeof(protectedkeys)/sizeof(char*);
-                        for(uint8_t i = 0; (i < size) && !foundscramble; i++) {
-                            if (isScrambleKey(protectedkeys[i],stmp)) {
-                                strcpy(line, protectedkeys[i]);
-                                strcat(line, "=********");
-                                stmp = line;
-                                foundscramble = true;
-                            }
+        _bufferPos = 0;
+        _bufferSize = 0;
+        while (readLine(rFile, line)) {
+            char * stmp = trimSpaces(line);
+            if (strlen(stmp) > 0 ) {
+                if(sizeof(protectedkeys) > 0) {
+                    bool foundscramble = false;
+                    uint8_t size = sizeof(protectedkeys)/sizeof(char*);
+                    for(uint8_t i = 0; (i < size) && !foundscramble; i++) {
+                        if (isScrambleKey(protectedkeys[i],stmp)) {
+                            strcpy(line, protectedkeys[i]);
+                            strcat(line, "=********");
+                            stmp = line;
+                            foundscramble = true;
                         }
                     }
-                    wFile.write((const uint8_t *)stmp, strlen(stmp));
-                    wFile.write('\r');
-                    wFile.write('\n');
                 }
-                pos = 0;
-                line[pos] = '\0';
+                wFile.write((const uint8_t *)stmp, strlen(stmp));
+                wFile.write('\r');
+                wFile.write('\n');
             }
         }
         wFile.close();
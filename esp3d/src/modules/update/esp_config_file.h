@@ -21,6 +21,11 @@
 #ifndef _ESP_CONFIG_FILE_H
 #define _ESP_CONFIG_FILE_H
 #include <Arduino.h>
+//File is read by blocks of this size
+#ifndef CONFIG_FILE_BUFFER_SIZE
+#define CONFIG_FILE_BUFFER_SIZE 512
+#endif //CONFIG_FILE_BUFFER_SIZE
+class ESP_SDFile;
 typedef std::function<bool(const char*, const char*,const char*)> TProcessingFunction;
 
 class ESP_ConfigFile
@@ -39,8 +44,12 @@ public:
     bool revokeFile();
 private:
     bool isScrambleKey(const char *key, const char * str);
+    bool readLine(ESP_SDFile & file, char * line);
     char * _filename;
     TProcessingFunction _pfunction;
+    uint8_t _buffer[CONFIG_FILE_BUFFER_SIZE];
+    size_t _bufferPos;
+    size_t _bufferSize;
 };
 
 #endif //_ESP_CONFIG_FILE_H
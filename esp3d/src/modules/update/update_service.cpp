@@ -93,14 +93,14 @@ const uint16_t IPKeysPos[] = {ESP_STA_IP_VALUE,
                              } ;
 
 const char * ServintKeysVal[] = {
-    "Serial_Bridge_Baud"
+    "Serial_Bridge_Baud",
     "HTTP_Port",
     "TELNET_Port",
     "SENSOR_INTERVAL",
     "WebSocket_Port",
     "WebDav_Port",
     "FTP_Control_Port",
-    "FTP_Active_Port ",
+    "FTP_Active_Port",
     "FTP_Passive_Port"
 } ;
 
@@ -153,7 +153,7 @@ const uint16_t ServboolKeysPos[] = {ESP_SERIAL_BRIDGE_ON,
 const char * SysboolKeysVal[] = {"Active_Serial_Bridge",
                                  "Active_Remote_Screen",
                                  "Active_ESP3D_Screen",
-                                 "Active_Serial ",
+                                 "Active_Serial",
                                  "Active_WebSocket",
                                  "Active_Telnet",
                                  "Active_BT",
@@ -239,6 +239,50 @@ bool processBool(const char** keysval, const uint16_t * keypos, const size_t siz
 }
 
 
+//Settings are only saved if all entries of file are valid
+//so file is processed twice: once to check, once to save
+static bool saveSettings = false;
+
+//Check parsed value against setting description
+bool isValidSetting(const esp3d_setting_desc_t * setting, char T, const char * value, int32_t n)
+{
+    switch(T) {
+    case 'B':
+    case 'I':
+        if (setting->type != T) {
+            return false;
+        }
+        switch (setting->options) {
+        case SETTING_OPTIONS_LIST: {
+            //list is {"label":"value"},...
+            String tag = "\":\"" + String(n) + "\"}";
+            return strstr(setting->text, tag.c_str()) != nullptr;
+        }
+        //checked by service when used
+        case SETTING_OPTIONS_BAUD:
+        case SETTING_OPTIONS_SENSOR:
+            return n >= 0;
+        default:
+            return (n >= setting->min) && ((int64_t)n <= (int64_t)setting->max);
+        }
+    case 'S': {
+        if (setting->type != 'S') {
+            return false;
+        }
+        size_t len = strlen(value);
+        if ((len == 0) && (setting->flags & SETTING_FLAG_NULLABLE)) {
+            return true;
+        }
+        return (len >= (size_t)setting->min) && (len <= setting->max);
+    }
+    case 'A': {
+        IPAddress ip;
+        return (setting->type == 'A') && ip.fromString(value);
+    }
+    default:
+        return false;
+    }
+}
 
 //Parsing all entries of file once is faster that checking all possible parameters for each line of file
 bool processingFileFunction (const char * section, const char * key, const char * value)
@@ -249,6 +293,7 @@ bool processingFileFunction (const char * section, const char * key, const char
     uint32_t v = 0;
     byte b = 0;
     bool done=false;
+    bool fromInt = false;
     log_esp3d("[%s]%s=%s",section, key,value);
     //network / services / system sections
     if (strcasecmp("network",section)==0) {
@@ -266,6 +311,7 @@ bool processingFileFunction (const char * section, const char * key, const char
             if(done) {
                 T='B';
                 b=v;
+                fromInt = true;
             }
         }
         //Radio mode BT, WIFI-STA, WIFI-AP, ETH-STA, OFF
@@ -317,7 +363,7 @@ bool processingFileFunction (const char * section, const char * key, const char
                 done = true;
                 if (strcasecmp("DHCP",value)==0) {
                     b=DHCP_MODE;
-                } else if (strcasecmp("STATIC",key)==0) {
+                } else if (strcasecmp("STATIC",value)==0) {
                     b=STATIC_IP_MODE;
                 } else {
                     P=-1;    //invalide value
@@ -339,6 +385,7 @@ bool processingFileFunction (const char * section, const char * key, const char
             if(done) {
                 T='B';
                 b=v;
+                fromInt = true;
             }
         }
         //Notification type None / PushOver / Line / Email / Telegram / IFTTT
@@ -372,15 +419,15 @@ bool processingFileFunction (const char * section, const char * key, const char
                 done = true;
                 if (strcasecmp("None",value)==0) {
                     b=NO_SENSOR_DEVICE;
-                } else if (strcasecmp("DHT11",key)==0) {
+                } else if (strcasecmp("DHT11",value)==0) {
                     b=DHT11_DEVICE;
-                } else if (strcasecmp("DHT22",key)==0) {
+                } else if (strcasecmp("DHT22",value)==0) {
                     b=DHT22_DEVICE;
-                } else if (strcasecmp("ANALOG",key)==0) {
+                } else if (strcasecmp("ANALOG",value)==0) {
                     b=ANALOG_DEVICE;
-                } else if (strcasecmp("BMP280",key)==0) {
+                } else if (strcasecmp("BMP280",value)==0) {
                     b=BMP280_DEVICE;
-                } else if (strcasecmp("BME280",key)==0) {
+                } else if (strcasecmp("BME280",value)==0) {
                     b=BME280_DEVICE;
                 }  else {
                     P=-1;    //invalide value
@@ -417,28 +464,48 @@ bool processingFileFunction (const char * section, const char * key, const char
         }
     }
 
+    //known key with unknown value
+    if (done && (P==-1)) {
+        log_esp3d("Invalid value for %s", key);
+        return false;
+    }
+    if(P==-1) {
+        return true;
+    }
+    const esp3d_setting_desc_t * setting = Settings_ESP3D::get_setting_by_pos(P);
+    if (!setting) {
+        log_esp3d("Setting %s not available", key);
+        return true;
+    }
+    int32_t n = fromInt?(int32_t)v:((setting->flags & SETTING_FLAG_SIGNED)?(int8_t)b:b);
+    if (!isValidSetting(setting, T, value, n)) {
+        log_esp3d("Invalid value for %s", key);
+        return false;
+    }
+    //first pass only check values
+    if (!saveSettings) {
+        return true;
+    }
     //now we save -handle saving status
     //if setting is not recognized it is not a problem
     //but if save is fail - that is a problem - so report it
-    if(P!=-1) {
-        switch(T) {
-        case 'S':
-            log_esp3d("Saving setting to ESP3D");
-            res = Settings_ESP3D::write_string (P, value);
-            break;
-        case 'B':
-        case 'F':
-            res = Settings_ESP3D::write_byte (P, b);
-            break;
-        case 'I':
-            res = Settings_ESP3D::write_uint32 (P, v);
-            break;
-        case 'A':
-            res = Settings_ESP3D::write_IP_String (P, value);
-            break;
-        default:
-            log_esp3d("Unknown flag");
-        }
+    switch(T) {
+    case 'S':
+        log_esp3d("Saving setting to ESP3D");
+        res = Settings_ESP3D::write_string (P, value);
+        break;
+    case 'B':
+    case 'F':
+        res = Settings_ESP3D::write_byte (P, b);
+        break;
+    case 'I':
+        res = Settings_ESP3D::write_uint32 (P, v);
+        break;
+    case 'A':
+        res = Settings_ESP3D::write_IP_String (P, value);
+        break;
+    default:
+        log_esp3d("Unknown flag");
     }
     return res;
 }
@@ -446,6 +513,42 @@ bool processingFileFunction (const char * section, const char * key, const char
 UpdateService::UpdateService() {}
 UpdateService::~UpdateService() {}
 
+//Optional checksum of update: same name with .md5 extension, containing the 32 hex digits
+//md5 gets them, or is empty if there is no such file
+bool UpdateService::readMD5(const char * filename, char * md5)
+{
+    String md5Name = filename;
+    md5Name.replace(".bin", ".md5");
+    md5[0] = 0;
+    if (!ESP_SD::exists (md5Name.c_str())) {
+        return true;
+    }
+    bool res = false;
+    ESP_SDFile md5file = ESP_SD::open(md5Name.c_str());
+    if (md5file) {
+        size_t len = md5file.read((uint8_t *)md5, 32);
+        if (len > 32) {
+            len = 0;
+        }
+        md5[len] = 0;
+        md5file.close();
+        res = (len == 32);
+        for (uint8_t i = 0; res && (i < 32); i++) {
+            res = isxdigit(md5[i]);
+        }
+        if (res) {
+            log_esp3d("Expected MD5 %s", md5);
+        }
+    }
+    if (!res) {
+        md5[0] = 0;
+        log_esp3d("Invalid MD5 file");
+    }
+    //checksum only applies to this update
+    ESP_SD::remove(md5Name.c_str());
+    return res;
+}
+
 bool  UpdateService::flash(const char * filename, int type)
 {
     bool res = false;
@@ -453,22 +556,54 @@ bool  UpdateService::flash(const char * filename, int type)
         log_esp3d("Update found");
         bool issucess = false;
         ESP_SDFile sdfile;
+        char md5[33];
         String finalName = filename;
+        ESP3DOutput output(ESP_ALL_CLIENTS);
         sdfile = ESP_SD::open(filename);
         if(sdfile) {
             size_t s = sdfile.size();
             size_t rs = 0;
-            uint8_t v[1] ;
-            if(Update.begin(s, type)) {
+            uint8_t lastProgress = 0;
+            //whole sectors so flash is written once per block
+            uint8_t * buffer = (uint8_t *)malloc(ESP_SD_UPDATE_BLOCK_SIZE);
+            if (!buffer) {
+                log_esp3d("Cannot allocate update buffer");
+            } else if(readMD5(filename, md5) && Update.begin(s, type)) {
                 log_esp3d("Update started");
-                while (sdfile.available() && (rs <= (s+1))) {
-                    rs++;
-                    v[0]=sdfile.read();
-                    Update.write(v,1);
+                //begin() clears expected MD5, so it is set after, value was checked when read
+                if (md5[0] != 0) {
+                    Update.setMD5(md5);
+                }
+#if COMMUNICATION_PROTOCOL != MKS_SERIAL
+                output.printMSG("Update 0%");
+#endif //COMMUNICATION_PROTOCOL != MKS_SERIAL
+                while (rs < s) {
+                    size_t len = sdfile.read(buffer, ESP_SD_UPDATE_BLOCK_SIZE);
+                    if ((len == 0) || (len > ESP_SD_UPDATE_BLOCK_SIZE)) {
+                        log_esp3d("Read failed");
+                        break;
+                    }
+                    if (Update.write(buffer, len) != len) {
+                        log_esp3d("Write failed");
+                        break;
+                    }
+                    rs += len;
+                    //every 10% is enough for serial output
+                    uint8_t progress = (100ULL * rs) / s;
+                    if ((progress / 10) != (lastProgress / 10)) {
+                        lastProgress = progress;
+#if COMMUNICATION_PROTOCOL != MKS_SERIAL
+                        String msg = "Update ";
+                        msg += String(progress);
+                        msg += "%";
+                        output.printMSG(msg.c_str());
+#endif //COMMUNICATION_PROTOCOL != MKS_SERIAL
+                    }
                     Hal::wait(0);
                 }
                 if (rs==s) {
                     log_esp3d("Update done");
+                    //MD5 is checked here if any
                     if(Update.end(true)) {
                         log_esp3d("Update success");
                         issucess = true;
@@ -477,7 +612,13 @@ bool  UpdateService::flash(const char * filename, int type)
                     Update.end();
                     log_esp3d("Wrong size");
                 }
+#if COMMUNICATION_PROTOCOL != MKS_SERIAL
+                if (!issucess) {
+                    output.printERROR("Update failed!");
+                }
+#endif //COMMUNICATION_PROTOCOL != MKS_SERIAL
             }
+            free(buffer);
             sdfile.close();
         } else {
             log_esp3d("Cannot open file");
@@ -513,7 +654,22 @@ bool UpdateService::begin()
             if(ESP_SD::getState(true) != ESP_SDCARD_NOT_PRESENT) {
                 ESP_SD::setState(ESP_SDCARD_BUSY );
                 ESP_ConfigFile updateConfig(CONFIG_FILE, processingFileFunction);
-                if (updateConfig.processFile()) {
+                saveSettings = false;
+                bool processed = updateConfig.processFile();
+                if (processed) {
+                    log_esp3d("Checking ini file done");
+                    saveSettings = true;
+                    processed = updateConfig.processFile();
+                    saveSettings = false;
+                    //save all settings at once, or none if one failed
+                    if (!processed) {
+                        log_esp3d("Saving ini file failed, settings not changed");
+                        Settings_ESP3D::discard();
+                    } else if (!Settings_ESP3D::commit()) {
+                        processed = false;
+                    }
+                }
+                if (processed) {
                     log_esp3d("Processing ini file done");
                     if(updateConfig.revokeFile()) {
                         log_esp3d("Revoking ini file done");
@@ -21,6 +21,10 @@
 #ifndef _UPDATE_SERVICES_H
 #define _UPDATE_SERVICES_H
 
+//Size of blocks read from SD and written to flash, flash sector size is 4096
+#ifndef ESP_SD_UPDATE_BLOCK_SIZE
+#define ESP_SD_UPDATE_BLOCK_SIZE 4096
+#endif //ESP_SD_UPDATE_BLOCK_SIZE
 
 class UpdateService
 {
@@ -33,6 +37,7 @@ public:
 
 private:
     bool flash(const char * filename, int type);
+    bool readMD5(const char * filename, char * md5);
 };
 
 extern UpdateService update_service;
@@ -34,7 +34,10 @@
 #include <time.h>
 
 #include "ESPWebDAV.h"
-
+#include "../filesystem/esp_read_pipeline.h"
+#if defined(ESP_BENCHMARK_FEATURE)
+#include "../../core/benchmark.h"
+#endif  // ESP_BENCHMARK_FEATURE
 
 #if defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266WiFi.h>
@@ -887,33 +890,62 @@ void ESPWebDAVCore::handleGet(ResourceType resource, WebDavFile& file,
         transferStatusFn(file.name(), 0, false);
       }
       int percent = 0;
-
-      while (remaining > 0 && file.available()) {
-        size_t toRead =
-            (size_t)remaining > sizeof(buf) ? sizeof(buf) : remaining;
-        size_t numRead = file.read((uint8_t*)buf, toRead);
+#if defined(ESP_BENCHMARK_FEATURE)
+      uint64_t bench_start = millis();
+      size_t bench_transfered = 0;
+#endif  // ESP_BENCHMARK_FEATURE
+      // file belongs to reader task once pipeline is started, so progress
+      // uses a copy of its name and the size read before
+      String name = file.name();
+      // next block is read from file while current one is sent
+      ESP_ReadPipeline pipeline;
+      ESP_ReadPipeline::reader_t reader = [&file](uint8_t* rbuf, size_t size) {
+        return (int)file.read(rbuf, size);
+      };
+      if (!pipeline.begin(reader, remaining)) {
+        log_esp3d("no memory for file pipeline");
+        remaining = 0;
+      }
+#if defined(ESP_BENCHMARK_FEATURE)
+      bool pipelined = pipeline.isPipelined();
+#endif  // ESP_BENCHMARK_FEATURE
+
+      while (remaining > 0) {
+        size_t numRead = 0;
+        const uint8_t* block = pipeline.next(numRead);
+        if (!block) {
+          break;
+        }
         log_esp3d("read %d bytes from file", (int)numRead);
 
-        if (client->write(buf, numRead) != numRead) {
+        if (client->write(block, numRead) != numRead) {
           log_esp3d("file->net short transfer");
           break;
         }
+#if defined(ESP_BENCHMARK_FEATURE)
+        bench_transfered += numRead;
+#endif  // ESP_BENCHMARK_FEATURE
 
 #if defined(ESP_DEBUG_FEATURE)
         for (size_t i = 0; i < 80 && i < numRead; i++) {
-          log_esp3ds("%c", buf[i] < 32 || buf[i] > 127 ? '.' : buf[i]);
+          log_esp3ds("%c", block[i] < 32 || block[i] > 127 ? '.' : block[i]);
         }
 #endif
 
         remaining -= numRead;
         if (transferStatusFn) {
-          int p = (100 * (file.size() - remaining)) / file.size();
+          int p = (100 * (fileSize - remaining)) / fileSize;
           if (p != percent) {
-            transferStatusFn(file.name(), percent = p, false);
+            transferStatusFn(name.c_str(), percent = p, false);
           }
         }
         log_esp3d("wrote %d bytes to http client", (int)numRead);
       }
+      pipeline.end();
+#if defined(ESP_BENCHMARK_FEATURE)
+      benchMark(pipelined ? "WebDAV download (pipelined)" : "WebDAV download",
+                bench_start, millis(), bench_transfered);
+#endif  // ESP_BENCHMARK_FEATURE
     }
   }
 
@@ -160,9 +160,37 @@ WebSocket_Server::WebSocket_Server(const char * protocol )
     _current_id = 0;
     _RXbuffer = nullptr;
     _RXbufferSize = 0;
+    _TXbufferSize = 0;
+    _lastTXflush = 0;
+    _TXnewLine = false;
     _protocol = protocol;
+    resetStats();
+}
+
+void WebSocket_Server::resetStats()
+{
+    _TXframes = 0;
+    _TXlatencyTotal = 0;
+    _TXlatencyMax = 0;
+}
 
+#if defined (ESP_WS_DEFLATE_FEATURE)
+uint32_t WebSocket_Server::compressionRatio()
+{
+    if (!_websocket_server || (_websocket_server->deflateInput() == 0)) {
+        return 100;
+    }
+    return ((uint64_t)_websocket_server->deflateOutput() * 100) / _websocket_server->deflateInput();
+}
+
+uint32_t WebSocket_Server::compressionCost()
+{
+    if (!_websocket_server || (_websocket_server->deflateInput() < 1024)) {
+        return 0;
+    }
+    return _websocket_server->deflateTime() / (_websocket_server->deflateInput() / 1024);
 }
+#endif //ESP_WS_DEFLATE_FEATURE
 WebSocket_Server::~WebSocket_Server()
 {
     end();
@@ -181,6 +209,9 @@ bool WebSocket_Server::begin(uint16_t port)
     _websocket_server = new WebSocketsServer(_port,"",_protocol.c_str());
     if (_websocket_server) {
         _websocket_server->begin();
+#if defined (ESP_WS_DEFLATE_FEATURE)
+        _websocket_server->enableDeflate(true);
+#endif //ESP_WS_DEFLATE_FEATURE
 #if defined (HTTP_FEATURE) //terminal websocket for HTTP
         if(port == 0) {
             _websocket_server->onEvent(handle_Websocket_Terminal_Event);
@@ -206,6 +237,8 @@ void WebSocket_Server::end()
 {
     _current_id = 0;
     _TXbufferSize = 0;
+    _TXnewLine = false;
+    resetStats();
     if(_RXbuffer) {
         free(_RXbuffer);
         _RXbuffer = nullptr;
@@ -246,20 +279,29 @@ size_t WebSocket_Server::write(const uint8_t *buffer, size_t size)
         if((buffer == nullptr) ||(!_websocket_server) || (size == 0)) {
             return 0;
         }
-        if (_TXbufferSize==0) {
-            _lastTXflush = millis();
-        }
-        //send full line
-        if (_TXbufferSize + size > TXBUFFERSIZE) {
-            flushTXbuffer();
-        }
         if(_websocket_server->connectedClients() == 0) {
             return 0;
         }
-        //need periodic check to force to flush in case of no end
-        for (uint i = 0; i < size; i++) {
-            _TXbuffer[_TXbufferSize] = buffer[i];
-            _TXbufferSize++;
+        //data bigger than buffer are sent as several frames
+        size_t done = 0;
+        while (done < size) {
+            if (_TXbufferSize == TXBUFFERSIZE) {
+                flushTXbuffer();
+            }
+            if (_TXbufferSize == 0) {
+                _TXbufferStart = millis();
+            }
+            size_t toCopy = TXBUFFERSIZE - _TXbufferSize;
+            if (toCopy > size - done) {
+                toCopy = size - done;
+            }
+            memcpy(&_TXbuffer[_TXbufferSize], &buffer[done], toCopy);
+            _TXbufferSize += toCopy;
+            done += toCopy;
+        }
+        //handle() decides when a line can be sent
+        if ((buffer[size - 1] == '\n') || (buffer[size - 1] == '\r')) {
+            _TXnewLine = true;
         }
         return size;
     }
@@ -322,7 +364,10 @@ void WebSocket_Server::handle()
     Hal::wait(0);
     if (_started) {
         if (_TXbufferSize > 0) {
-            if ((_TXbufferSize>=TXBUFFERSIZE) || ((millis()- _lastTXflush) > FLUSHTIMEOUT)) {
+            uint32_t now = millis();
+            //full, too old, or complete line on an idle link
+            if ((_TXbufferSize >= TXBUFFERSIZE) || ((now - _TXbufferStart) >= ESP_WS_MAX_LATENCY)
+                    || (_TXnewLine && ((now - _lastTXflush) >= ESP_WS_IDLE_DELAY))) {
                 flushTXbuffer();
             }
         }
@@ -354,11 +399,17 @@ void WebSocket_Server::flushTXbuffer(void)
             }
             //refresh timout
             _lastTXflush = millis();
-
+            uint32_t latency = _lastTXflush - _TXbufferStart;
+            _TXframes++;
+            _TXlatencyTotal += latency;
+            if (latency > _TXlatencyMax) {
+                _TXlatencyMax = latency;
+            }
         }
     }
     //reset buffer
     _TXbufferSize = 0;
+    _TXnewLine = false;
 }
 
 
@@ -26,6 +26,15 @@
 #define TXBUFFERSIZE 1200
 #define RXBUFFERSIZE 256
 #define FLUSHTIMEOUT 500
+//Max time in ms output can wait in TX buffer before being sent
+#ifndef ESP_WS_MAX_LATENCY
+#define ESP_WS_MAX_LATENCY 50
+#endif //ESP_WS_MAX_LATENCY
+//No frame sent since this delay in ms: a complete line is sent immediately,
+//otherwise output is coalesced until buffer is full or max latency is reached
+#ifndef ESP_WS_IDLE_DELAY
+#define ESP_WS_IDLE_DELAY 20
+#endif //ESP_WS_IDLE_DELAY
 class WebSocketsServer;
 class WebSocket_Server: public Print
 {
@@ -85,6 +94,26 @@ public:
     {
         return _port;
     }
+    //TX statistics, latency is time spent in TX buffer in ms
+    uint32_t framesSent()
+    {
+        return _TXframes;
+    }
+    uint32_t averageLatency()
+    {
+        return _TXframes?(_TXlatencyTotal / _TXframes):0;
+    }
+    uint32_t maxLatency()
+    {
+        return _TXlatencyMax;
+    }
+    void resetStats();
+#if defined (ESP_WS_DEFLATE_FEATURE)
+    //compressed size in % of original size
+    uint32_t compressionRatio();
+    //compression time in us per KB
+    uint32_t compressionCost();
+#endif //ESP_WS_DEFLATE_FEATURE
 private:
     bool _started;
     uint16_t _port;
@@ -94,6 +123,11 @@ private:
     String _protocol;
     uint8_t _TXbuffer[TXBUFFERSIZE];
     uint16_t _TXbufferSize;
+    uint32_t _TXbufferStart;
+    bool _TXnewLine;
+    uint32_t _TXframes;
+    uint64_t _TXlatencyTotal;
+    uint32_t _TXlatencyMax;
     uint8_t _current_id;
     void flushTXbuffer();
     void flushRXbuffer();
@@ -23,6 +23,9 @@
  */
 
 #include "WebSockets.h"
+#ifdef WEBSOCKETS_DEFLATE
+#include "WebSocketsDeflate.h"
+#endif
 
 #ifdef ESP8266
 #include <core_esp8266_features.h>
@@ -86,8 +89,9 @@ void WebSockets::clientDisconnect(WSclient_t * client, uint16_t code, char * rea
  * @param mask bool             add dummy mask to the frame (needed for web browser)
  * @param maskkey uint8_t[4]    key used for payload
  * @param fin bool              can be used to send data in more then one frame (set fin on the last frame)
+ * @param rsv1 bool             payload is compressed (permessage-deflate)
  */
-uint8_t WebSockets::createHeader(uint8_t * headerPtr, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin)
+uint8_t WebSockets::createHeader(uint8_t * headerPtr, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin, bool rsv1)
 {
     uint8_t headerSize;
     // calculate header Size
@@ -110,6 +114,9 @@ uint8_t WebSockets::createHeader(uint8_t * headerPtr, WSopcode_t opcode, size_t
     if(fin) {
         *headerPtr |= bit(7);    ///< set Fin
     }
+    if(rsv1) {
+        *headerPtr |= bit(6);    ///< set RSV1
+    }
     *headerPtr |= opcode;    ///< set opcode
     headerPtr++;
 
@@ -194,9 +201,10 @@ bool WebSockets::sendFrameHeader(WSclient_t * client, WSopcode_t opcode, size_t
  * @param length size_t         length of the payload
  * @param fin bool              can be used to send data in more then one frame (set fin on the last frame)
  * @param headerToPayload bool  set true if the payload has reserved 14 Byte at the beginning to dynamically add the Header (payload neet to be in RAM!)
+ * @param rsv1 bool             payload is compressed (permessage-deflate)
  * @return true if ok
  */
-bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin, bool headerToPayload)
+bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin, bool headerToPayload, bool rsv1)
 {
     if(client->tcp && !client->tcp->connected()) {
         DEBUG_WEBSOCKETS("[WS][%d][sendFrame] not Connected!?\n", client->num);
@@ -268,7 +276,7 @@ bool WebSockets::sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * pay
         }
     }
 
-    createHeader(headerPtr, opcode, length, client->cIsClient, maskKey, fin);
+    createHeader(headerPtr, opcode, length, client->cIsClient, maskKey, fin, rsv1);
 
     if(client->cIsClient && useInternBuffer) {
         uint8_t * dataMaskPtr;
@@ -484,6 +492,77 @@ void WebSockets::handleWebsocketPayloadCb(WSclient_t * client, bool ok, uint8_t
             }
         }
 
+#ifdef WEBSOCKETS_DEFLATE
+        // compressed message, only its first frame has rsv1, next ones are continuations
+        bool compressed = client->cDeflate && ((header->rsv1 && (header->opCode == WSop_text || header->opCode == WSop_binary)) || (header->opCode == WSop_continuation && client->cDeflateRx));
+        if(compressed) {
+            uint8_t * data = payload;
+            size_t dataLen = header->payloadLen;
+            uint8_t opCode = header->opCode;
+            if(!header->fin || client->cDeflateRx) {
+                // fragments are kept until last one, then inflated as one message
+                size_t total = client->cDeflateRxLen + header->payloadLen;
+                uint8_t * rx = NULL;
+                if(total <= WEBSOCKETS_MAX_DATA_SIZE) {
+                    rx = (uint8_t *)realloc(client->cDeflateRx, total + 1);
+                }
+                if(!rx) {
+                    DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] compressed message too big\n", client->num);
+                    if(payload) {
+                        free(payload);
+                    }
+                    free(client->cDeflateRx);
+                    client->cDeflateRx    = NULL;
+                    client->cDeflateRxLen = 0;
+                    client->cWsRXsize     = 0;
+                    clientDisconnect(client, 1009);
+                    return;
+                }
+                if(header->payloadLen > 0) {
+                    memcpy(rx + client->cDeflateRxLen, payload, header->payloadLen);
+                }
+                if(header->opCode != WSop_continuation) {
+                    client->cDeflateRxOpCode = header->opCode;
+                }
+                client->cDeflateRx    = rx;
+                client->cDeflateRxLen = total;
+                data                  = rx;
+                dataLen               = total;
+                opCode                = client->cDeflateRxOpCode;
+            }
+            size_t inflatedLen = 0;
+            uint8_t * inflated = NULL;
+            if(header->fin) {
+                inflated = WebSocketsDeflate::inflate(data, dataLen, inflatedLen);
+            }
+            if(payload) {
+                free(payload);
+            }
+            if(!header->fin) {
+                // wait for next fragment
+                client->cWsRXsize = 0;
+#if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
+                handleWebsocketWaitFor(client, 2);
+#endif
+                return;
+            }
+            if(client->cDeflateRx) {
+                free(client->cDeflateRx);
+                client->cDeflateRx    = NULL;
+                client->cDeflateRxLen = 0;
+            }
+            if(!inflated) {
+                DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] cannot inflate message\n", client->num);
+                client->cWsRXsize = 0;
+                clientDisconnect(client, 1009);
+                return;
+            }
+            payload            = inflated;
+            header->payloadLen = inflatedLen;
+            header->opCode     = (WSopcode_t)opCode;
+        }
+#endif
+
         switch(header->opCode) {
         case WSop_text:
             DEBUG_WEBSOCKETS("[WS][%d][handleWebsocket] text: %s\n", client->num, payload);
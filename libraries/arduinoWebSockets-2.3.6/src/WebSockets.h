@@ -77,6 +77,11 @@
 #define WEBSOCKETS_YIELD_MORE() delay(1)
 #endif
 
+// permessage-deflate, client messages are inflated by ROM miniz
+#if defined(ESP32) && !defined(WEBSOCKETS_NO_DEFLATE)
+#define WEBSOCKETS_DEFLATE
+#endif
+
 #elif defined(STM32_DEVICE)
 
 #define WEBSOCKETS_MAX_DATA_SIZE (15 * 1024)
@@ -298,6 +303,15 @@ typedef struct {
     String cExtensions;       ///< client Sec-WebSocket-Extensions
     uint16_t cVersion = 0;    ///< client Sec-WebSocket-Version
 
+#ifdef WEBSOCKETS_DEFLATE
+    bool cDeflate               = false;      ///< permessage-deflate negotiated
+    uint8_t * cDeflateHistory   = nullptr;    ///< last bytes sent, NULL if no context takeover
+    uint16_t cDeflateHistoryLen = 0;
+    uint8_t * cDeflateRx        = nullptr;    ///< compressed fragments received so far
+    size_t cDeflateRxLen        = 0;
+    uint8_t cDeflateRxOpCode    = 0;          ///< opcode of first fragment
+#endif
+
     uint8_t cWsRXsize = 0;                            ///< State of the RX
     uint8_t cWsHeader[WEBSOCKETS_MAX_HEADER_SIZE];    ///< RX WS Message buffer
     WSMessageHeader_t cWsHeaderDecode;
@@ -338,9 +352,9 @@ class WebSockets {
 
     virtual void messageReceived(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin) = 0;
 
-    uint8_t createHeader(uint8_t * buf, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin);
+    uint8_t createHeader(uint8_t * buf, WSopcode_t opcode, size_t length, bool mask, uint8_t maskKey[4], bool fin, bool rsv1 = false);
     bool sendFrameHeader(WSclient_t * client, WSopcode_t opcode, size_t length = 0, bool fin = true);
-    bool sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload = NULL, size_t length = 0, bool fin = true, bool headerToPayload = false);
+    bool sendFrame(WSclient_t * client, WSopcode_t opcode, uint8_t * payload = NULL, size_t length = 0, bool fin = true, bool headerToPayload = false, bool rsv1 = false);
 
     void headerDone(WSclient_t * client);
 
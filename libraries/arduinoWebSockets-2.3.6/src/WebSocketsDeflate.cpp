@@ -0,0 +1,245 @@
+/**
+ * @file WebSocketsDeflate.cpp
+ * @date 17.10.2026
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "WebSockets.h"
+
+#ifdef WEBSOCKETS_DEFLATE
+
+#include "WebSocketsDeflate.h"
+
+#if __has_include(<rom/miniz.h>)
+#include <rom/miniz.h>
+#elif CONFIG_IDF_TARGET_ESP32S2
+#include <esp32s2/rom/miniz.h>
+#elif CONFIG_IDF_TARGET_ESP32S3
+#include <esp32s3/rom/miniz.h>
+#elif CONFIG_IDF_TARGET_ESP32C3
+#include <esp32c3/rom/miniz.h>
+#else
+#include <esp32/rom/miniz.h>
+#endif
+
+#define DEFLATE_HASH_BITS (10)
+#define DEFLATE_HASH_SIZE (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_NO_POS (0xFFFF)
+#define DEFLATE_MAX_CHAIN (16)
+#define DEFLATE_MIN_MATCH (3)
+#define DEFLATE_MAX_MATCH (258)
+
+static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distBase[30]   = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distExtra[30]   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// LSB first bit writer, stops writing when output is full
+typedef struct {
+    uint8_t * out;
+    size_t size;
+    size_t pos;
+    uint32_t bits;
+    uint8_t count;
+    bool overflow;
+} deflate_writer_t;
+
+static void putBits(deflate_writer_t & w, uint32_t value, uint8_t count) {
+    w.bits |= (value << w.count);
+    w.count += count;
+    while(w.count >= 8) {
+        if(w.pos < w.size) {
+            w.out[w.pos++] = (w.bits & 0xFF);
+        } else {
+            w.overflow = true;
+        }
+        w.bits >>= 8;
+        w.count -= 8;
+    }
+}
+
+// huffman codes are stored MSB first
+static void putCode(deflate_writer_t & w, uint32_t code, uint8_t count) {
+    uint32_t reversed = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(w, reversed, count);
+}
+
+// fixed literal/length code (RFC 1951 3.2.6)
+static void putSymbol(deflate_writer_t & w, uint16_t symbol) {
+    if(symbol < 144) {
+        putCode(w, 0x30 + symbol, 8);
+    } else if(symbol < 256) {
+        putCode(w, 0x190 + (symbol - 144), 9);
+    } else if(symbol < 280) {
+        putCode(w, symbol - 256, 7);
+    } else {
+        putCode(w, 0xC0 + (symbol - 280), 8);
+    }
+}
+
+static void putMatch(deflate_writer_t & w, uint16_t length, uint16_t distance) {
+    uint8_t l = 28;
+    while(lengthBase[l] > length) {
+        l--;
+    }
+    putSymbol(w, 257 + l);
+    putBits(w, length - lengthBase[l], lengthExtra[l]);
+    uint8_t d = 29;
+    while(distBase[d] > distance) {
+        d--;
+    }
+    putCode(w, d, 5);
+    putBits(w, distance - distBase[d], distExtra[d]);
+}
+
+static inline uint16_t hash3(const uint8_t * p) {
+    return ((p[0] << 6) ^ (p[1] << 3) ^ p[2]) & (DEFLATE_HASH_SIZE - 1);
+}
+
+size_t WebSocketsDeflate::compress(uint8_t * history, uint16_t & historyLen, const uint8_t * in, size_t len, uint8_t * out, size_t outSize) {
+    if(!history) {
+        historyLen = 0;
+    }
+    if(len == 0 || len > WEBSOCKETS_DEFLATE_MAX_SIZE) {
+        return 0;
+    }
+    size_t total = historyLen + len;
+    // history and message must be contiguous for matching
+    // followed by hash tables, 16 bits aligned
+    size_t dataSize = (total + 1) & ~1;
+    uint8_t * data  = (uint8_t *)malloc(dataSize + (DEFLATE_HASH_SIZE + WEBSOCKETS_DEFLATE_WINDOW) * sizeof(uint16_t));
+    if(!data) {
+        return 0;
+    }
+    uint16_t * head = (uint16_t *)(data + dataSize);
+    uint16_t * prev = head + DEFLATE_HASH_SIZE;
+    memset(head, 0xFF, DEFLATE_HASH_SIZE * sizeof(uint16_t));
+    memcpy(data, history, historyLen);
+    memcpy(data + historyLen, in, len);
+
+    deflate_writer_t w = { out, outSize, 0, 0, 0, false };
+    // BFINAL 0, BTYPE 01 (fixed huffman)
+    putBits(w, 0, 1);
+    putBits(w, 1, 2);
+
+    size_t pos = 0;
+    // history is only used as dictionary
+    for(; pos < historyLen && pos + DEFLATE_MIN_MATCH <= total; pos++) {
+        uint16_t h                                  = hash3(&data[pos]);
+        prev[pos & (WEBSOCKETS_DEFLATE_WINDOW - 1)] = head[h];
+        head[h]                                     = pos;
+    }
+    pos = historyLen;
+    while(pos < total && !w.overflow) {
+        uint16_t bestLength   = 0;
+        uint16_t bestDistance = 0;
+        if(pos + DEFLATE_MIN_MATCH <= total) {
+            uint16_t h         = hash3(&data[pos]);
+            uint16_t candidate = head[h];
+            uint8_t chain      = DEFLATE_MAX_CHAIN;
+            size_t maxLength   = total - pos;
+            if(maxLength > DEFLATE_MAX_MATCH) {
+                maxLength = DEFLATE_MAX_MATCH;
+            }
+            while(candidate != DEFLATE_NO_POS && candidate < pos && (pos - candidate) <= WEBSOCKETS_DEFLATE_WINDOW && chain--) {
+                uint16_t l = 0;
+                while(l < maxLength && data[candidate + l] == data[pos + l]) {
+                    l++;
+                }
+                if(l > bestLength) {
+                    bestLength   = l;
+                    bestDistance = pos - candidate;
+                    if(l == maxLength) {
+                        break;
+                    }
+                }
+                uint16_t next = prev[candidate & (WEBSOCKETS_DEFLATE_WINDOW - 1)];
+                // slot reused by a newer position: end of chain
+                if(next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+        }
+        if(bestLength >= DEFLATE_MIN_MATCH) {
+            putMatch(w, bestLength, bestDistance);
+        } else {
+            bestLength = 1;
+            putSymbol(w, data[pos]);
+        }
+        for(uint16_t i = 0; i < bestLength; i++, pos++) {
+            if(pos + DEFLATE_MIN_MATCH <= total) {
+                uint16_t h                                  = hash3(&data[pos]);
+                prev[pos & (WEBSOCKETS_DEFLATE_WINDOW - 1)] = head[h];
+                head[h]                                     = pos;
+            }
+        }
+    }
+    // end of block, then empty stored block of sync flush: its 00 00 FF FF is not sent
+    putSymbol(w, 256);
+    putBits(w, 0, 3);
+    if(w.count > 0) {
+        putBits(w, 0, 8 - w.count);
+    }
+
+    size_t compressed = w.overflow ? 0 : w.pos;
+    if(compressed > 0 && history) {
+        // next messages can refer to this one
+        size_t keep = (total > WEBSOCKETS_DEFLATE_WINDOW) ? WEBSOCKETS_DEFLATE_WINDOW : total;
+        memcpy(history, data + total - keep, keep);
+        historyLen = keep;
+    }
+    free(data);
+    return compressed;
+}
+
+uint8_t * WebSocketsDeflate::inflate(const uint8_t * in, size_t len, size_t & outLen) {
+    // restore sync flush tail, then add an empty final block so stream is complete
+    static const uint8_t tail[] = { 0x00, 0x00, 0xFF, 0xFF, 0x03, 0x00 };
+    uint8_t * src                     = (uint8_t *)malloc(len + sizeof(tail));
+    tinfl_decompressor * decompressor = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+    uint8_t * out                     = (uint8_t *)malloc(WEBSOCKETS_DEFLATE_MAX_INFLATED + 1);
+    if(!src || !decompressor || !out) {
+        free(src);
+        free(decompressor);
+        free(out);
+        return NULL;
+    }
+    memcpy(src, in, len);
+    memcpy(src + len, tail, sizeof(tail));
+    size_t inSize  = len + sizeof(tail);
+    size_t outSize = WEBSOCKETS_DEFLATE_MAX_INFLATED;
+    tinfl_init(decompressor);
+    tinfl_status status = tinfl_decompress(decompressor, src, &inSize, out, out, &outSize, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    free(src);
+    free(decompressor);
+    if(status != TINFL_STATUS_DONE) {
+        DEBUG_WEBSOCKETS("[WS][inflate] failed: %d\n", status);
+        free(out);
+        return NULL;
+    }
+    out[outSize] = 0x00;
+    outLen       = outSize;
+    return out;
+}
+
+#endif /* WEBSOCKETS_DEFLATE */
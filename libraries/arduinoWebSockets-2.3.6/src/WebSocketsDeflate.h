@@ -0,0 +1,76 @@
+/**
+ * @file WebSocketsDeflate.h
+ * @date 17.10.2026
+ *
+ * This file is part of the WebSockets for Arduino.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef WEBSOCKETSDEFLATE_H_
+#define WEBSOCKETSDEFLATE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// permessage-deflate (RFC 7692) helpers
+// compression uses fixed huffman codes and a small LZ77 window,
+// so each client only needs WEBSOCKETS_DEFLATE_WINDOW bytes of history
+#ifndef WEBSOCKETS_DEFLATE_WINDOW_BITS
+#define WEBSOCKETS_DEFLATE_WINDOW_BITS (10)
+#endif
+#define WEBSOCKETS_DEFLATE_WINDOW (1 << WEBSOCKETS_DEFLATE_WINDOW_BITS)
+
+// smaller messages are not worth compressing
+#ifndef WEBSOCKETS_DEFLATE_MIN_SIZE
+#define WEBSOCKETS_DEFLATE_MIN_SIZE (16)
+#endif
+
+// bigger messages are sent uncompressed (positions are 16 bits)
+#ifndef WEBSOCKETS_DEFLATE_MAX_SIZE
+#define WEBSOCKETS_DEFLATE_MAX_SIZE (8 * 1024)
+#endif
+
+// max size of an inflated client message
+#ifndef WEBSOCKETS_DEFLATE_MAX_INFLATED
+#define WEBSOCKETS_DEFLATE_MAX_INFLATED (4 * 1024)
+#endif
+
+class WebSocketsDeflate {
+  public:
+    /**
+     * compress one message as a raw deflate block, sync flush tail removed
+     * @param history uint8_t *     last bytes sent to this client, updated if compression succeed (may be NULL)
+     * @param historyLen uint16_t & size of history
+     * @param in const uint8_t *    message
+     * @param len size_t            size of message
+     * @param out uint8_t *         output buffer
+     * @param outSize size_t        size of output buffer
+     * @return compressed size, 0 if message cannot be compressed in outSize bytes
+     */
+    static size_t compress(uint8_t * history, uint16_t & historyLen, const uint8_t * in, size_t len, uint8_t * out, size_t outSize);
+
+    /**
+     * inflate one client message compressed without context takeover
+     * @param in const uint8_t *    compressed message
+     * @param len size_t            size of compressed message
+     * @param outLen size_t &       size of inflated message
+     * @return malloc'ed buffer NUL terminated, NULL on error
+     */
+    static uint8_t * inflate(const uint8_t * in, size_t len, size_t & outLen);
+};
+
+#endif /* WEBSOCKETSDEFLATE_H_ */
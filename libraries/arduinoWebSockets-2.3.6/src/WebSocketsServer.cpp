@@ -24,6 +24,9 @@
 
 #include "WebSockets.h"
 #include "WebSocketsServer.h"
+#ifdef WEBSOCKETS_DEFLATE
+#include "WebSocketsDeflate.h"
+#endif
 
 WebSocketsServerCore::WebSocketsServerCore(const String & origin, const String & protocol) {
     _origin                 = origin;
@@ -38,6 +41,14 @@ WebSocketsServerCore::WebSocketsServerCore(const String & origin, const String &
     _httpHeaderValidationFunc = NULL;
     _mandatoryHttpHeaders     = NULL;
     _mandatoryHttpHeaderCount = 0;
+
+#ifdef WEBSOCKETS_DEFLATE
+    _deflate                = false;
+    _deflateContextTakeover = true;
+    _deflateInput           = 0;
+    _deflateOutput          = 0;
+    _deflateTime            = 0;
+#endif
 }
 
 WebSocketsServer::WebSocketsServer(uint16_t port, const String & origin, const String & protocol)
@@ -154,7 +165,7 @@ bool WebSocketsServerCore::sendTXT(uint8_t num, uint8_t * payload, size_t length
     }
     WSclient_t * client = &_clients[num];
     if(clientIsConnected(client)) {
-        return sendFrame(client, WSop_text, payload, length, true, headerToPayload);
+        return sendMessage(client, WSop_text, payload, length, headerToPayload);
     }
     return false;
 }
@@ -192,7 +203,7 @@ bool WebSocketsServerCore::broadcastTXT(uint8_t * payload, size_t length, bool h
     for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
         client = &_clients[i];
         if(clientIsConnected(client)) {
-            if(!sendFrame(client, WSop_text, payload, length, true, headerToPayload)) {
+            if(!sendMessage(client, WSop_text, payload, length, headerToPayload)) {
                 ret = false;
             }
         }
@@ -231,7 +242,7 @@ bool WebSocketsServerCore::sendBIN(uint8_t num, uint8_t * payload, size_t length
     }
     WSclient_t * client = &_clients[num];
     if(clientIsConnected(client)) {
-        return sendFrame(client, WSop_binary, payload, length, true, headerToPayload);
+        return sendMessage(client, WSop_binary, payload, length, headerToPayload);
     }
     return false;
 }
@@ -253,7 +264,7 @@ bool WebSocketsServerCore::broadcastBIN(uint8_t * payload, size_t length, bool h
     for(uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
         client = &_clients[i];
         if(clientIsConnected(client)) {
-            if(!sendFrame(client, WSop_binary, payload, length, true, headerToPayload)) {
+            if(!sendMessage(client, WSop_binary, payload, length, headerToPayload)) {
                 ret = false;
             }
         }
@@ -266,6 +277,87 @@ bool WebSocketsServerCore::broadcastBIN(const uint8_t * payload, size_t length)
     return broadcastBIN((uint8_t *)payload, length);
 }
 
+/**
+ * send a complete message, compressed if client negotiated permessage-deflate
+ * @param client WSclient_t *  ptr to the client struct
+ * @param opcode WSopcode_t
+ * @param payload uint8_t *
+ * @param length size_t
+ * @param headerToPayload bool  (see sendFrame for more details)
+ * @return true if ok
+ */
+bool WebSocketsServerCore::sendMessage(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool headerToPayload) {
+#ifdef WEBSOCKETS_DEFLATE
+    if(client->cDeflate && length >= WEBSOCKETS_DEFLATE_MIN_SIZE) {
+        uint8_t * data = payload + (headerToPayload ? WEBSOCKETS_MAX_HEADER_SIZE : 0);
+        // not worth it if it does not fit in the original size
+        uint8_t * compressed = (uint8_t *)malloc(WEBSOCKETS_MAX_HEADER_SIZE + length);
+        if(compressed) {
+            uint32_t start = micros();
+            size_t size    = WebSocketsDeflate::compress(client->cDeflateHistory, client->cDeflateHistoryLen, data, length, compressed + WEBSOCKETS_MAX_HEADER_SIZE, length - 1);
+            _deflateTime += micros() - start;
+            _deflateInput += length;
+            if(size > 0) {
+                _deflateOutput += size;
+                bool ret = sendFrame(client, opcode, compressed, size, true, true, true);
+                free(compressed);
+                return ret;
+            }
+            _deflateOutput += length;
+            free(compressed);
+        }
+    }
+#endif
+    return sendFrame(client, opcode, payload, length, true, headerToPayload);
+}
+
+#ifdef WEBSOCKETS_DEFLATE
+/**
+ * accept permessage-deflate offers of clients
+ * @param enable bool
+ * @param contextTakeover bool  keep history between messages: better ratio but WEBSOCKETS_DEFLATE_WINDOW bytes per client
+ */
+void WebSocketsServerCore::enableDeflate(bool enable, bool contextTakeover) {
+    _deflate                = enable;
+    _deflateContextTakeover = contextTakeover;
+}
+
+/**
+ * check client offer and build response header
+ * client messages are never compressed with context takeover, so they can be inflated alone
+ * @param client WSclient_t *  ptr to the client struct
+ * @return Sec-WebSocket-Extensions header line, empty if not negotiated
+ */
+String WebSocketsServerCore::negotiateDeflate(WSclient_t * client) {
+    String response;
+    client->cDeflate = false;
+    if(!_deflate || client->cExtensions.indexOf(WEBSOCKETS_STRING("permessage-deflate")) == -1) {
+        return response;
+    }
+    // compressor window is fixed, a client asking for a smaller one is declined
+    int bits = client->cExtensions.indexOf(WEBSOCKETS_STRING("server_max_window_bits="));
+    if(bits != -1 && client->cExtensions.substring(bits + 23).toInt() < WEBSOCKETS_DEFLATE_WINDOW_BITS) {
+        return response;
+    }
+    bool takeover = _deflateContextTakeover && (client->cExtensions.indexOf(WEBSOCKETS_STRING("server_no_context_takeover")) == -1);
+    if(takeover) {
+        client->cDeflateHistory = (uint8_t *)malloc(WEBSOCKETS_DEFLATE_WINDOW);
+        if(!client->cDeflateHistory) {
+            return response;
+        }
+    }
+    client->cDeflate           = true;
+    client->cDeflateHistoryLen = 0;
+    response                   = WEBSOCKETS_STRING("Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover; server_max_window_bits=");
+    response += String(WEBSOCKETS_DEFLATE_WINDOW_BITS);
+    if(!takeover) {
+        response += WEBSOCKETS_STRING("; server_no_context_takeover");
+    }
+    response += WEBSOCKETS_STRING("\r\n");
+    return response;
+}
+#endif
+
 /**
  * sends a WS ping to Client
  * @param num uint8_t client id
@@ -554,10 +646,25 @@ void WebSocketsServerCore::clientDisconnect(WSclient_t * client) {
     client->cUrl         = "";
     client->cKey         = "";
     client->cProtocol    = "";
+    client->cExtensions  = "";
     client->cVersion     = 0;
     client->cIsUpgrade   = false;
     client->cIsWebsocket = false;
 
+#ifdef WEBSOCKETS_DEFLATE
+    if(client->cDeflateHistory) {
+        free(client->cDeflateHistory);
+        client->cDeflateHistory = nullptr;
+    }
+    if(client->cDeflateRx) {
+        free(client->cDeflateRx);
+        client->cDeflateRx = nullptr;
+    }
+    client->cDeflate           = false;
+    client->cDeflateHistoryLen = 0;
+    client->cDeflateRxLen      = 0;
+#endif
+
     client->cWsRXsize = 0;
 
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC)
@@ -833,6 +940,10 @@ void WebSocketsServerCore::handleHeader(WSclient_t * client, String * headerLine
                 handshake += _protocol + NEW_LINE;
             }
 
+#ifdef WEBSOCKETS_DEFLATE
+            handshake += negotiateDeflate(client);
+#endif
+
             // header end
             handshake += NEW_LINE;
 
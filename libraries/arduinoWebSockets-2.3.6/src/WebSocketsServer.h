@@ -90,6 +90,20 @@ class WebSocketsServerCore : protected WebSockets {
     void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
     void disableHeartbeat();
 
+#ifdef WEBSOCKETS_DEFLATE
+    void enableDeflate(bool enable, bool contextTakeover = true);
+    // bytes of messages before / after compression and time spent compressing in us
+    uint32_t deflateInput(void) {
+        return _deflateInput;
+    }
+    uint32_t deflateOutput(void) {
+        return _deflateOutput;
+    }
+    uint32_t deflateTime(void) {
+        return _deflateTime;
+    }
+#endif
+
 #if(WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP8266_ASYNC) || (WEBSOCKETS_NETWORK_TYPE == NETWORK_ESP32)
     IPAddress remoteIP(uint8_t num);
 #endif
@@ -118,6 +132,18 @@ class WebSocketsServerCore : protected WebSockets {
     uint32_t _pongTimeout;
     uint8_t _disconnectTimeoutCount;
 
+#ifdef WEBSOCKETS_DEFLATE
+    bool _deflate;
+    bool _deflateContextTakeover;
+    uint32_t _deflateInput;
+    uint32_t _deflateOutput;
+    uint32_t _deflateTime;
+
+    String negotiateDeflate(WSclient_t * client);
+#endif
+
+    bool sendMessage(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool headerToPayload);
+
     void messageReceived(WSclient_t * client, WSopcode_t opcode, uint8_t * payload, size_t length, bool fin);
 
     void clientDisconnect(WSclient_t * client);